@@ -8,6 +8,10 @@
 #include <unistd.h>
 #include <time.h>
 #include <cinttypes>
+#if AP_REPLAY_MAPPED_LOG_ENABLED
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #ifndef PRIu64
 #define PRIu64 "llu"
@@ -19,24 +23,247 @@ AP_LoggerFileReader::AP_LoggerFileReader()
 AP_LoggerFileReader::~AP_LoggerFileReader()
 {
     ::printf("Replay counts: %" PRIu64 " bytes  %u entries\n", bytes_read, message_count);
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    delete decompressor;
+#endif
+#if AP_REPLAY_MAPPED_LOG_ENABLED
+    if (mapping != nullptr) {
+        munmap(mapping, mapping_len);
+    }
+    free(inflated);
+#endif
 }
 
 bool AP_LoggerFileReader::open_log(const char *logfile)
 {
+#if AP_REPLAY_MAPPED_LOG_ENABLED
+    // the log may already be in memory if we have forked replays
+    if (mem != nullptr || map_log(logfile)) {
+        return true;
+    }
+#endif
     fd = AP::FS().open(logfile, O_RDONLY);
     if (fd == -1) {
         return false;
     }
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    uint8_t header[AP_Logger_Compression::HEADER_LEN];
+    const ssize_t n = AP::FS().read(fd, header, sizeof(header));
+    if (n > 0 && AP_Logger_Compression::is_compressed_header(header, n)) {
+        ::printf("Reading compressed log\n");
+        if (decompressor == nullptr) {
+            decompressor = NEW_NOTHROW AP_Logger_Decompressor;
+            if (decompressor == nullptr) {
+                return false;
+            }
+        }
+        decompressor->reset();
+        zbuf_len = zbuf_ofs = 0;
+        zbuf_eof = false;
+        zmsg_len = zmsg_ofs = 0;
+    } else {
+        delete decompressor;
+        decompressor = nullptr;
+        AP::FS().lseek(fd, 0, SEEK_SET);
+    }
+#endif
     return true;
 }
 
+#if AP_REPLAY_MAPPED_LOG_ENABLED
+/*
+  bring the whole log into memory. Compressed logs are decompressed
+  here, once. The mapping is shared copy-on-write with any forked
+  replays
+ */
+bool AP_LoggerFileReader::map_log(const char *logfile)
+{
+    const int mfd = ::open(logfile, O_RDONLY|O_CLOEXEC);
+    if (mfd == -1) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(mfd, &st) != 0 || st.st_size == 0) {
+        ::close(mfd);
+        return false;
+    }
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, mfd, 0);
+    ::close(mfd);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    mapping = p;
+    mapping_len = st.st_size;
+    mem = (const uint8_t *)mapping;
+    mem_len = mapping_len;
+    mem_ofs = 0;
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    if (AP_Logger_Compression::is_compressed_header(mem, mem_len)) {
+        ::printf("Reading compressed log\n");
+        if (!inflate_log()) {
+            ::printf("Failed to decompress log\n");
+            munmap(mapping, mapping_len);
+            mapping = nullptr;
+            mem = nullptr;
+            return false;
+        }
+    }
+#endif
+
+    index_log();
+    return true;
+}
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+/*
+  decompress the mapped log into memory, replacing the mapping
+ */
+bool AP_LoggerFileReader::inflate_log(void)
+{
+    AP_Logger_Decompressor decoder;
+    decoder.reset();
+    size_t size = mapping_len * 4;
+    size_t len = 0;
+    uint8_t *buf = (uint8_t *)malloc(size);
+    size_t ofs = AP_Logger_Compression::HEADER_LEN;
+    while (buf != nullptr && ofs < mapping_len) {
+        if (size - len < 256) {
+            size *= 2;
+            uint8_t *newbuf = (uint8_t *)realloc(buf, size);
+            if (newbuf == nullptr) {
+                free(buf);
+                buf = nullptr;
+                break;
+            }
+            buf = newbuf;
+        }
+        uint8_t msg_len;
+        const int32_t used = decoder.decompress(&mem[ofs], mapping_len - ofs, &buf[len], msg_len);
+        if (used < 0) {
+            ::printf("corrupt compressed log at offset %lu\n", (unsigned long)ofs);
+        }
+        if (used <= 0) {
+            break;
+        }
+        ofs += used;
+        len += msg_len;
+    }
+    if (buf == nullptr) {
+        return false;
+    }
+    munmap(mapping, mapping_len);
+    mapping = nullptr;
+    inflated = buf;
+    mem = inflated;
+    mem_len = len;
+    return true;
+}
+#endif  // AP_LOGGER_FILE_COMPRESSION_ENABLED
+
+/*
+  walk the log once to count the messages and trim it to the last
+  complete message, so reads from memory need no further checks
+ */
+void AP_LoggerFileReader::index_log(void)
+{
+    uint8_t lengths[256] {};
+    lengths[LOG_FORMAT_MSG] = sizeof(struct log_Format);
+    size_t ofs = 0;
+    uint32_t count = 0;
+    while (ofs + LOG_PACKET_HEADER_LEN <= mem_len) {
+        const uint8_t *msg = &mem[ofs];
+        if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+            ::printf("bad log header at offset %lu\n", (unsigned long)ofs);
+            break;
+        }
+        const uint8_t length = lengths[msg[2]];
+        if (length == 0) {
+            ::printf("No format defined for type (%d)\n", msg[2]);
+            break;
+        }
+        if (ofs + length > mem_len) {
+            // truncated final message
+            break;
+        }
+        if (msg[2] == LOG_FORMAT_MSG) {
+            const struct log_Format &f = *(const struct log_Format *)msg;
+            lengths[f.type] = f.length;
+        }
+        ofs += length;
+        count++;
+    }
+    mem_len = ofs;
+    indexed_messages = count;
+    ::printf("Indexed %u messages in %lu bytes\n", (unsigned)count, (unsigned long)mem_len);
+}
+#endif  // AP_REPLAY_MAPPED_LOG_ENABLED
+
 ssize_t AP_LoggerFileReader::read_input(void *buffer, const size_t count)
 {
+#if AP_REPLAY_MAPPED_LOG_ENABLED
+    if (mem != nullptr) {
+        const size_t n = MIN(count, mem_len - mem_ofs);
+        memcpy(buffer, &mem[mem_ofs], n);
+        mem_ofs += n;
+        bytes_read += n;
+        return n;
+    }
+#endif
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    if (decompressor != nullptr) {
+        const ssize_t ret = read_compressed(buffer, count);
+        bytes_read += ret;
+        return ret;
+    }
+#endif
     uint64_t ret = AP::FS().read(fd, buffer, count);
     bytes_read += ret;
     return ret;
 }
 
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+/*
+  read from a compressed log, decoding a message at a time
+ */
+ssize_t AP_LoggerFileReader::read_compressed(void *buffer, const size_t count)
+{
+    uint8_t *out = (uint8_t *)buffer;
+    size_t ret = 0;
+    while (ret < count) {
+        if (zmsg_ofs == zmsg_len) {
+            // keep at least a whole record in the buffer
+            if (!zbuf_eof && zbuf_len - zbuf_ofs < AP_Logger_Compression::MAX_RECORD_LEN) {
+                memmove(zbuf, &zbuf[zbuf_ofs], zbuf_len - zbuf_ofs);
+                zbuf_len -= zbuf_ofs;
+                zbuf_ofs = 0;
+                const ssize_t n = AP::FS().read(fd, &zbuf[zbuf_len], sizeof(zbuf) - zbuf_len);
+                if (n <= 0) {
+                    zbuf_eof = true;
+                } else {
+                    zbuf_len += n;
+                }
+            }
+            const int32_t used = decompressor->decompress(&zbuf[zbuf_ofs], zbuf_len - zbuf_ofs, zmsg, zmsg_len);
+            if (used <= 0) {
+                if (used < 0) {
+                    ::printf("corrupt compressed log\n");
+                }
+                break;
+            }
+            zbuf_ofs += used;
+            zmsg_ofs = 0;
+        }
+        const size_t n = MIN(size_t(zmsg_len - zmsg_ofs), count - ret);
+        memcpy(&out[ret], &zmsg[zmsg_ofs], n);
+        zmsg_ofs += n;
+        ret += n;
+    }
+    return ret;
+}
+#endif  // AP_LOGGER_FILE_COMPRESSION_ENABLED
+
 void AP_LoggerFileReader::format_type(uint16_t type, char dest[5])
 {
     const struct log_Format &f = formats[type];
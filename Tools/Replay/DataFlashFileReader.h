@@ -1,9 +1,15 @@
 #pragma once
 
 #include <AP_Logger/AP_Logger.h>
+#include <AP_Logger/AP_Logger_Compression.h>
 
 #define LOGREADER_MAX_FORMATS 255 // must be >= highest MESSAGE
 
+// read logs from a memory mapping rather than a read() per message
+#ifndef AP_REPLAY_MAPPED_LOG_ENABLED
+#define AP_REPLAY_MAPPED_LOG_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
 class AP_LoggerFileReader
 {
 public:
@@ -20,6 +26,13 @@ public:
     void format_type(uint16_t type, char dest[5]);
     void get_packet_counts(uint64_t dest[]);
 
+    // number of messages processed so far
+    uint32_t get_message_count() const { return message_count; }
+#if AP_REPLAY_MAPPED_LOG_ENABLED
+    // number of complete messages found when the log was mapped
+    uint32_t get_indexed_message_count() const { return indexed_messages; }
+#endif
+
 protected:
     int fd = -1;
 
@@ -28,6 +41,35 @@ protected:
 private:
     ssize_t read_input(void *buf, size_t count);
 
+#if AP_REPLAY_MAPPED_LOG_ENABLED
+    // the whole log in memory, either mapped or decompressed
+    bool map_log(const char *logfile);
+    void index_log(void);
+    const uint8_t *mem = nullptr;
+    size_t mem_len;
+    size_t mem_ofs;
+    void *mapping = nullptr;
+    size_t mapping_len;
+    uint8_t *inflated = nullptr;
+    uint32_t indexed_messages;
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    bool inflate_log(void);
+#endif
+#endif
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    // state for reading logs written with LOG_FILE_CMPRS
+    AP_Logger_Decompressor *decompressor = nullptr;
+    ssize_t read_compressed(void *buf, size_t count);
+    uint8_t zbuf[4096];
+    uint32_t zbuf_len;
+    uint32_t zbuf_ofs;
+    bool zbuf_eof;
+    uint8_t zmsg[256];
+    uint8_t zmsg_len;
+    uint8_t zmsg_ofs;
+#endif
+
     uint64_t bytes_read = 0;
     uint32_t message_count = 0;
     uint64_t start_micros;
@@ -26,6 +26,7 @@
 #include <AP_Filesystem/AP_Filesystem.h>
 #include <AP_Filesystem/posix_compat.h>
 #include <AP_AdvancedFailsafe/AP_AdvancedFailsafe.h>
+#include <AP_Common/ExpandingString.h>
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
 #include <AP_HAL_Linux/Scheduler.h>
@@ -39,6 +40,15 @@ static ReplayVehicle replayvehicle;
 user_parameter *user_parameters;
 bool replay_force_ekf2;
 bool replay_force_ekf3;
+bool replay_ekf_profile;
+
+// limit on the average execution time of a profiled EKF3 function
+struct ekf_profile_limit {
+    struct ekf_profile_limit *next;
+    char name[21];
+    float max_avg_us;
+};
+static ekf_profile_limit *ekf_profile_limits;
 
 const AP_Param::Info ReplayVehicle::var_info[] = {
     GSCALAR(dummy,         "_DUMMY", 0),
@@ -130,11 +140,21 @@ void Replay::usage(void)
     ::printf("\t--param-file FILENAME  load parameters from a file\n");
     ::printf("\t--force-ekf2 force enable EKF2\n");
     ::printf("\t--force-ekf3 force enable EKF3\n");
+    ::printf("\t--ekf-profile print EKF3 function execution times at end of log\n");
+    ::printf("\t--ekf-profile-limit NAME=US  fail if EKF3 function NAME takes longer than US microseconds on average\n");
+#if AP_REPLAY_SWEEP_ENABLED
+    ::printf("\t--sweep FILENAME  replay once per line of NAME=VALUE parameters in FILENAME\n");
+    ::printf("\t--jobs N  number of sweep replays to run at once\n");
+#endif
 }
 
 enum param_key : uint8_t {
     FORCE_EKF2 = 1,
     FORCE_EKF3,
+    EKF_PROFILE,
+    EKF_PROFILE_LIMIT,
+    SWEEP,
+    JOBS,
 };
 
 void Replay::_parse_command_line(uint8_t argc, char * const argv[])
@@ -146,6 +166,12 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
         {"param-file",      true,   0, 'F'},
         {"force-ekf2",      false,  0, param_key::FORCE_EKF2},
         {"force-ekf3",      false,  0, param_key::FORCE_EKF3},
+        {"ekf-profile",     false,  0, param_key::EKF_PROFILE},
+        {"ekf-profile-limit", true, 0, param_key::EKF_PROFILE_LIMIT},
+#if AP_REPLAY_SWEEP_ENABLED
+        {"sweep",           true,   0, param_key::SWEEP},
+        {"jobs",            true,   0, param_key::JOBS},
+#endif
         {"help",            false,  0, 'h'},
         {0, false, 0, 0}
     };
@@ -181,6 +207,39 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
             replay_force_ekf3 = true;
             break;
 
+        case param_key::EKF_PROFILE:
+            replay_ekf_profile = true;
+            break;
+
+        case param_key::EKF_PROFILE_LIMIT: {
+            const char *eq = strchr(gopt.optarg, '=');
+            if (eq == NULL || size_t(eq-gopt.optarg) >= sizeof(ekf_profile_limit::name)) {
+                ::printf("Usage: --ekf-profile-limit NAME=US\n");
+                exit(1);
+            }
+            struct ekf_profile_limit *l = NEW_NOTHROW ekf_profile_limit;
+            if (l == nullptr) {
+                ::printf("Failed to allocate EKF profile limit\n");
+                exit(1);
+            }
+            strncpy(l->name, gopt.optarg, eq-gopt.optarg);
+            l->max_avg_us = atof(eq+1);
+            l->next = ekf_profile_limits;
+            ekf_profile_limits = l;
+            replay_ekf_profile = true;
+            break;
+        }
+
+#if AP_REPLAY_SWEEP_ENABLED
+        case param_key::SWEEP:
+            sweep_filename = gopt.optarg;
+            break;
+
+        case param_key::JOBS:
+            sweep_jobs = atoi(gopt.optarg);
+            break;
+#endif
+
         case 'h':
         default:
             usage();
@@ -209,6 +268,13 @@ void Replay::setup()
         _parse_command_line(argc, argv);
     }
 
+#if AP_REPLAY_SWEEP_ENABLED
+    if (sweep_filename != nullptr) {
+        // only the forked replays return from here
+        run_sweep();
+    }
+#endif
+
     _vehicle.setup();
 
     set_user_parameters();
@@ -243,7 +309,29 @@ void Replay::setup()
 
 void Replay::loop()
 {
-    if (!reader.update()) {
+    const bool more = reader.update();
+#if AP_REPLAY_SWEEP_ENABLED
+    if (sweep_result_fd != -1) {
+        if (!more) {
+            sweep_finish();
+        } else if (reader.get_message_count() % 100 == 0) {
+            sweep_sample_ekf();
+        }
+    }
+#endif
+    if (!more) {
+#if EK3_FEATURE_PROFILING
+        if (replay_ekf_profile) {
+            ExpandingString str;
+            _vehicle.ekf3.profile_report(str);
+            if (str.get_string() != nullptr) {
+                ::printf("%s", str.get_string());
+            }
+            if (!check_ekf_profile_limits()) {
+                exit(1);
+            }
+        }
+#endif
 #if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
     // If we don't tear down the threads then they continue to access
     // global state during object destruction.
@@ -253,6 +341,31 @@ void Replay::loop()
     }
 }
 
+#if EK3_FEATURE_PROFILING
+/*
+  check the EKF3 profile against the --ekf-profile-limit options, so a
+  replay can be used to catch changes which slow down the filter.
+  Returns false if any function is over its limit or was not called
+ */
+bool Replay::check_ekf_profile_limits(void)
+{
+    bool ok = true;
+    for (const struct ekf_profile_limit *l=ekf_profile_limits; l; l=l->next) {
+        float avg_us;
+        if (!_vehicle.ekf3.profile_average_us(l->name, avg_us)) {
+            ::printf("EKF3 profile: %s was not called\n", l->name);
+            ok = false;
+            continue;
+        }
+        const bool pass = avg_us <= l->max_avg_us;
+        ::printf("EKF3 profile: %s average %.2fus limit %.2fus %s\n",
+                 l->name, double(avg_us), double(l->max_avg_us), pass ? "PASS" : "FAIL");
+        ok = ok && pass;
+    }
+    return ok;
+}
+#endif
+
 /*
   setup user -p parameters
  */
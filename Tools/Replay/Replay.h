@@ -19,8 +19,15 @@
 
 #include "LogReader.h"
 
+#include <sys/types.h>
+
 #define AP_PARAM_VEHICLE_NAME replayvehicle
 
+// run several replays of one log at once with different parameters
+#ifndef AP_REPLAY_SWEEP_ENABLED
+#define AP_REPLAY_SWEEP_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL) && AP_REPLAY_MAPPED_LOG_ENABLED
+#endif
+
 struct user_parameter {
     struct user_parameter *next;
     char name[17];
@@ -107,4 +114,54 @@ private:
     bool parse_param_line(char *line, char **vname, float &value);
     void load_param_file(const char *filename);
     void usage();
+
+#if EK3_FEATURE_PROFILING
+    // check the EKF3 profile against the --ekf-profile-limit options
+    bool check_ekf_profile_limits(void);
+#endif
+
+#if AP_REPLAY_SWEEP_ENABLED
+    // mean and maximum of an EKF test ratio over a replay
+    struct SweepStat {
+        float sum;
+        float max;
+        void add(float v) {
+            sum += v;
+            max = MAX(max, v);
+        }
+    };
+
+    // passed from each forked replay to the parent over a pipe
+    struct SweepResult {
+        uint32_t messages;
+        uint32_t samples;
+        float run_time_s;
+        uint8_t ekf_type;
+        SweepStat vel, pos, hgt, mag;
+    };
+
+    struct SweepRun {
+        SweepRun *next;
+        char params[200];
+        pid_t pid;
+        int fd;
+        bool have_result;
+        SweepResult result;
+    };
+
+    const char *sweep_filename;
+    uint16_t sweep_jobs;
+
+    // in a forked replay, the pipe to the parent
+    int sweep_result_fd = -1;
+    SweepResult sweep_result;
+    uint64_t sweep_start_us;
+
+    SweepRun *load_sweep_file(uint16_t &count);
+    void run_sweep(void);
+    void start_sweep_child(SweepRun &run, uint16_t index, int fd);
+    void sweep_sample_ekf(void);
+    void sweep_finish(void);
+    void sweep_report(const SweepRun *runs, uint16_t count, float run_time_s) const;
+#endif
 };
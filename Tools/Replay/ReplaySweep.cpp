@@ -0,0 +1,311 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  parameter sweeps: replay one log several times at once, each with
+  its own set of parameters, and report the EKF results side by side.
+
+  The log is read into memory once and each replay is a forked copy of
+  this process, so the replays share the log but none of the global
+  state of the vehicle libraries. Each replay runs in
+  replay_sweep/runNNN, which holds its output log and console output.
+ */
+
+#include "Replay.h"
+
+#if AP_REPLAY_SWEEP_ENABLED
+
+#include <AP_Filesystem/AP_Filesystem.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SWEEP_DIRECTORY "replay_sweep"
+
+static uint64_t sweep_wall_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec)*1000000ULL + ts.tv_nsec/1000U;
+}
+
+/*
+  load the sweep file; each line that is not blank or a comment is
+  one replay
+ */
+Replay::SweepRun *Replay::load_sweep_file(uint16_t &count)
+{
+    auto &fs = AP::FS();
+    int fd = fs.open(sweep_filename, O_RDONLY, true);
+    if (fd == -1) {
+        ::printf("Failed to open sweep file: %s\n", sweep_filename);
+        exit(1);
+    }
+    SweepRun *runs = nullptr;
+    SweepRun **tail = &runs;
+    count = 0;
+    char line[sizeof(SweepRun::params)];
+    uint16_t line_num = 0;
+    while (fs.fgets(line, sizeof(line)-1, fd)) {
+        line_num++;
+        // fgets strips the newline, so a line which fills the buffer
+        // did not end within it and the rest would be read as another
+        // line
+        if (strlen(line) >= sizeof(line)-1) {
+            ::printf("Sweep file line %u is too long, the limit is %u characters\n",
+                     unsigned(line_num), unsigned(sizeof(line)-2));
+            exit(1);
+        }
+        char *p = line;
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        if (*p == '#' || *p == '\r' || *p == '\n' || *p == 0) {
+            continue;
+        }
+        SweepRun *run = NEW_NOTHROW SweepRun;
+        if (run == nullptr) {
+            break;
+        }
+        strncpy_noterm(run->params, p, sizeof(run->params)-1);
+        run->params[strcspn(run->params, "\r\n")] = 0;
+        run->fd = -1;
+        *tail = run;
+        tail = &run->next;
+        count++;
+    }
+    fs.close(fd);
+    return runs;
+}
+
+/*
+  fork the replays, at most sweep_jobs at a time, and collect their
+  results. Returns only in the forked replays
+ */
+void Replay::run_sweep(void)
+{
+    uint16_t count;
+    SweepRun *runs = load_sweep_file(count);
+    if (count == 0) {
+        ::printf("No replays in sweep file %s\n", sweep_filename);
+        exit(1);
+    }
+    if (filename == nullptr) {
+        ::printf("You must supply a log filename\n");
+        exit(1);
+    }
+    // read the log once, here; the replays share the memory
+    if (!reader.open_log(filename)) {
+        ::printf("open(%s): %m\n", filename);
+        exit(1);
+    }
+    if (mkdir(SWEEP_DIRECTORY, 0755) != 0 && errno != EEXIST) {
+        ::printf("mkdir(%s): %m\n", SWEEP_DIRECTORY);
+        exit(1);
+    }
+
+    uint16_t jobs = sweep_jobs;
+    if (jobs == 0) {
+        jobs = MAX(sysconf(_SC_NPROCESSORS_ONLN), 1L);
+    }
+    ::printf("Running %u replays, %u at a time\n", unsigned(count), unsigned(jobs));
+    fflush(stdout);
+
+    const uint64_t start_us = sweep_wall_us();
+    SweepRun *next_run = runs;
+    uint16_t next_index = 0;
+    uint16_t running = 0;
+    while (next_run != nullptr || running > 0) {
+        while (next_run != nullptr && running < jobs) {
+            int fds[2];
+            if (pipe(fds) != 0) {
+                ::printf("pipe: %m\n");
+                exit(1);
+            }
+            const pid_t pid = fork();
+            if (pid == -1) {
+                ::printf("fork: %m\n");
+                exit(1);
+            }
+            if (pid == 0) {
+                ::close(fds[0]);
+                start_sweep_child(*next_run, next_index, fds[1]);
+                return;
+            }
+            ::close(fds[1]);
+            next_run->pid = pid;
+            next_run->fd = fds[0];
+            next_run = next_run->next;
+            next_index++;
+            running++;
+        }
+
+        int status;
+        const pid_t pid = waitpid(-1, &status, 0);
+        if (pid == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        for (SweepRun *run = runs; run != nullptr; run = run->next) {
+            if (run->pid != pid || run->fd == -1) {
+                continue;
+            }
+            // the result is small enough to sit in the pipe after exit
+            run->have_result = ::read(run->fd, &run->result, sizeof(run->result)) == sizeof(run->result);
+            ::close(run->fd);
+            run->fd = -1;
+            running--;
+            break;
+        }
+    }
+
+    sweep_report(runs, count, (sweep_wall_us() - start_us)*1.0e-6);
+    exit(0);
+}
+
+/*
+  become one replay of the sweep
+ */
+void Replay::start_sweep_child(SweepRun &run, uint16_t index, int fd)
+{
+    char dir[40];
+    snprintf(dir, sizeof(dir), SWEEP_DIRECTORY "/run%03u", unsigned(index));
+    if ((mkdir(dir, 0755) != 0 && errno != EEXIST) || chdir(dir) != 0) {
+        ::printf("Failed to create %s: %m\n", dir);
+        exit(1);
+    }
+    if (freopen("replay.txt", "w", stdout) == nullptr) {
+        exit(1);
+    }
+    ::printf("Sweep parameters: %s\n", run.params);
+
+    // parameters for this replay override any given on the command line
+    char params[sizeof(run.params)];
+    strncpy_noterm(params, run.params, sizeof(params));
+    char *saveptr = nullptr;
+    for (char *tok = strtok_r(params, " \t", &saveptr); tok != nullptr; tok = strtok_r(nullptr, " \t", &saveptr)) {
+        const char *eq = strchr(tok, '=');
+        if (eq == nullptr || eq == tok || size_t(eq - tok) > AP_MAX_NAME_SIZE) {
+            ::printf("Bad sweep parameter %s\n", tok);
+            exit(1);
+        }
+        struct user_parameter *u = NEW_NOTHROW user_parameter;
+        if (u == nullptr) {
+            exit(1);
+        }
+        strncpy(u->name, tok, eq-tok);
+        u->value = atof(eq+1);
+        u->next = user_parameters;
+        user_parameters = u;
+    }
+
+    sweep_result_fd = fd;
+    sweep_start_us = sweep_wall_us();
+}
+
+/*
+  accumulate the EKF test ratios of the primary core
+ */
+void Replay::sweep_sample_ekf(void)
+{
+    float velVar, posVar, hgtVar, tasVar;
+    Vector3f magVar;
+    Vector2f offset;
+    bool ok = false;
+    if (_vehicle.ekf3.activeCores() > 0) {
+        ok = _vehicle.ekf3.getVariances(velVar, posVar, hgtVar, magVar, tasVar, offset);
+        sweep_result.ekf_type = 3;
+    } else if (_vehicle.ekf2.activeCores() > 0) {
+        ok = _vehicle.ekf2.getVariances(velVar, posVar, hgtVar, magVar, tasVar, offset);
+        sweep_result.ekf_type = 2;
+    }
+    if (!ok) {
+        return;
+    }
+    sweep_result.samples++;
+    sweep_result.vel.add(velVar);
+    sweep_result.pos.add(posVar);
+    sweep_result.hgt.add(hgtVar);
+    sweep_result.mag.add(magVar.length());
+}
+
+/*
+  pass the result of this replay back to the parent
+ */
+void Replay::sweep_finish(void)
+{
+    sweep_result.messages = reader.get_message_count();
+    sweep_result.run_time_s = (sweep_wall_us() - sweep_start_us)*1.0e-6;
+    if (::write(sweep_result_fd, &sweep_result, sizeof(sweep_result)) != sizeof(sweep_result)) {
+        ::printf("Failed to send sweep result\n");
+    }
+    ::close(sweep_result_fd);
+    sweep_result_fd = -1;
+}
+
+/*
+  print the results of all replays, and write them as CSV for
+  further processing
+ */
+void Replay::sweep_report(const SweepRun *runs, uint16_t count, float run_time_s) const
+{
+    FILE *csv = fopen(SWEEP_DIRECTORY "/report.csv", "w");
+    if (csv != nullptr) {
+        fprintf(csv, "run,time_s,messages,ekf,vel_mean,vel_max,pos_mean,pos_max,hgt_mean,hgt_max,mag_mean,mag_max,params\n");
+    }
+
+    ::printf("\nSweep of %s: %u replays of %u messages in %.1fs\n",
+             filename, unsigned(count), unsigned(reader.get_indexed_message_count()), run_time_s);
+    ::printf("%-4s %7s %4s %15s %15s %15s %15s  %s\n",
+             "run", "time(s)", "ekf", "vel mean/max", "pos mean/max", "hgt mean/max", "mag mean/max", "parameters");
+
+    uint16_t index = 0;
+    for (const SweepRun *run = runs; run != nullptr; run = run->next, index++) {
+        const SweepResult &r = run->result;
+        if (!run->have_result) {
+            ::printf("%-4u failed, see " SWEEP_DIRECTORY "/run%03u/replay.txt  %s\n",
+                     unsigned(index), unsigned(index), run->params);
+            continue;
+        }
+        const float n = MAX(r.samples, 1U);
+        ::printf("%-4u %7.1f %4u %7.3f/%-7.3f %7.3f/%-7.3f %7.3f/%-7.3f %7.3f/%-7.3f  %s\n",
+                 unsigned(index), r.run_time_s, unsigned(r.ekf_type),
+                 r.vel.sum/n, r.vel.max,
+                 r.pos.sum/n, r.pos.max,
+                 r.hgt.sum/n, r.hgt.max,
+                 r.mag.sum/n, r.mag.max,
+                 run->params);
+        if (csv != nullptr) {
+            fprintf(csv, "%u,%.2f,%u,%u,%f,%f,%f,%f,%f,%f,%f,%f,\"%s\"\n",
+                    unsigned(index), r.run_time_s, unsigned(r.messages), unsigned(r.ekf_type),
+                    r.vel.sum/n, r.vel.max,
+                    r.pos.sum/n, r.pos.max,
+                    r.hgt.sum/n, r.hgt.max,
+                    r.mag.sum/n, r.mag.max,
+                    run->params);
+        }
+    }
+    if (csv != nullptr) {
+        fclose(csv);
+        ::printf("Report written to " SWEEP_DIRECTORY "/report.csv\n");
+    }
+}
+
+#endif  // AP_REPLAY_SWEEP_ENABLED
@@ -6904,6 +6904,7 @@ class AutoTestPlane(vehicle_test_suite.TestSuite):
             self.ForcedDCM,
             self.DCMFallback,
             self.MAVFTP,
+            self.MAVFTPThroughput,
             self.AUTOTUNE,
             self.AutotuneFiltering,
             self.MegaSquirt,
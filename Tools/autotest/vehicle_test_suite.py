@@ -14443,6 +14443,33 @@ switch value'''
         if ex is not None:
             raise ex
 
+    def MAVFTPThroughput(self):
+        '''measure MAVFTP download rate of a large file from the posix filesystem'''
+        filename = "mavftp-throughput.txt"
+        # text content as fetch_file_via_ftp reads the result as text
+        line = "".join(["%x" % (i % 16) for i in range(127)]) + "\n"
+        content = line * (2 * 1024 * 1024 // len(line))
+        with open(filename, "w") as f:
+            f.write(content)
+        try:
+            tstart = time.time()
+            fetched = self.fetch_file_via_ftp(filename, timeout=300)
+            elapsed = time.time() - tstart
+        finally:
+            os.unlink(filename)
+        if fetched != content:
+            raise NotAchievedException("Fetched content differs (%u bytes, want %u)" %
+                                       (len(fetched), len(content)))
+        rate = len(content) / elapsed
+        self.progress("Fetched %u bytes in %.1fs (%.0f bytes/s)" %
+                      (len(content), elapsed, rate))
+        # well below what bursts served from the read buffer achieve,
+        # including MAVProxy startup, so only a slow read path fails
+        min_rate = 20000
+        if rate < min_rate:
+            raise NotAchievedException("MAVFTP throughput %.0f bytes/s below %u bytes/s" %
+                                       (rate, min_rate))
+
     def write_content_to_filepath(self, content, filepath):
         '''write biunary content to filepath'''
         with open(filepath, "wb") as f:
@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+
+'''
+decompress a log written with LOG_FILE_CMPRS enabled back into a
+normal .BIN log
+
+see libraries/AP_Logger/AP_Logger_Compression.h for the format
+
+AP_FLAKE8_CLEAN
+'''
+
+import argparse
+import sys
+
+HEADER = b'APLZ\x01'
+HEAD_BYTE1 = 0xA3
+HEAD_BYTE2 = 0x95
+HEADER_LEN = 3
+LOG_FORMAT_MSG = 128
+FORMAT_LEN = 89
+TOKEN_ZERO_RUN = 0x80
+TOKEN_KEYFRAME = 0xFF
+
+
+class CorruptLog(Exception):
+    pass
+
+
+def learn_format(lengths, prev, fmt_type, fmt_len):
+    '''record the length of a message type from its FMT, ignoring lengths
+    too short to hold the header like the compressor does'''
+    if fmt_len < HEADER_LEN or lengths.get(fmt_type) == fmt_len:
+        return
+    # the previous body no longer matches the message layout
+    lengths[fmt_type] = fmt_len
+    prev.pop(fmt_type, None)
+
+
+def decompress(data):
+    if not data.startswith(HEADER):
+        raise CorruptLog("not a compressed log")
+    lengths = {LOG_FORMAT_MSG: FORMAT_LEN}
+    prev = {}
+    out = bytearray()
+    ofs = len(HEADER)
+    while ofs < len(data):
+        mtype = data[ofs]
+        ofs += 1
+        if mtype not in lengths:
+            raise CorruptLog("no FMT for type %u at offset %u" % (mtype, ofs-1))
+        body_len = lengths[mtype] - HEADER_LEN
+        keyframe = False
+        if body_len > 0 and ofs < len(data) and data[ofs] == TOKEN_KEYFRAME:
+            keyframe = True
+            ofs += 1
+        body = bytearray()
+        while len(body) < body_len:
+            if ofs >= len(data):
+                # truncated final record
+                return out
+            token = data[ofs]
+            ofs += 1
+            if token == TOKEN_KEYFRAME:
+                raise CorruptLog("misplaced keyframe at offset %u" % (ofs-1))
+            if token >= TOKEN_ZERO_RUN:
+                body.extend(bytes(token - TOKEN_ZERO_RUN + 2))
+            else:
+                body.extend(data[ofs:ofs+token+1])
+                ofs += token + 1
+        if len(body) != body_len:
+            raise CorruptLog("bad record length at offset %u" % ofs)
+        if keyframe or mtype not in prev:
+            prev[mtype] = bytes(body_len)
+        body = bytes(a ^ b for a, b in zip(body, prev[mtype]))
+        prev[mtype] = body
+        out.extend(bytes([HEAD_BYTE1, HEAD_BYTE2, mtype]))
+        out.extend(body)
+        if mtype == LOG_FORMAT_MSG:
+            learn_format(lengths, prev, body[0], body[1])
+    return out
+
+
+parser = argparse.ArgumentParser(description='decompress a log written with LOG_FILE_CMPRS enabled')
+parser.add_argument('infile', help='compressed log')
+parser.add_argument('outfile', help='decompressed .BIN log to write')
+args = parser.parse_args()
+
+with open(args.infile, 'rb') as f:
+    indata = f.read()
+try:
+    outdata = decompress(indata)
+except CorruptLog as ex:
+    print("%s: %s" % (args.infile, ex))
+    sys.exit(1)
+with open(args.outfile, 'wb') as f:
+    f.write(outdata)
+print("%u bytes -> %u bytes" % (len(indata), len(outdata)))
@@ -876,7 +876,7 @@ void AC_Avoid::adjust_velocity_inclusion_and_exclusion_polygons(float kP, float
         const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
         Vector2f backup_vel_inc;
         // adjust velocity
-        adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, backup_vel_inc, boundary, num_points, fence->get_margin(), dt, true);
+        adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, backup_vel_inc, boundary, num_points, fence->get_margin(), dt, true, fence->polyfence().get_inclusion_polygon_index(i));
         find_max_quadrant_velocity(backup_vel_inc, quad_1_back_vel, quad_2_back_vel, quad_3_back_vel, quad_4_back_vel);
     }
 
@@ -887,7 +887,7 @@ void AC_Avoid::adjust_velocity_inclusion_and_exclusion_polygons(float kP, float
         const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
         Vector2f backup_vel_exc;
         // adjust velocity
-        adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, backup_vel_exc, boundary, num_points, fence->get_margin(), dt, false);
+        adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, backup_vel_exc, boundary, num_points, fence->get_margin(), dt, false, fence->polyfence().get_exclusion_polygon_index(i));
         find_max_quadrant_velocity(backup_vel_exc, quad_1_back_vel, quad_2_back_vel, quad_3_back_vel, quad_4_back_vel);
     }
     // desired backup velocity is sum of maximum velocity component in each quadrant 
@@ -1204,7 +1204,17 @@ void AC_Avoid::adjust_velocity_proximity(float kP, float accel_cmss, Vector3f &d
 
     AP_Proximity &_proximity = *proximity;
     // get total number of obstacles
-    const uint8_t obstacle_num = _proximity.get_obstacle_count();
+    const uint16_t boundary_obstacle_num = _proximity.get_obstacle_count();
+#if AP_PROXIMITY_GRID_ENABLED
+    // the high resolution grid's obstacles follow the boundary's. The
+    // boundary is still used as sensors with a few narrow beams fill
+    // the faces between them, which the grid does not
+    const AP_Proximity_Grid &grid = _proximity.grid;
+    const bool use_grid = grid.enabled();
+    const uint16_t obstacle_num = boundary_obstacle_num + (use_grid ? grid.get_obstacle_count() : 0);
+#else
+    const uint16_t obstacle_num = boundary_obstacle_num;
+#endif
     if (obstacle_num == 0) {
         // no obstacles
         return;
@@ -1233,9 +1243,29 @@ void AC_Avoid::adjust_velocity_proximity(float kP, float accel_cmss, Vector3f &d
         stopping_point_plus_margin = safe_vel * ((2.0f + margin_cm + get_stopping_distance(kP, accel_cmss, speed))/speed);
     }
 
-    for (uint8_t i = 0; i<obstacle_num; i++) {
+#if AP_PROXIMITY_GRID_ENABLED
+    // grid obstacles further away than the vehicle can stop within,
+    // with plenty to spare, cannot limit its velocity so are skipped
+    // without further calculation
+    float grid_dist_max_cm = margin_cm;
+    if (use_grid && !desired_vel_cms.is_zero()) {
+        const float speed = safe_vel.length();
+        grid_dist_max_cm += 2.0f * MAX(get_stopping_distance(kP, accel_cmss, speed), get_stopping_distance(kP_z, accel_cmss_z, speed)) + 100.0f;
+    }
+#endif
+
+    for (uint16_t i = 0; i<obstacle_num; i++) {
         // get obstacle from proximity library
         Vector3f vector_to_obstacle;
+#if AP_PROXIMITY_GRID_ENABLED
+        const bool grid_obstacle = i >= boundary_obstacle_num;
+        if (grid_obstacle) {
+            if (!grid.get_obstacle(i - boundary_obstacle_num, grid_dist_max_cm, vector_to_obstacle)) {
+                // empty cell or too far away to matter
+                continue;
+            }
+        } else
+#endif
         if (!_proximity.get_obstacle(i, vector_to_obstacle)) {
             // this one is not valid
             continue;
@@ -1287,7 +1317,17 @@ void AC_Avoid::adjust_velocity_proximity(float kP, float accel_cmss, Vector3f &d
             Vector3f limit_direction;
             // find closest point with line segment
             // also see if the vehicle will "roughly" intersect the boundary with the projected stopping point
-            const bool intersect = _proximity.closest_point_from_segment_to_obstacle(i, Vector3f{}, stopping_point_plus_margin, limit_direction);
+            bool intersect;
+#if AP_PROXIMITY_GRID_ENABLED
+            if (grid_obstacle) {
+                // grid obstacles are points, the vehicle intersects the plane through the point normal to the vector to it
+                limit_direction = vector_to_obstacle;
+                intersect = Vector3f::segment_plane_intersect(Vector3f{}, stopping_point_plus_margin, vector_to_obstacle, vector_to_obstacle);
+            } else
+#endif
+            {
+                intersect = _proximity.closest_point_from_segment_to_obstacle(i, Vector3f{}, stopping_point_plus_margin, limit_direction);
+            }
             if (intersect) {
                 // the vehicle is intersecting the plane formed by the boundary
                 // distance to the closest point from the stopping point
@@ -1333,7 +1373,7 @@ void AC_Avoid::adjust_velocity_proximity(float kP, float accel_cmss, Vector3f &d
 /*
  * Adjusts the desired velocity for the polygon fence.
  */
-void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &desired_vel_cms, Vector2f &backup_vel, const Vector2f* boundary, uint16_t num_points, float margin, float dt, bool stay_inside)
+void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &desired_vel_cms, Vector2f &backup_vel, const Vector2f* boundary, uint16_t num_points, float margin, float dt, bool stay_inside, const Polygon_index<float> *index)
 {
     // exit if there are no points
     if (boundary == nullptr || num_points == 0) {
@@ -1353,7 +1393,7 @@ void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &des
 
 
     // return if we have already breached polygon
-    const bool inside_polygon = !Polygon_outside(position_xy, boundary, num_points);
+    const bool inside_polygon = (index != nullptr) ? !index->outside(position_xy) : !Polygon_outside(position_xy, boundary, num_points);
     if (inside_polygon != stay_inside) {
         return;
     }
@@ -1369,15 +1409,40 @@ void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &des
 
     // for stopping
     const float speed = safe_vel.length();
+    const float stopping_distance = get_stopping_distance(kP, accel_cmss, speed);
     Vector2f stopping_point_plus_margin; 
     if (!desired_vel_cms.is_zero()) {
-        stopping_point_plus_margin = position_xy + safe_vel*((2.0f + margin_cm + get_stopping_distance(kP, accel_cmss, speed))/speed);
+        stopping_point_plus_margin = position_xy + safe_vel*((2.0f + margin_cm + stopping_distance)/speed);
+    }
+
+    // with an index only the edges which could change the velocity
+    // need to be checked: those within the margin, those the
+    // stopping point crosses, and those close enough to slow the
+    // vehicle when sliding. Edges are checked in the same order
+    Polygon_index<float>::EdgeMask edges;
+    if (index != nullptr) {
+        float range_cm = margin_cm;
+        if (!desired_vel_cms.is_zero()) {
+            if (!is_positive(accel_cmss)) {
+                // any edge may limit the velocity
+                range_cm = FLT_MAX;
+            } else if (_behavior == BEHAVIOR_SLIDE) {
+                range_cm += MAX(stopping_distance, speed * dt) * 1.1f;
+            } else {
+                range_cm = MAX(range_cm, 2.0f + margin_cm + stopping_distance);
+            }
+        }
+        range_cm += 1.0f;
+        index->edges_in_box(position_xy - Vector2f{range_cm, range_cm}, position_xy + Vector2f{range_cm, range_cm}, edges);
     }
 
     // for backing away
     Vector2f quad_1_back_vel, quad_2_back_vel, quad_3_back_vel, quad_4_back_vel;
    
     for (uint16_t i=0; i<num_points; i++) {
+        if (index != nullptr && !edges.get(i)) {
+            continue;
+        }
         uint16_t j = i+1;
         if (j >= num_points) {
             j = 0;
@@ -5,6 +5,7 @@
 #include "AC_Avoid.h"
 #include "AP_OADijkstra.h"
 #include "AP_OABendyRuler.h"
+#include "AP_OADatabase.h"
 #include <AP_Logger/AP_Logger.h>
 #include <AP_AHRS/AP_AHRS.h>
 
@@ -89,4 +90,35 @@ void AC_Avoid::Write_SimpleAvoidance(const uint8_t state, const Vector3f& desire
 }
 #endif
 
+#if AP_OADATABASE_ENABLED
+void AP_OADatabase::Write_OADatabase()
+{
+    uint32_t pushed, queue_full;
+    {
+        // these are counted by the threads pushing into the queue
+        WITH_SEMAPHORE(_queue.sem);
+        pushed = _stats.pushed;
+        queue_full = _stats.queue_full;
+        _stats.pushed = 0;
+        _stats.queue_full = 0;
+    }
+    const struct log_OADatabase pkt{
+        LOG_PACKET_HEADER_INIT(LOG_OA_DATABASE_MSG),
+        time_us         : AP_HAL::micros64(),
+        count           : _database.count,
+        pushed          : pushed,
+        queue_full      : queue_full,
+        added           : _stats.added,
+        refreshed       : _stats.refreshed,
+        database_full   : _stats.database_full,
+        expired         : _stats.expired,
+    };
+    AP::logger().WriteBlock(&pkt, sizeof(pkt));
+    _stats.added = 0;
+    _stats.refreshed = 0;
+    _stats.database_full = 0;
+    _stats.expired = 0;
+}
+#endif
+
 #endif  // HAL_LOGGING_ENABLED
@@ -19,6 +19,10 @@
 #define AP_OAPATHPLANNER_BENDYRULER_ENABLED AP_OAPATHPLANNER_BACKEND_DEFAULT_ENABLED
 #endif
 
+#ifndef AP_OABENDYRULER_WORKER_ENABLED
+#define AP_OABENDYRULER_WORKER_ENABLED AP_OAPATHPLANNER_BENDYRULER_ENABLED && (CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL)
+#endif
+
 #ifndef AP_OAPATHPLANNER_DIJKSTRA_ENABLED
 #define AP_OAPATHPLANNER_DIJKSTRA_ENABLED AP_OAPATHPLANNER_BACKEND_DEFAULT_ENABLED
 #endif
@@ -22,6 +22,7 @@
 #include <AC_Fence/AC_Fence.h>
 #include <AP_AHRS/AP_AHRS.h>
 #include <AP_Logger/AP_Logger.h>
+#include <AP_Proximity/AP_Proximity.h>
 #include <AP_Vehicle/AP_Vehicle_Type.h>
 
 // parameter defaults
@@ -39,6 +40,25 @@ const float OA_BENDYRULER_LOW_SPEED_SQUARED = (0.2f * 0.2f);    // when ground c
 
 #define VERTICAL_ENABLED APM_BUILD_COPTER_OR_HELI
 
+// number of horizontal candidate paths, the bearing to the destination
+// then alternating left and right of it out to 170 degrees
+const uint8_t OA_BENDYRULER_XY_CANDIDATES = 1 + 2 * (170 / OA_BENDYRULER_BEARING_INC_XY);
+
+#if AP_OABENDYRULER_WORKER_ENABLED
+#define OA_BENDYRULER_WORKER_STACK_SIZE 4096
+#endif
+
+extern const AP_HAL::HAL& hal;
+
+// bearing of horizontal candidate path k. 0 is towards the destination,
+// odd numbers are to the left and even numbers to the right
+static float xy_candidate_bearing(float bearing_to_dest, uint8_t k)
+{
+    const uint8_t i = (k + 1) / 2;
+    const float bearing_delta = i * OA_BENDYRULER_BEARING_INC_XY * ((k & 1) ? -1.0f : 1.0f);
+    return wrap_180(bearing_to_dest + bearing_delta);
+}
+
 const AP_Param::GroupInfo AP_OABendyRuler::var_info[] = {
 
     // @Param: LOOKAHEAD
@@ -93,6 +113,9 @@ bool AP_OABendyRuler::update(const Location& current_loc, const Location& destin
     // init bendy_type returned
     bendy_type = OABendyType::OA_BENDY_DISABLED;
 
+    // capture the obstacles for all the candidate paths tested below
+    update_snapshot();
+
     // calculate bearing and distance to final destination
     const float bearing_to_dest = current_loc.get_bearing_to(destination) * 0.01f;
     const float distance_to_dest = current_loc.get_distance(destination);
@@ -151,70 +174,73 @@ bool AP_OABendyRuler::search_xy_path(const Location& current_loc, const Location
     float best_margin = -FLT_MAX;
     float best_margin_bearing = best_bearing;
 
-    for (uint8_t i = 0; i <= (170 / OA_BENDYRULER_BEARING_INC_XY); i++) {
-        for (uint8_t bdir = 0; bdir <= 1; bdir++) {
-            // skip duplicate check of bearing straight towards destination
-            if ((i==0) && (bdir > 0)) {
-                continue;
-            }
-            // bearing that we are probing
-            const float bearing_delta = i * OA_BENDYRULER_BEARING_INC_XY * (bdir == 0 ? -1.0f : 1.0f);
-            const float bearing_test = wrap_180(bearing_to_dest + bearing_delta);
-
-            // ToDo: add effective groundspeed calculations using airspeed
-            // ToDo: add prediction of vehicle's position change as part of turn to desired heading
+    // margins of the first step of each candidate path. The path
+    // towards the destination is usually clear so is tested alone. If
+    // it is not the others are tested together, with the worker thread
+    float margins[OA_BENDYRULER_XY_CANDIDATES];
+    bool have_margins = false;
 
-            // test location is projected from current location at test bearing
-            Location test_loc = current_loc;
-            test_loc.offset_bearing(bearing_test, lookahead_step1_dist);
+    for (uint8_t k = 0; k < OA_BENDYRULER_XY_CANDIDATES; k++) {
+        const uint8_t i = (k + 1) / 2;
+        // bearing that we are probing
+        const float bearing_test = xy_candidate_bearing(bearing_to_dest, k);
 
-            // calculate margin from obstacles for this scenario
-            float margin = calc_avoidance_margin(current_loc, test_loc, proximity_only);
-            if (margin > best_margin) {
-                best_margin_bearing = bearing_test;
-                best_margin = margin;
-            }
-            if (margin > _margin_max) {
-                // this bearing avoids obstacles out to the lookahead_step1_dist
-                // now check in there is a clear path in three directions towards the destination
-                if (!have_best_bearing) {
-                    best_bearing = bearing_test;
-                    best_bearing_margin = margin;
-                    have_best_bearing = true;
-                } else if (fabsf(wrap_180(ground_course_deg - bearing_test)) <
-                           fabsf(wrap_180(ground_course_deg - best_bearing))) {
-                    // replace bearing with one that is closer to our current ground course
-                    best_bearing = bearing_test;
-                    best_bearing_margin = margin;
-                }
+        // ToDo: add effective groundspeed calculations using airspeed
+        // ToDo: add prediction of vehicle's position change as part of turn to desired heading
 
-                // perform second stage test in three directions looking for obstacles
-                const float test_bearings[] { 0.0f, 45.0f, -45.0f };
-                const float bearing_to_dest2 = test_loc.get_bearing_to(destination) * 0.01f;
-                float distance2 = constrain_float(lookahead_step2_dist, OA_BENDYRULER_LOOKAHEAD_STEP2_MIN, test_loc.get_distance(destination));
-                for (uint8_t j = 0; j < ARRAY_SIZE(test_bearings); j++) {
-                    float bearing_test2 = wrap_180(bearing_to_dest2 + test_bearings[j]);
-                    Location test_loc2 = test_loc;
-                    test_loc2.offset_bearing(bearing_test2, distance2);
+        // test location is projected from current location at test bearing
+        Location test_loc = current_loc;
+        test_loc.offset_bearing(bearing_test, lookahead_step1_dist);
 
-                    // calculate minimum margin to fence and obstacles for this scenario
-                    float margin2 = calc_avoidance_margin(test_loc, test_loc2, proximity_only);
-                    if (margin2 > _margin_max) {
-                        // if the chosen direction is directly towards the destination avoidance can be turned off
-                        // i == 0 && j == 0 implies no deviation from bearing to destination 
-                        const bool active = (i != 0 || j != 0);
-                        float final_bearing = bearing_test;
-                        float final_margin = margin;
-                        // check if we need ignore test_bearing and continue on previous bearing
-                        const bool ignore_bearing_change = resist_bearing_change(destination, current_loc, active, bearing_test, lookahead_step1_dist, margin, _destination_prev,_bearing_prev, final_bearing, final_margin, proximity_only);
+        // calculate margin from obstacles for this scenario
+        if (k == 1) {
+            have_margins = calc_xy_margins_parallel(current_loc, bearing_to_dest, lookahead_step1_dist, proximity_only, margins, OA_BENDYRULER_XY_CANDIDATES);
+        }
+        const float margin = have_margins ? margins[k] : calc_avoidance_margin(current_loc, test_loc, proximity_only);
+        if (margin > best_margin) {
+            best_margin_bearing = bearing_test;
+            best_margin = margin;
+        }
+        if (margin > _margin_max) {
+            // this bearing avoids obstacles out to the lookahead_step1_dist
+            // now check in there is a clear path in three directions towards the destination
+            if (!have_best_bearing) {
+                best_bearing = bearing_test;
+                best_bearing_margin = margin;
+                have_best_bearing = true;
+            } else if (fabsf(wrap_180(ground_course_deg - bearing_test)) <
+                       fabsf(wrap_180(ground_course_deg - best_bearing))) {
+                // replace bearing with one that is closer to our current ground course
+                best_bearing = bearing_test;
+                best_bearing_margin = margin;
+            }
 
-                        // all good, now project in the chosen direction by the full distance
-                        destination_new = current_loc;
-                        destination_new.offset_bearing(final_bearing, MIN(distance_to_dest, lookahead_step1_dist));
-                        _current_lookahead = MIN(_lookahead, _current_lookahead * 1.1f);
-                        Write_OABendyRuler((uint8_t)OABendyType::OA_BENDY_HORIZONTAL, active, bearing_to_dest, 0.0f, ignore_bearing_change, final_margin, destination, destination_new);
-                        return active;
-                    }
+            // perform second stage test in three directions looking for obstacles
+            const float test_bearings[] { 0.0f, 45.0f, -45.0f };
+            const float bearing_to_dest2 = test_loc.get_bearing_to(destination) * 0.01f;
+            float distance2 = constrain_float(lookahead_step2_dist, OA_BENDYRULER_LOOKAHEAD_STEP2_MIN, test_loc.get_distance(destination));
+            for (uint8_t j = 0; j < ARRAY_SIZE(test_bearings); j++) {
+                float bearing_test2 = wrap_180(bearing_to_dest2 + test_bearings[j]);
+                Location test_loc2 = test_loc;
+                test_loc2.offset_bearing(bearing_test2, distance2);
+
+                // calculate minimum margin to fence and obstacles for this scenario
+                float margin2 = calc_avoidance_margin(test_loc, test_loc2, proximity_only);
+                if (margin2 > _margin_max) {
+                    // if the chosen direction is directly towards the destination avoidance can be turned off
+                    // i == 0 && j == 0 implies no deviation from bearing to destination 
+                    const bool active = (i != 0 || j != 0);
+                    float final_bearing = bearing_test;
+                    float final_margin = margin;
+                    // check if we need ignore test_bearing and continue on previous bearing
+                    const bool ignore_bearing_change = resist_bearing_change(destination, current_loc, active, bearing_test, lookahead_step1_dist, margin, _destination_prev,_bearing_prev, final_bearing, final_margin, proximity_only);
+
+                    // all good, now project in the chosen direction by the full distance
+                    destination_new = current_loc;
+                    destination_new.offset_bearing(final_bearing, MIN(distance_to_dest, lookahead_step1_dist));
+                    _current_lookahead = MIN(_lookahead, _current_lookahead * 1.1f);
+                    Write_OABendyRuler((uint8_t)OABendyType::OA_BENDY_HORIZONTAL, active, bearing_to_dest, 0.0f, ignore_bearing_change, final_margin, destination, destination_new);
+                    return active;
                 }
             }
         }
@@ -246,6 +272,74 @@ bool AP_OABendyRuler::search_xy_path(const Location& current_loc, const Location
     return true;
 }
 
+// calculate the margins of the first step of the horizontal candidate
+// paths first, first+step, first+2*step... up to num
+void AP_OABendyRuler::calc_xy_margins(const Location &current_loc, float bearing_to_dest, float lookahead_step1_dist, bool proximity_only, float *margins, uint8_t first, uint8_t num, uint8_t step) const
+{
+    for (uint8_t k = first; k < num; k += step) {
+        Location test_loc = current_loc;
+        test_loc.offset_bearing(xy_candidate_bearing(bearing_to_dest, k), lookahead_step1_dist);
+        margins[k] = calc_avoidance_margin(current_loc, test_loc, proximity_only);
+    }
+}
+
+// calculate the margins of the first step of horizontal candidate paths
+// 1 to num-1 together, sharing the work with the worker thread.
+// returns false if the worker thread is not available
+bool AP_OABendyRuler::calc_xy_margins_parallel(const Location &current_loc, float bearing_to_dest, float lookahead_step1_dist, bool proximity_only, float *margins, uint8_t num)
+{
+#if AP_OABENDYRULER_WORKER_ENABLED
+    if (!create_worker()) {
+        return false;
+    }
+    // left and right candidates alternate, so each thread has a similar
+    // mix of clear and obstructed paths
+    _worker_job.current_loc = current_loc;
+    _worker_job.bearing_to_dest = bearing_to_dest;
+    _worker_job.lookahead_step1_dist = lookahead_step1_dist;
+    _worker_job.proximity_only = proximity_only;
+    _worker_job.margins = margins;
+    _worker_job.num = num;
+    _worker_start_sem.signal();
+    calc_xy_margins(current_loc, bearing_to_dest, lookahead_step1_dist, proximity_only, margins, 1, num, 2);
+    _worker_done_sem.wait_blocking();
+    return true;
+#else
+    return false;
+#endif
+}
+
+#if AP_OABENDYRULER_WORKER_ENABLED
+// create the worker thread, returns true if it is available
+bool AP_OABendyRuler::create_worker()
+{
+    if (_worker_created) {
+        return true;
+    }
+    if (_worker_failed) {
+        return false;
+    }
+    if (!hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&AP_OABendyRuler::worker_thread, void),
+                                      "bendy",
+                                      OA_BENDYRULER_WORKER_STACK_SIZE, AP_HAL::Scheduler::PRIORITY_IO, -1)) {
+        _worker_failed = true;
+        return false;
+    }
+    _worker_created = true;
+    return true;
+}
+
+void AP_OABendyRuler::worker_thread()
+{
+    while (true) {
+        _worker_start_sem.wait_blocking();
+        calc_xy_margins(_worker_job.current_loc, _worker_job.bearing_to_dest, _worker_job.lookahead_step1_dist,
+                        _worker_job.proximity_only, _worker_job.margins, 2, _worker_job.num, 2);
+        _worker_done_sem.signal();
+    }
+}
+#endif  // AP_OABENDYRULER_WORKER_ENABLED
+
 // Search for path in the vertical directions
 bool AP_OABendyRuler::search_vertical_path(const Location &current_loc, const Location &destination, Location &destination_new, float lookahead_step1_dist, float lookahead_step2_dist, float bearing_to_dest, float distance_to_dest, bool proximity_only)
 {
@@ -416,15 +510,113 @@ bool AP_OABendyRuler::resist_bearing_change(const Location &destination, const L
     return resisted_change;
 }
 
+// capture the EKF origin and object database used by calc_avoidance_margin()
+void AP_OABendyRuler::update_snapshot()
+{
+    _snapshot.have_origin = AP::ahrs().get_origin(_snapshot.origin);
+    _snapshot.db_count = 0;
+    _snapshot.db_ok = true;
+
+    // the database is only changed by the avoidance thread, which is
+    // the thread calling us
+    const AP_OADatabase *oaDb = AP::oadatabase();
+    const bool db_healthy = (oaDb != nullptr) && oaDb->healthy();
+    const uint16_t count = db_healthy ? oaDb->database_count() : 0;
+
+#if AP_PROXIMITY_GRID_ENABLED
+    // obstacles in the proximity sensors' high resolution grid are
+    // added as points, so paths are checked against every cell rather
+    // than only the readings sent to the database
+    const AP_Proximity *proximity = AP::proximity();
+    const AP_Proximity_Grid *grid = (proximity != nullptr && proximity->grid.enabled()) ? &proximity->grid : nullptr;
+    Vector3f vehicle_pos_ned;
+    if (grid != nullptr && !AP::ahrs().get_relative_position_NED_origin(vehicle_pos_ned)) {
+        grid = nullptr;
+    }
+    const uint16_t grid_count = (grid != nullptr) ? grid->get_obstacle_count() : 0;
+#else
+    const uint16_t grid_count = 0;
+#endif
+
+    const uint32_t space = uint32_t(count) + grid_count;
+    if (space > _snapshot.db_space) {
+        delete[] _snapshot.db_x;
+        _snapshot.db_space = 0;
+        _snapshot.db_x = (space <= UINT16_MAX) ? NEW_NOTHROW float[space * 4] : nullptr;
+        if (_snapshot.db_x == nullptr) {
+            // margins are calculated from the database itself
+            _snapshot.db_ok = false;
+            return;
+        }
+        _snapshot.db_space = space;
+        _snapshot.db_y = &_snapshot.db_x[space];
+        _snapshot.db_z = &_snapshot.db_x[space * 2];
+        _snapshot.db_radius = &_snapshot.db_x[space * 3];
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        const AP_OADatabase::OA_DbItem& item = oaDb->get_item(i);
+        _snapshot.db_x[i] = item.pos.x * 100.0f;
+        _snapshot.db_y[i] = item.pos.y * 100.0f;
+        _snapshot.db_z[i] = item.pos.z * 100.0f;
+        _snapshot.db_radius[i] = item.radius;
+    }
+    uint16_t n = count;
+
+#if AP_PROXIMITY_GRID_ENABLED
+    if (grid != nullptr) {
+        // grid obstacles are body-frame vectors in cm with z up, held
+        // here as offsets in cm from the EKF origin with z up
+        const Matrix3f body_to_ned = AP::ahrs().get_rotation_body_to_ned();
+        const Vector3f vehicle_pos_cm = vehicle_pos_ned * 100.0f;
+        for (uint16_t i = 0; i < grid_count; i++) {
+            Vector3f vec_to_obstacle;
+            if (!grid->get_obstacle(i, FLT_MAX, vec_to_obstacle)) {
+                continue;
+            }
+            const Vector3f obstacle_ned = vehicle_pos_cm + body_to_ned * Vector3f{vec_to_obstacle.x, vec_to_obstacle.y, -vec_to_obstacle.z};
+            _snapshot.db_x[n] = obstacle_ned.x;
+            _snapshot.db_y[n] = obstacle_ned.y;
+            _snapshot.db_z[n] = -obstacle_ned.z;
+            _snapshot.db_radius[n] = 0.0f;
+            n++;
+        }
+    }
+#endif
+
+    _snapshot.db_count = n;
+}
+
+// convert a location to an offset (in cm) from the EKF origin captured in the snapshot
+bool AP_OABendyRuler::snapshot_vector_xy_from_origin_NE(const Location &loc, Vector2f &vec_ne) const
+{
+    if (!_snapshot.have_origin) {
+        return false;
+    }
+    vec_ne = _snapshot.origin.get_distance_NE(loc) * 100.0f;
+    return true;
+}
+
 // calculate minimum distance between a segment and any obstacle
 float AP_OABendyRuler::calc_avoidance_margin(const Location &start, const Location &end, bool proximity_only) const
 {
     float margin_min = FLT_MAX;
 
     float latest_margin;
-    
-    if (calc_margin_from_object_database(start, end, latest_margin)) {
-        margin_min = MIN(margin_min, latest_margin);
+
+    // convert start and end to offsets (in cm) from EKF origin
+    Vector3f start_NEU, end_NEU;
+    const bool have_NE = snapshot_vector_xy_from_origin_NE(start, start_NEU.xy()) &&
+                         snapshot_vector_xy_from_origin_NE(end, end_NEU.xy());
+
+    int32_t start_alt_cm, end_alt_cm;
+    if (have_NE &&
+        start.get_alt_cm(Location::AltFrame::ABOVE_ORIGIN, start_alt_cm) &&
+        end.get_alt_cm(Location::AltFrame::ABOVE_ORIGIN, end_alt_cm)) {
+        start_NEU.z = start_alt_cm;
+        end_NEU.z = end_alt_cm;
+        if (calc_margin_from_object_database(start_NEU, end_NEU, latest_margin)) {
+            margin_min = MIN(margin_min, latest_margin);
+        }
     }
     
     if (proximity_only) {
@@ -445,11 +637,11 @@ float AP_OABendyRuler::calc_avoidance_margin(const Location &start, const Locati
     }
     #endif
 
-    if (calc_margin_from_inclusion_and_exclusion_polygons(start, end, latest_margin)) {
+    if (have_NE && calc_margin_from_inclusion_and_exclusion_polygons(start_NEU.xy(), end_NEU.xy(), latest_margin)) {
         margin_min = MIN(margin_min, latest_margin);
     }
 
-    if (calc_margin_from_inclusion_and_exclusion_circles(start, end, latest_margin)) {
+    if (have_NE && calc_margin_from_inclusion_and_exclusion_circles(start_NEU.xy(), end_NEU.xy(), latest_margin)) {
         margin_min = MIN(margin_min, latest_margin);
     }
 
@@ -525,7 +717,7 @@ bool AP_OABendyRuler::calc_margin_from_alt_fence(const Location &start, const Lo
 
 // calculate minimum distance between a path and all inclusion and exclusion polygons
 // on success returns true and updates margin
-bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Location &start, const Location &end, float &margin) const
+bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Vector2f &start_NE, const Vector2f &end_NE, float &margin) const
 {
 #if AP_FENCE_ENABLED
     const AC_Fence *fence = AC_Fence::get_singleton();
@@ -545,12 +737,6 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Lo
         return false;
     }
 
-    // convert start and end to offsets from EKF origin
-    Vector2f start_NE, end_NE;
-    if (!start.get_vector_xy_from_origin_NE(start_NE) || !end.get_vector_xy_from_origin_NE(end_NE)) {
-        return false;
-    }
-
     // get fence margin
     const float fence_margin = fence->get_margin();
 
@@ -559,12 +745,15 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Lo
     for (uint8_t i = 0; i < num_inclusion_polygons; i++) {
         uint16_t num_points;
         const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
-     
+        const Polygon_index<float> *index = fence->polyfence().get_inclusion_polygon_index(i);
+
         // if outside the fence margin is the closest distance but with negative sign
-        const float sign = Polygon_outside(start_NE, boundary, num_points) ? -1.0f : 1.0f;
+        const bool outside = (index != nullptr) ? index->outside(start_NE) : Polygon_outside(start_NE, boundary, num_points);
+        const float sign = outside ? -1.0f : 1.0f;
 
         // calculate min distance (in meters) from line to polygon
-        float margin_new = (sign * Polygon_closest_distance_line(boundary, num_points, start_NE, end_NE) * 0.01f) - fence_margin;
+        const float distance = (index != nullptr) ? Polygon_closest_distance_line(*index, start_NE, end_NE) : Polygon_closest_distance_line(boundary, num_points, start_NE, end_NE);
+        float margin_new = (sign * distance * 0.01f) - fence_margin;
         if (!margin_updated || (margin_new < margin)) {
             margin_updated = true;
             margin = margin_new;
@@ -575,12 +764,15 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Lo
     for (uint8_t i = 0; i < num_exclusion_polygons; i++) {
         uint16_t num_points;
         const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
-   
+        const Polygon_index<float> *index = fence->polyfence().get_exclusion_polygon_index(i);
+
         // if start is inside the polygon the margin's sign is reversed
-        const float sign = Polygon_outside(start_NE, boundary, num_points) ? 1.0f : -1.0f;
+        const bool outside = (index != nullptr) ? index->outside(start_NE) : Polygon_outside(start_NE, boundary, num_points);
+        const float sign = outside ? 1.0f : -1.0f;
 
         // calculate min distance (in meters) from line to polygon
-        float margin_new = (sign * Polygon_closest_distance_line(boundary, num_points, start_NE, end_NE) * 0.01f) - fence_margin;
+        const float distance = (index != nullptr) ? Polygon_closest_distance_line(*index, start_NE, end_NE) : Polygon_closest_distance_line(boundary, num_points, start_NE, end_NE);
+        float margin_new = (sign * distance * 0.01f) - fence_margin;
         if (!margin_updated || (margin_new < margin)) {
             margin_updated = true;
             margin = margin_new;
@@ -595,7 +787,7 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Lo
 
 // calculate minimum distance between a path and all inclusion and exclusion circles
 // on success returns true and updates margin
-bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_circles(const Location &start, const Location &end, float &margin) const
+bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_circles(const Vector2f &start_NE, const Vector2f &end_NE, float &margin) const
 {
 #if AP_FENCE_ENABLED
     // exit immediately if fence is not enabled
@@ -616,12 +808,6 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_circles(const Loc
         return false;
     }
 
-    // convert start and end to offsets from EKF origin
-    Vector2f start_NE, end_NE;
-    if (!start.get_vector_xy_from_origin_NE(start_NE) || !end.get_vector_xy_from_origin_NE(end_NE)) {
-        return false;
-    }
-
     // get fence margin
     const float fence_margin = fence->get_margin();
 
@@ -675,32 +861,49 @@ bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_circles(const Loc
 
 // calculate minimum distance between a path and proximity sensor obstacles
 // on success returns true and updates margin
-bool AP_OABendyRuler::calc_margin_from_object_database(const Location &start, const Location &end, float &margin) const
+bool AP_OABendyRuler::calc_margin_from_object_database(const Vector3f &start_NEU, const Vector3f &end_NEU, float &margin) const
 {
-    // exit immediately if db is empty
-    AP_OADatabase *oaDb = AP::oadatabase();
-    if (oaDb == nullptr || !oaDb->healthy()) {
-        return false;
-    }
-
-    // convert start and end to offsets (in cm) from EKF origin
-    Vector3f start_NEU,end_NEU;
-    if (!start.get_vector_from_origin_NEU(start_NEU) || !end.get_vector_from_origin_NEU(end_NEU)) {
-        return false;
-    }
     if (start_NEU == end_NEU) {
         return false;
     }
 
     // check each obstacle's distance from segment
     float smallest_margin = FLT_MAX;
-    for (uint16_t i=0; i<oaDb->database_count(); i++) {
-        const AP_OADatabase::OA_DbItem& item = oaDb->get_item(i);
-        const Vector3f point_cm = item.pos * 100.0f;
-        // margin is distance between line segment and obstacle minus obstacle's radius
-        const float m = Vector3f::closest_distance_between_line_and_point(start_NEU, end_NEU, point_cm) * 0.01f - item.radius;
-        if (m < smallest_margin) {
-            smallest_margin = m;
+    if (_snapshot.db_ok) {
+        // closest point on the segment to each obstacle is start + line * t with t in 0 to 1
+        const Vector3f line = end_NEU - start_NEU;
+        const float line_len_sq = line.length_squared();
+        const float line_len_sq_inv = is_positive(line_len_sq) ? 1.0f / line_len_sq : 0.0f;
+        const float *db_x = _snapshot.db_x;
+        const float *db_y = _snapshot.db_y;
+        const float *db_z = _snapshot.db_z;
+        const float *db_radius = _snapshot.db_radius;
+        for (uint16_t i=0; i<_snapshot.db_count; i++) {
+            const float px = db_x[i] - start_NEU.x;
+            const float py = db_y[i] - start_NEU.y;
+            const float pz = db_z[i] - start_NEU.z;
+            const float t = MIN(MAX((px * line.x + py * line.y + pz * line.z) * line_len_sq_inv, 0.0f), 1.0f);
+            const float dx = px - line.x * t;
+            const float dy = py - line.y * t;
+            const float dz = pz - line.z * t;
+            // margin is distance between line segment and obstacle minus obstacle's radius
+            const float m = sqrtf(dx * dx + dy * dy + dz * dz) * 0.01f - db_radius[i];
+            smallest_margin = MIN(smallest_margin, m);
+        }
+    } else {
+        // no memory for the snapshot, read the database itself
+        const AP_OADatabase *oaDb = AP::oadatabase();
+        if (oaDb == nullptr || !oaDb->healthy()) {
+            return false;
+        }
+        for (uint16_t i=0; i<oaDb->database_count(); i++) {
+            const AP_OADatabase::OA_DbItem& item = oaDb->get_item(i);
+            const Vector3f point_cm = item.pos * 100.0f;
+            // margin is distance between line segment and obstacle minus obstacle's radius
+            const float m = Vector3f::closest_distance_between_line_and_point(start_NEU, end_NEU, point_cm) * 0.01f - item.radius;
+            if (m < smallest_margin) {
+                smallest_margin = m;
+            }
         }
     }
 
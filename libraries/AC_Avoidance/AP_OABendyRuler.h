@@ -8,6 +8,7 @@
 #include <AP_Common/Location.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_Logger/AP_Logger_config.h>
+#include <AP_HAL/Semaphores.h>
 
 /*
  * BendyRuler avoidance algorithm for avoiding the polygon and circular fence and dynamic objects detected by the proximity sensor
@@ -39,6 +40,12 @@ private:
     // return type of BendyRuler in use
     OABendyType get_type() const;
 
+    // capture the EKF origin and object database used by calc_avoidance_margin()
+    void update_snapshot();
+
+    // convert a location to an offset (in cm) from the EKF origin captured in the snapshot
+    bool snapshot_vector_xy_from_origin_NE(const Location &loc, Vector2f &vec_ne) const;
+
     // search for path in XY direction
     bool search_xy_path(const Location& current_loc, const Location& destination, float ground_course_deg, Location &destination_new, float lookahead_step_1_dist, float lookahead_step_2_dist, float bearing_to_dest, float distance_to_dest, bool proximity_only);
 
@@ -48,6 +55,15 @@ private:
     // calculate minimum distance between a path and any obstacle
     float calc_avoidance_margin(const Location &start, const Location &end, bool proximity_only) const;
 
+    // calculate the margins of the first step of the horizontal
+    // candidate paths first, first+step, first+2*step... up to num
+    void calc_xy_margins(const Location &current_loc, float bearing_to_dest, float lookahead_step1_dist, bool proximity_only, float *margins, uint8_t first, uint8_t num, uint8_t step) const;
+
+    // calculate the margins of the first step of horizontal candidate
+    // paths 1 to num-1 together, sharing the work with the worker thread.
+    // returns false if the worker thread is not available
+    bool calc_xy_margins_parallel(const Location &current_loc, float bearing_to_dest, float lookahead_step1_dist, bool proximity_only, float *margins, uint8_t num);
+
     // determine if BendyRuler should accept the new bearing or try and resist it. Returns true if bearing is not changed  
     bool resist_bearing_change(const Location &destination, const Location &current_loc, bool active, float bearing_test, float lookahead_step1_dist, float margin, Location &prev_dest, float &prev_bearing, float &final_bearing, float &final_margin, bool proximity_only) const;    
 
@@ -61,15 +77,15 @@ private:
 
     // calculate minimum distance between a path and all inclusion and exclusion polygons
     // on success returns true and updates margin
-    bool calc_margin_from_inclusion_and_exclusion_polygons(const Location &start, const Location &end, float &margin) const;
+    bool calc_margin_from_inclusion_and_exclusion_polygons(const Vector2f &start_NE, const Vector2f &end_NE, float &margin) const;
 
     // calculate minimum distance between a path and all inclusion and exclusion circles
     // on success returns true and updates margin
-    bool calc_margin_from_inclusion_and_exclusion_circles(const Location &start, const Location &end, float &margin) const;
+    bool calc_margin_from_inclusion_and_exclusion_circles(const Vector2f &start_NE, const Vector2f &end_NE, float &margin) const;
 
     // calculate minimum distance between a path and proximity sensor obstacles
     // on success returns true and updates margin
-    bool calc_margin_from_object_database(const Location &start, const Location &end, float &margin) const;
+    bool calc_margin_from_object_database(const Vector3f &start_NEU, const Vector3f &end_NEU, float &margin) const;
 
     // Logging function
 #if HAL_LOGGING_ENABLED
@@ -91,6 +107,41 @@ private:
     float _current_lookahead;       // distance (in meters) ahead of the vehicle we are looking for obstacles
     float _bearing_prev;            // stored bearing in degrees 
     Location _destination_prev;     // previous destination, to check if there has been a change in destination
+
+    // EKF origin, object database and proximity grid captured at the
+    // start of each update, so the margin of each candidate path is
+    // calculated without querying the AHRS and database again. Obstacles
+    // are held as arrays of each coordinate so that their distances from
+    // a path are calculated in one loop the compiler can vectorise
+    struct {
+        Location origin;        // EKF origin
+        bool have_origin;       // true if origin is valid
+        bool db_ok;             // true if the arrays below hold the whole object database and proximity grid
+        uint16_t db_count;      // number of obstacles held
+        uint16_t db_space;      // number of obstacles the arrays can hold
+        float *db_x;            // obstacle positions as offsets in cm from the EKF origin
+        float *db_y;
+        float *db_z;
+        float *db_radius;       // obstacle radius in meters
+    } _snapshot;
+
+#if AP_OABENDYRULER_WORKER_ENABLED
+    // worker thread calculating candidate path margins in parallel with the avoidance thread
+    bool create_worker();
+    void worker_thread();
+    HAL_BinarySemaphore _worker_start_sem;
+    HAL_BinarySemaphore _worker_done_sem;
+    bool _worker_created;           // true once the worker thread is running
+    bool _worker_failed;            // true if the worker thread could not be created
+    struct {
+        Location current_loc;
+        float bearing_to_dest;
+        float lookahead_step1_dist;
+        bool proximity_only;
+        float *margins;
+        uint8_t num;
+    } _worker_job;                  // margins to be calculated by the worker thread
+#endif
 };
 
 #endif  // AP_OAPATHPLANNER_BENDYRULER_ENABLED
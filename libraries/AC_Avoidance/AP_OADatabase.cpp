@@ -40,6 +40,14 @@ extern const AP_HAL::HAL& hal;
     #define AP_OADATABASE_DISTANCE_FROM_HOME 3
 #endif
 
+#ifndef AP_OADATABASE_HASH_CELL_SIZE
+    #define AP_OADATABASE_HASH_CELL_SIZE    1.0f    // size (in meters) of the cubes of the spatial hash
+#endif
+
+#define OA_DB_INDEX_NONE                    0xFFFF  // no database item
+#define OA_DB_HASH_BUCKETS_MAX              16384   // maximum number of buckets in the spatial hash
+#define OA_DB_STATS_LOG_INTERVAL_MS         1000    // throughput stats logged once per second
+
 const AP_Param::GroupInfo AP_OADatabase::var_info[] = {
 
     // @Param: SIZE
@@ -132,6 +140,8 @@ void AP_OADatabase::init()
         GCS_SEND_TEXT(MAV_SEVERITY_INFO, "DB init failed . Sizes queue:%u, db:%u", (unsigned int)_queue.size, (unsigned int)_database.size);
         delete _queue.items;
         delete[] _database.items;
+        delete[] _database.links;
+        delete[] _hash.head;
         return;
     }
 }
@@ -144,6 +154,12 @@ void AP_OADatabase::update()
 
     process_queue();
     database_items_remove_all_expired();
+
+    const uint32_t now_ms = AP_HAL::millis();
+    if (now_ms - _stats_last_log_ms >= OA_DB_STATS_LOG_INTERVAL_MS) {
+        _stats_last_log_ms = now_ms;
+        Write_OADatabase();
+    }
 }
 
 // push a location into the database
@@ -179,7 +195,10 @@ void AP_OADatabase::queue_push(const Vector3f &pos, uint32_t timestamp_ms, float
     const OA_DbItem item = {pos, timestamp_ms, MAX(_radius_min, distance * dist_to_radius_scalar), 0, AP_OADatabase::OA_DbItemImportance::Normal};
     {
         WITH_SEMAPHORE(_queue.sem);
-        _queue.items->push(item);
+        _stats.pushed++;
+        if (!_queue.items->push(item)) {
+            _stats.queue_full++;
+        }
     }
 }
 
@@ -206,6 +225,22 @@ void AP_OADatabase::init_database()
     }
 
     _database.items = NEW_NOTHROW OA_DbItem[_database.size];
+    _database.links = NEW_NOTHROW OA_DbLinks[_database.size];
+    _database.oldest = OA_DB_INDEX_NONE;
+    _database.newest = OA_DB_INDEX_NONE;
+
+    // around one bucket per object
+    uint32_t buckets = 16;
+    while (buckets < _database.size && buckets < OA_DB_HASH_BUCKETS_MAX) {
+        buckets *= 2;
+    }
+    _hash.head = NEW_NOTHROW uint16_t[buckets];
+    if (_hash.head != nullptr) {
+        _hash.mask = buckets - 1;
+        for (uint32_t i=0; i<buckets; i++) {
+            _hash.head[i] = OA_DB_INDEX_NONE;
+        }
+    }
 }
 
 // get bitmask of gcs channels item should be sent to based on its importance
@@ -265,17 +300,12 @@ bool AP_OADatabase::process_queue()
 
         item.send_to_gcs = get_send_to_gcs_flags(item.importance);
 
-        // compare item to all items in database. If found a similar item, update the existing, else add it as a new one
-        bool found = false;
-        for (uint16_t i=0; i<_database.count; i++) {
-            if (is_close_to_item_in_database(i, item)) {
-                database_item_refresh(i, item.timestamp_ms, item.radius);
-                found = true;
-                break;
-            }
-        }
-
-        if (!found) {
+        // find a similar item in the database. If found update the existing, else add it as a new one
+        const uint16_t close_index = find_close_item_in_database(item);
+        if (close_index != OA_DB_INDEX_NONE) {
+            database_item_refresh(close_index, item.timestamp_ms, item.radius);
+            _stats.refreshed++;
+        } else {
             database_item_add(item);
         }
     }
@@ -285,11 +315,16 @@ bool AP_OADatabase::process_queue()
 void AP_OADatabase::database_item_add(const OA_DbItem &item)
 {
     if (_database.count >= _database.size) {
+        _stats.database_full++;
         return;
     }
     _database.items[_database.count] = item;
     _database.items[_database.count].send_to_gcs = get_send_to_gcs_flags(_database.items[_database.count].importance);
+    hash_insert(_database.count);
+    expiry_insert(_database.count);
+    _database.radius_max = MAX(_database.radius_max, item.radius);
     _database.count++;
+    _stats.added++;
 }
 
 void AP_OADatabase::database_item_remove(const uint16_t index)
@@ -299,12 +334,16 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
         return;
     }
 
+    hash_remove(index);
+    expiry_remove(index);
+
     // radius of 0 tells the GCS we don't care about it any more (aka it expired)
     _database.items[index].radius = 0;
     _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
 
     _database.count--;
     if (_database.count == 0) {
+        _database.radius_max = 0;
         return;
     }
 
@@ -312,6 +351,7 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
         // copy last object in array over expired object
         _database.items[index] = _database.items[_database.count];
         _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
+        database_item_moved(_database.count, index);
     }
 }
 
@@ -329,8 +369,11 @@ void AP_OADatabase::database_item_refresh(const uint16_t index, const uint32_t t
     if (is_different) {
         // update timestamp and radius on close object so it stays around longer
         // and trigger resending to GCS
+        expiry_remove(index);
         _database.items[index].timestamp_ms = timestamp_ms;
+        expiry_insert(index);
         _database.items[index].radius = radius;
+        _database.radius_max = MAX(_database.radius_max, radius);
         _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
     }
 }
@@ -345,15 +388,16 @@ void AP_OADatabase::database_items_remove_all_expired()
         return;
     }
 
+    // items are listed in timestamp order so only those which have
+    // expired are checked, plus the first which has not
     const uint32_t now_ms = AP_HAL::millis();
     const uint32_t expiry_ms = (uint32_t)_database_expiry_seconds * 1000;
-    uint16_t index = 0;
-    while (index < _database.count) {
-        if (now_ms - _database.items[index].timestamp_ms > expiry_ms) {
-            database_item_remove(index);
-        } else {
-            index++;
+    while (_database.oldest != OA_DB_INDEX_NONE) {
+        if (now_ms - _database.items[_database.oldest].timestamp_ms <= expiry_ms) {
+            break;
         }
+        database_item_remove(_database.oldest);
+        _stats.expired++;
     }
 }
 
@@ -369,6 +413,153 @@ bool AP_OADatabase::is_close_to_item_in_database(const uint16_t index, const OA_
     return ((distance_sq < sq(item.radius)) || (distance_sq < sq(_database.items[index].radius)));
 }
 
+// returns the lowest index of a database item close to "item", or
+// OA_DB_INDEX_NONE if there is none. This is the item a search of the
+// whole database in index order would find
+uint16_t AP_OADatabase::find_close_item_in_database(const OA_DbItem &item) const
+{
+    // items are close if their distance apart is less than the radius
+    // of either, so only cells within the larger of the item's radius and
+    // the largest radius in the database need searching
+    const float range = MAX(item.radius, _database.radius_max) * 1.01f + 0.01f;
+    int32_t min_x, min_y, min_z, max_x, max_y, max_z;
+    hash_cell(item.pos - Vector3f{range, range, range}, min_x, min_y, min_z);
+    hash_cell(item.pos + Vector3f{range, range, range}, max_x, max_y, max_z);
+    const float num_cells = (max_x - min_x + 1.0f) * (max_y - min_y + 1.0f) * (max_z - min_z + 1.0f);
+
+    uint16_t close_index = OA_DB_INDEX_NONE;
+    if (num_cells > _database.count) {
+        // very large radius, a search of the whole database is quicker
+        for (uint16_t i=0; i<_database.count; i++) {
+            if (is_close_to_item_in_database(i, item)) {
+                return i;
+            }
+        }
+        return close_index;
+    }
+
+    for (int32_t x = min_x; x <= max_x; x++) {
+        for (int32_t y = min_y; y <= max_y; y++) {
+            for (int32_t z = min_z; z <= max_z; z++) {
+                for (uint16_t i = _hash.head[hash_bucket(x, y, z)]; i != OA_DB_INDEX_NONE; i = _database.links[i].hash_next) {
+                    if (i < close_index && is_close_to_item_in_database(i, item)) {
+                        close_index = i;
+                    }
+                }
+            }
+        }
+    }
+    return close_index;
+}
+
+// get the cell of the spatial hash holding a position
+void AP_OADatabase::hash_cell(const Vector3f &pos, int32_t &x, int32_t &y, int32_t &z) const
+{
+    x = (int32_t)floorf(pos.x * (1.0f / AP_OADATABASE_HASH_CELL_SIZE));
+    y = (int32_t)floorf(pos.y * (1.0f / AP_OADATABASE_HASH_CELL_SIZE));
+    z = (int32_t)floorf(pos.z * (1.0f / AP_OADATABASE_HASH_CELL_SIZE));
+}
+
+// get the bucket of the spatial hash holding a cell
+uint16_t AP_OADatabase::hash_bucket(int32_t x, int32_t y, int32_t z) const
+{
+    const uint32_t h = ((uint32_t)x * 73856093U) ^ ((uint32_t)y * 19349663U) ^ ((uint32_t)z * 83492791U);
+    return h & _hash.mask;
+}
+
+// add database item "index" to the spatial hash
+void AP_OADatabase::hash_insert(const uint16_t index)
+{
+    int32_t x, y, z;
+    hash_cell(_database.items[index].pos, x, y, z);
+    const uint16_t bucket = hash_bucket(x, y, z);
+    _database.links[index].hash_next = _hash.head[bucket];
+    _hash.head[bucket] = index;
+}
+
+// remove database item "index" from the spatial hash
+void AP_OADatabase::hash_remove(const uint16_t index)
+{
+    int32_t x, y, z;
+    hash_cell(_database.items[index].pos, x, y, z);
+    for (uint16_t *i = &_hash.head[hash_bucket(x, y, z)]; *i != OA_DB_INDEX_NONE; i = &_database.links[*i].hash_next) {
+        if (*i == index) {
+            *i = _database.links[index].hash_next;
+            return;
+        }
+    }
+}
+
+// add database item "index" to the expiry list. Timestamps are nearly
+// always the newest so the search for its place starts from the newest
+void AP_OADatabase::expiry_insert(const uint16_t index)
+{
+    const uint32_t timestamp_ms = _database.items[index].timestamp_ms;
+    uint16_t older = _database.newest;
+    while (older != OA_DB_INDEX_NONE && (int32_t)(_database.items[older].timestamp_ms - timestamp_ms) > 0) {
+        older = _database.links[older].older;
+    }
+    const uint16_t newer = (older == OA_DB_INDEX_NONE) ? _database.oldest : _database.links[older].newer;
+
+    _database.links[index].older = older;
+    _database.links[index].newer = newer;
+    if (older == OA_DB_INDEX_NONE) {
+        _database.oldest = index;
+    } else {
+        _database.links[older].newer = index;
+    }
+    if (newer == OA_DB_INDEX_NONE) {
+        _database.newest = index;
+    } else {
+        _database.links[newer].older = index;
+    }
+}
+
+// remove database item "index" from the expiry list
+void AP_OADatabase::expiry_remove(const uint16_t index)
+{
+    const uint16_t older = _database.links[index].older;
+    const uint16_t newer = _database.links[index].newer;
+    if (older == OA_DB_INDEX_NONE) {
+        _database.oldest = newer;
+    } else {
+        _database.links[older].newer = newer;
+    }
+    if (newer == OA_DB_INDEX_NONE) {
+        _database.newest = older;
+    } else {
+        _database.links[newer].older = older;
+    }
+}
+
+// update the hash and expiry list after the item at index "from" is moved to index "to"
+void AP_OADatabase::database_item_moved(const uint16_t from, const uint16_t to)
+{
+    _database.links[to] = _database.links[from];
+
+    int32_t x, y, z;
+    hash_cell(_database.items[to].pos, x, y, z);
+    for (uint16_t *i = &_hash.head[hash_bucket(x, y, z)]; *i != OA_DB_INDEX_NONE; i = &_database.links[*i].hash_next) {
+        if (*i == from) {
+            *i = to;
+            break;
+        }
+    }
+
+    const uint16_t older = _database.links[to].older;
+    const uint16_t newer = _database.links[to].newer;
+    if (older == OA_DB_INDEX_NONE) {
+        _database.oldest = to;
+    } else {
+        _database.links[older].newer = to;
+    }
+    if (newer == OA_DB_INDEX_NONE) {
+        _database.newest = to;
+    } else {
+        _database.links[newer].older = to;
+    }
+}
+
 #if HAL_GCS_ENABLED
 // send ADSB_VEHICLE mavlink messages
 void AP_OADatabase::send_adsb_vehicle(mavlink_channel_t chan, uint16_t interval_ms)
@@ -8,6 +8,7 @@
 #include <AP_Math/AP_Math.h>
 #include <GCS_MAVLink/GCS_MAVLink.h>
 #include <AP_Param/AP_Param.h>
+#include <AP_Logger/AP_Logger_config.h>
 
 class AP_OADatabase {
 public:
@@ -42,7 +43,7 @@ public:
     void queue_push(const Vector3f &pos, uint32_t timestamp_ms, float distance);
 
     // returns true if database is healthy
-    bool healthy() const { return (_queue.items != nullptr) && (_database.items != nullptr); }
+    bool healthy() const { return (_queue.items != nullptr) && (_database.items != nullptr) && (_database.links != nullptr) && (_hash.head != nullptr); }
 
     // fetch an item in database. Undefined result when i >= _database.count.
     const OA_DbItem& get_item(uint32_t i) const { return _database.items[i]; }
@@ -59,6 +60,7 @@ public:
     static const struct AP_Param::GroupInfo var_info[];
 
 private:
+    friend class AP_OADatabase_Test;
 
     // initialise
     void init_queue();
@@ -77,6 +79,30 @@ private:
     // returns true if database item "index" is close to "item"
     bool is_close_to_item_in_database(const uint16_t index, const OA_DbItem &item) const;
 
+    // returns the lowest index of a database item close to "item", or
+    // OA_DB_INDEX_NONE if there is none
+    uint16_t find_close_item_in_database(const OA_DbItem &item) const;
+
+    // spatial hash of database items
+    void hash_cell(const Vector3f &pos, int32_t &x, int32_t &y, int32_t &z) const;
+    uint16_t hash_bucket(int32_t x, int32_t y, int32_t z) const;
+    void hash_insert(const uint16_t index);
+    void hash_remove(const uint16_t index);
+
+    // list of database items ordered by timestamp
+    void expiry_insert(const uint16_t index);
+    void expiry_remove(const uint16_t index);
+
+    // update the hash and expiry list after the item at index "from" is moved to index "to"
+    void database_item_moved(const uint16_t from, const uint16_t to);
+
+    // log queue and database throughput
+#if HAL_LOGGING_ENABLED
+    void Write_OADatabase();
+#else
+    void Write_OADatabase() {}
+#endif
+
     // enum for use with _OUTPUT parameter
     enum class OutputLevel {
         NONE = 0,
@@ -102,12 +128,42 @@ private:
     } _queue;
     float dist_to_radius_scalar;                            // scalar to convert the distance and beam width to an object radius
 
+    // links of each database item into the spatial hash and the expiry list
+    struct OA_DbLinks {
+        uint16_t        hash_next;                          // next item in the same hash bucket
+        uint16_t        older;                              // item with the next older timestamp
+        uint16_t        newer;                              // item with the next newer timestamp
+    };
+
     struct {
         OA_DbItem       *items;                             // array of objects in the database
+        OA_DbLinks      *links;                             // links of each object in the items array
         uint16_t        count;                              // number of objects in the items array
         uint16_t        size;                               // cached value of _database_size_param that sticks after initialized
+        uint16_t        oldest;                             // object with the oldest timestamp
+        uint16_t        newest;                             // object with the newest timestamp
+        float           radius_max;                         // largest radius of any object since the database was last empty
     } _database;
 
+    // spatial hash of the database, a grid of cubes each hashed to a
+    // bucket holding the objects whose position is inside it. Used to
+    // find an object close to a new one without comparing every object
+    struct {
+        uint16_t        *head;                              // first object in each bucket
+        uint16_t        mask;                               // number of buckets minus one
+    } _hash;
+
+    // queue and database throughput since last logged
+    struct {
+        uint32_t        pushed;                             // objects pushed into the queue
+        uint32_t        queue_full;                         // objects dropped because the queue was full
+        uint32_t        added;                              // objects added to the database
+        uint32_t        refreshed;                          // objects which refreshed a close object already in the database
+        uint32_t        database_full;                      // objects dropped because the database was full
+        uint32_t        expired;                            // objects removed from the database because they expired
+    } _stats;
+    uint32_t _stats_last_log_ms;                            // system time stats were last logged
+
     uint16_t _next_index_to_send[MAVLINK_COMM_NUM_BUFFERS]; // index of next object in _database to send to GCS
     uint16_t _highest_index_sent[MAVLINK_COMM_NUM_BUFFERS]; // highest index in _database sent to GCS
     uint32_t _last_send_to_gcs_ms[MAVLINK_COMM_NUM_BUFFERS];// system time that send_adsb_vehicle was last called
@@ -37,6 +37,10 @@ AP_OADijkstra::AP_OADijkstra(AP_Int16 &options) :
         _inclusion_polygon_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _exclusion_polygon_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _exclusion_circle_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
+        _fence_visible_a(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
+        _fence_visible_b(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
+        _visgraph_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
+        _fence_shapes(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _short_path_data(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _path(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _options(options)
@@ -620,9 +624,18 @@ bool AP_OADijkstra::intersects_fence(const Vector2f &seg_start, const Vector2f &
     // determine if segment crosses any of the inclusion polygons
     uint16_t num_points = 0;
     for (uint8_t i = 0; i < fence->polyfence().get_inclusion_polygon_count(); i++) {
+        Vector2f intersection;
+#if AC_POLYFENCE_INDEX_ENABLED
+        const Polygon_index<float> *index = fence->polyfence().get_inclusion_polygon_index(i);
+        if (index != nullptr) {
+            if (Polygon_intersects(*index, seg_start, seg_end, intersection)) {
+                return true;
+            }
+            continue;
+        }
+#endif
         const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
         if (boundary != nullptr) {
-            Vector2f intersection;
             if (Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection)) {
                 return true;
             }
@@ -631,9 +644,18 @@ bool AP_OADijkstra::intersects_fence(const Vector2f &seg_start, const Vector2f &
 
     // determine if segment crosses any of the exclusion polygons
     for (uint8_t i = 0; i < fence->polyfence().get_exclusion_polygon_count(); i++) {
+        Vector2f intersection;
+#if AC_POLYFENCE_INDEX_ENABLED
+        const Polygon_index<float> *index = fence->polyfence().get_exclusion_polygon_index(i);
+        if (index != nullptr) {
+            if (Polygon_intersects(*index, seg_start, seg_end, intersection)) {
+                return true;
+            }
+            continue;
+        }
+#endif
         const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
         if (boundary != nullptr) {
-            Vector2f intersection;
             if (Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection)) {
                 return true;
             }
@@ -675,9 +697,113 @@ bool AP_OADijkstra::intersects_fence(const Vector2f &seg_start, const Vector2f &
     return false;
 }
 
+// record the fence shapes the visibility graph is built from and find
+// the area covered by those which changed since the last build.
+// Only lines through that area can have changed visibility, except when
+// an inclusion circle changes which can affect any line.
+// returns false if out of memory
+bool AP_OADijkstra::update_fence_shapes(bool &all_changed, Vector2f &changed_min, Vector2f &changed_max)
+{
+    const AC_PolyFence_loader &polyfence = AC_Fence::get_singleton()->polyfence();
+
+    all_changed = false;
+    changed_min = Vector2f{FLT_MAX, FLT_MAX};
+    changed_max = Vector2f{-FLT_MAX, -FLT_MAX};
+
+    // grow the changed area to hold a shape
+    auto add_changed = [&](const FenceShape &shape) {
+        if (shape.type == uint8_t(AC_PolyFenceType::CIRCLE_INCLUSION)) {
+            all_changed = true;
+        }
+        changed_min.x = MIN(changed_min.x, shape.box_min.x);
+        changed_min.y = MIN(changed_min.y, shape.box_min.y);
+        changed_max.x = MAX(changed_max.x, shape.box_max.x);
+        changed_max.y = MAX(changed_max.y, shape.box_max.y);
+    };
+
+    // compare a shape with the one recorded in the same place by the last build
+    uint16_t num_shapes = 0;
+    auto add_shape = [&](const FenceShape &shape) {
+        if (!_fence_shapes.expand_to_hold(num_shapes + 1)) {
+            return false;
+        }
+        FenceShape &prev = _fence_shapes[num_shapes];
+        if (num_shapes >= _fence_shapes_num ||
+            prev.type != shape.type || prev.crc != shape.crc ||
+            prev.box_min != shape.box_min || prev.box_max != shape.box_max) {
+            if (num_shapes < _fence_shapes_num) {
+                add_changed(prev);
+            }
+            add_changed(shape);
+            prev = shape;
+        }
+        num_shapes++;
+        return true;
+    };
+
+    // polygons
+    for (uint8_t kind = 0; kind < 2; kind++) {
+        const bool inclusion = (kind == 0);
+        const uint8_t count = inclusion ? polyfence.get_inclusion_polygon_count() : polyfence.get_exclusion_polygon_count();
+        for (uint8_t i = 0; i < count; i++) {
+            uint16_t num_points;
+            const Vector2f* boundary = inclusion ? polyfence.get_inclusion_polygon(i, num_points) : polyfence.get_exclusion_polygon(i, num_points);
+            if (boundary == nullptr || num_points == 0) {
+                continue;
+            }
+            FenceShape shape {};
+            shape.type = uint8_t(inclusion ? AC_PolyFenceType::POLYGON_INCLUSION : AC_PolyFenceType::POLYGON_EXCLUSION);
+            shape.crc = crc32_small(0, (const uint8_t *)boundary, num_points * sizeof(Vector2f));
+            shape.box_min = shape.box_max = boundary[0];
+            for (uint16_t j = 1; j < num_points; j++) {
+                shape.box_min.x = MIN(shape.box_min.x, boundary[j].x);
+                shape.box_min.y = MIN(shape.box_min.y, boundary[j].y);
+                shape.box_max.x = MAX(shape.box_max.x, boundary[j].x);
+                shape.box_max.y = MAX(shape.box_max.y, boundary[j].y);
+            }
+            if (!add_shape(shape)) {
+                return false;
+            }
+        }
+    }
+
+    // circles
+    for (uint8_t kind = 0; kind < 2; kind++) {
+        const bool inclusion = (kind == 0);
+        const uint8_t count = inclusion ? polyfence.get_inclusion_circle_count() : polyfence.get_exclusion_circle_count();
+        for (uint8_t i = 0; i < count; i++) {
+            Vector2f center_pos_cm;
+            float radius;
+            if (!(inclusion ? polyfence.get_inclusion_circle(i, center_pos_cm, radius) : polyfence.get_exclusion_circle(i, center_pos_cm, radius))) {
+                continue;
+            }
+            const float radius_cm = radius * 100.0f;
+            FenceShape shape {};
+            shape.type = uint8_t(inclusion ? AC_PolyFenceType::CIRCLE_INCLUSION : AC_PolyFenceType::CIRCLE_EXCLUSION);
+            shape.crc = crc32_small(0, (const uint8_t *)&center_pos_cm, sizeof(center_pos_cm));
+            shape.crc = crc32_small(shape.crc, (const uint8_t *)&radius_cm, sizeof(radius_cm));
+            shape.box_min = center_pos_cm - Vector2f{radius_cm, radius_cm};
+            shape.box_max = center_pos_cm + Vector2f{radius_cm, radius_cm};
+            if (!add_shape(shape)) {
+                return false;
+            }
+        }
+    }
+
+    // shapes which have been removed
+    for (uint16_t i = num_shapes; i < _fence_shapes_num; i++) {
+        add_changed(_fence_shapes[i]);
+    }
+    _fence_shapes_num = num_shapes;
+
+    return true;
+}
+
 // create visibility graph for all fence (with margin) points
 // returns true on success.  returns false on failure and err_id is updated
 // requires these functions to have been run create_inclusion_polygon_with_margin, create_exclusion_polygon_with_margin, create_exclusion_circle_with_margin
+// lines between points which were in the previous graph are only
+// tested again if they pass near a part of the fence which has changed
 bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
 {
     // exit immediately if fence is not enabled
@@ -688,36 +814,105 @@ bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
     }
 
     // fail if more fence points than algorithm can handle
-    if (total_numpoints() >= OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) {
+    const uint16_t numpoints = total_numpoints();
+    if (numpoints >= OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_TOO_MANY_FENCE_POINTS;
         return false;
     }
 
-    // clear fence points visibility graph
-    _fence_visgraph.clear();
+    // the destination's graph must be created again
+    _destination_visgraph_ok = false;
+
+    // find the parts of the fence which have changed
+    bool all_changed;
+    Vector2f changed_min, changed_max;
+    if (!update_fence_shapes(all_changed, changed_min, changed_max)) {
+        _fence_shapes_num = 0;
+        _visgraph_numpoints = 0;
+        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+        return false;
+    }
 
-    // calculate distance from each point to all other points
-    for (uint8_t i = 0; i < total_numpoints() - 1; i++) {
+    // the old graph is swapped in as the previous graph below. Until
+    // then any failure must leave nothing to be reused
+    const uint16_t prev_numpoints = _visgraph_numpoints;
+    const uint16_t prev_words = visible_row_words(prev_numpoints);
+    _visgraph_numpoints = 0;
+
+    // find each point's index in the previous graph, points not
+    // moved by the change are normally in the same order
+    uint8_t prev_idx[OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX];
+    uint16_t hint = 0;
+    for (uint16_t i = 0; i < numpoints; i++) {
+        prev_idx[i] = OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX;
+        Vector2f point;
+        if (all_changed || !get_point(i, point)) {
+            continue;
+        }
+        for (uint16_t k = 0; k < prev_numpoints; k++) {
+            const uint16_t j = (hint + k) % prev_numpoints;
+            if (_visgraph_pts[j].x == point.x && _visgraph_pts[j].y == point.y) {
+                prev_idx[i] = j;
+                hint = j + 1;
+                break;
+            }
+        }
+    }
+
+    // the new graph is built in the array holding the oldest graph
+    AP_ExpandingArray<uint32_t> *prev_visible = _fence_visible;
+    AP_ExpandingArray<uint32_t> *visible = _fence_visible_prev;
+    const uint16_t words = visible_row_words(numpoints);
+    if (!visible->expand_to_hold(numpoints * words)) {
+        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+        return false;
+    }
+    for (uint16_t i = 0; i < numpoints * words; i++) {
+        (*visible)[i] = 0;
+    }
+
+    // test visibility between each pair of points
+    for (uint16_t i = 0; i < numpoints; i++) {
         Vector2f start_seg;
-        if (get_point(i, start_seg)) {
-            for (uint8_t j = i + 1; j < total_numpoints(); j++) {
-                Vector2f end_seg;
-                if (get_point(j, end_seg)) {
-                    // if line segment does not intersect with any inclusion or exclusion zones add to visgraph
-                    if (!intersects_fence(start_seg, end_seg)) {
-                        if (!_fence_visgraph.add_item({AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i},
-                                                      {AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, j},
-                                                      (start_seg - end_seg).length())) {
-                            // failure to add a point can only be caused by out-of-memory
-                            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
-                            return false;
-                        }
-                    }
-                }
+        if (!get_point(i, start_seg)) {
+            continue;
+        }
+        const uint8_t prev_i = prev_idx[i];
+        for (uint16_t j = i + 1; j < numpoints; j++) {
+            Vector2f end_seg;
+            if (!get_point(j, end_seg)) {
+                continue;
+            }
+            const uint8_t prev_j = prev_idx[j];
+            bool visible_ij;
+            if (prev_i != OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX && prev_j != OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX &&
+                (MAX(start_seg.x, end_seg.x) < changed_min.x || MIN(start_seg.x, end_seg.x) > changed_max.x ||
+                 MAX(start_seg.y, end_seg.y) < changed_min.y || MIN(start_seg.y, end_seg.y) > changed_max.y)) {
+                // line is clear of all changes so is unchanged
+                visible_ij = ((*prev_visible)[prev_i * prev_words + prev_j / 32] & (1U << (prev_j % 32))) != 0;
+            } else {
+                // line segment is visible if it does not intersect with any inclusion or exclusion zones
+                visible_ij = !intersects_fence(start_seg, end_seg);
+            }
+            if (visible_ij) {
+                (*visible)[i * words + j / 32] |= 1U << (j % 32);
+                (*visible)[j * words + i / 32] |= 1U << (i % 32);
             }
         }
     }
 
+    // keep the points so the next build can find unchanged lines
+    if (!_visgraph_pts.expand_to_hold(numpoints)) {
+        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+        return false;
+    }
+    for (uint16_t i = 0; i < numpoints; i++) {
+        get_point(i, _visgraph_pts[i]);
+    }
+    _fence_visible = visible;
+    _fence_visible_prev = prev_visible;
+    _visgraph_numpoints = numpoints;
+
     return true;
 }
 
@@ -767,36 +962,42 @@ void AP_OADijkstra::update_visible_node_distances(node_index curr_node_idx)
     // get current node for convenience
     const ShortPathNode &curr_node = _short_path_data[curr_node_idx];
 
-    // for each visibility graph
-    const AP_OAVisGraph* visgraphs[] = {&_fence_visgraph, &_destination_visgraph};
-    for (uint8_t v=0; v<ARRAY_SIZE(visgraphs); v++) {
-
-        // skip if empty
-        const AP_OAVisGraph &curr_visgraph = *visgraphs[v];
-        if (curr_visgraph.num_items() == 0) {
-            continue;
+    // only fence points are expanded, the search starts from the
+    // source and stops on reaching the destination
+    if (curr_node.id.id_type != AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT) {
+        return;
+    }
+    const uint8_t curr_point = curr_node.id.id_num;
+    const Vector2f &curr_pos = _visgraph_pts[curr_point];
+
+    // update distance to a node if it is shorter via the current node
+    auto update_distance = [&](node_index item_node_idx, float distance_cm) {
+        const float dist_to_item_via_current_node = curr_node.distance_cm + distance_cm;
+        if (dist_to_item_via_current_node < _short_path_data[item_node_idx].distance_cm) {
+            // update item's distance and set "distance_from_idx" to current node's index
+            _short_path_data[item_node_idx].distance_cm = dist_to_item_via_current_node;
+            _short_path_data[item_node_idx].distance_from_idx = curr_node_idx;
         }
+    };
 
-        // search visibility graph for items visible from current_node
-        for (uint16_t i = 0; i < curr_visgraph.num_items(); i++) {
-            const AP_OAVisGraph::VisGraphItem &item = curr_visgraph[i];
-            // match if current node's id matches either of the id's in the graph (i.e. either end of the vector)
-            if ((curr_node.id == item.id1) || (curr_node.id == item.id2)) {
-                AP_OAVisGraph::OAItemID matching_id = (curr_node.id == item.id1) ? item.id2 : item.id1;
-                // find item's id in node array
-                node_index item_node_idx;
-                if (find_node_from_id(matching_id, item_node_idx)) {
-                    // if current node's distance + distance to item is less than item's current distance, update item's distance
-                    const float dist_to_item_via_current_node = _short_path_data[curr_node_idx].distance_cm + item.distance_cm;
-                    if (dist_to_item_via_current_node < _short_path_data[item_node_idx].distance_cm) {
-                        // update item's distance and set "distance_from_idx" to current node's index
-                        _short_path_data[item_node_idx].distance_cm = dist_to_item_via_current_node;
-                        _short_path_data[item_node_idx].distance_from_idx = curr_node_idx;
-                    }
-                }
+    // fence points visible from the current node, from its row of the visibility graph
+    const uint16_t words = visible_row_words(_visgraph_numpoints);
+    for (uint16_t w = 0; w < words; w++) {
+        uint32_t bits = (*_fence_visible)[curr_point * words + w];
+        while (bits != 0) {
+            const uint8_t point = w * 32 + __builtin_ctz(bits);
+            bits &= bits - 1;
+            const node_index item_node_idx = point + 2;
+            if (!_short_path_data[item_node_idx].visited) {
+                update_distance(item_node_idx, (curr_pos - _visgraph_pts[point]).length());
             }
         }
     }
+
+    // destination
+    if (curr_node.destination_cm < FLT_MAX) {
+        update_distance(1, curr_node.destination_cm);
+    }
 }
 
 // find a node's index into _short_path_data array from it's id (i.e. id type and id number)
@@ -845,18 +1046,9 @@ bool AP_OADijkstra::find_closest_node_idx(node_index &node_idx) const
             // if node is already visited OR cannot be reached yet, we can't use it
             continue;
         }
-        // figure out the pos of this node
-        Vector2f node_pos;
-        float dist_with_heuristics = FLT_MAX;
-        if (convert_node_to_point(node.id, node_pos)) {
-            // heuristics is is simple Euclidean distance from the node to the destination
-            // This should be admissible, therefore optimal path is guaranteed
-            const float heuristics = (node_pos-_path_destination).length();
-            dist_with_heuristics = node.distance_cm + heuristics;
-        } else {
-            // shouldn't happen
-            return false;
-        }
+        // heuristics is is simple Euclidean distance from the node to the destination
+        // This should be admissible, therefore optimal path is guaranteed
+        const float dist_with_heuristics = node.distance_cm + node.heuristic_cm;
         if (dist_with_heuristics < lowest_dist) {
             // for NOW, this is the closest node
             lowest_idx = i;
@@ -889,25 +1081,39 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
         return false;
     }
-    if (!update_visgraph(_destination_visgraph, {AP_OAVisGraph::OATYPE_DESTINATION, 0}, _path_destination)) {
-        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
-        return false;
+    // destination's graph is unchanged until the destination or fence changes
+    if (!_destination_visgraph_ok || (_destination_visgraph_pos != _path_destination)) {
+        if (!update_visgraph(_destination_visgraph, {AP_OAVisGraph::OATYPE_DESTINATION, 0}, _path_destination)) {
+            _destination_visgraph_ok = false;
+            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+            return false;
+        }
+        _destination_visgraph_pos = _path_destination;
+        _destination_visgraph_ok = true;
     }
 
     // expand _short_path_data if necessary
-    if (!_short_path_data.expand_to_hold(2 + total_numpoints())) {
+    if (!_short_path_data.expand_to_hold(2 + _visgraph_numpoints)) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
         return false;
     }
 
-    // add origin and destination (node_type, id, visited, distance_from_idx, distance_cm) to short_path_data array
-    _short_path_data[0] = {{AP_OAVisGraph::OATYPE_SOURCE, 0}, false, 0, 0};
-    _short_path_data[1] = {{AP_OAVisGraph::OATYPE_DESTINATION, 0}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX};
+    // add origin and destination (node_type, id, visited, distance_from_idx, distance_cm, heuristic_cm, destination_cm) to short_path_data array
+    _short_path_data[0] = {{AP_OAVisGraph::OATYPE_SOURCE, 0}, false, 0, 0, (_path_source - _path_destination).length(), FLT_MAX};
+    _short_path_data[1] = {{AP_OAVisGraph::OATYPE_DESTINATION, 0}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX, 0, 0};
     _short_path_data_numpoints = 2;
 
-    // add all inclusion and exclusion fence points to short_path_data array (node_type, id, visited, distance_from_idx, distance_cm)
-    for (uint8_t i=0; i<total_numpoints(); i++) {
-        _short_path_data[_short_path_data_numpoints++] = {{AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX};
+    // add all inclusion and exclusion fence points to short_path_data array (node_type, id, visited, distance_from_idx, distance_cm, heuristic_cm, destination_cm)
+    for (uint8_t i=0; i<_visgraph_numpoints; i++) {
+        _short_path_data[_short_path_data_numpoints++] = {{AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX, (_visgraph_pts[i] - _path_destination).length(), FLT_MAX};
+    }
+
+    // record distance to the destination from the fence points it is visible from
+    for (uint16_t i = 0; i < _destination_visgraph.num_items(); i++) {
+        node_index node_idx;
+        if (find_node_from_id(_destination_visgraph[i].id2, node_idx)) {
+            _short_path_data[node_idx].destination_cm = _destination_visgraph[i].distance_cm;
+        }
     }
 
     // start algorithm from source point
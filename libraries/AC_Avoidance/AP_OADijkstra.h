@@ -123,6 +123,12 @@ private:
     // returns true on success.  returns false on failure and err_id is updated
     bool create_fence_visgraph(AP_OADijkstra_Error &err_id);
 
+    // record the fence shapes the visibility graph is built from and
+    // find the area covered by those which changed since the last
+    // build.  all_changed is set if any line may need testing again.
+    // returns false if out of memory
+    bool update_fence_shapes(bool &all_changed, Vector2f &changed_min, Vector2f &changed_max);
+
     // calculate shortest path from origin to destination
     // returns true on success.  returns false on failure and err_id is updated
     // requires create_polygon_fence_with_margin and create_polygon_fence_visgraph to have been run
@@ -157,10 +163,34 @@ private:
     uint8_t _exclusion_circle_numpoints;    // number of points held in above array
     uint32_t _exclusion_circle_update_ms;   // system time exclusion circles were updated (used to detect changes)
 
-    // visibility graphs
-    AP_OAVisGraph _fence_visgraph;          // holds distances between all inclusion/exclusion fence points (with margin)
+    // fence visibility graph, a matrix of bits with one row per fence
+    // point (with margin), bit j of row i set if point j is visible
+    // from point i. The graph last built is kept so that when the
+    // fence changes only lines near the changes are tested again
+    AP_ExpandingArray<uint32_t> _fence_visible_a;
+    AP_ExpandingArray<uint32_t> _fence_visible_b;
+    AP_ExpandingArray<uint32_t> *_fence_visible = &_fence_visible_a;
+    AP_ExpandingArray<uint32_t> *_fence_visible_prev = &_fence_visible_b;
+    AP_ExpandingArray<Vector2f> _visgraph_pts;  // fence points the visibility graph was built from
+    uint8_t _visgraph_numpoints;                // number of points in the visibility graph
+
+    // words in each row of a visibility matrix of numpoints points
+    static uint16_t visible_row_words(uint16_t numpoints) { return (numpoints + 31) / 32; }
+
+    // fence shapes the visibility graph was built from
+    struct FenceShape {
+        uint8_t type;       // AC_PolyFenceType of the shape
+        uint32_t crc;       // crc of the shape's points, or centre and radius
+        Vector2f box_min;   // bounding box of the shape (offsets in cm from EKF origin)
+        Vector2f box_max;
+    };
+    AP_ExpandingArray<FenceShape> _fence_shapes;
+    uint16_t _fence_shapes_num;
+
     AP_OAVisGraph _source_visgraph;         // holds distances from source point to all other nodes
     AP_OAVisGraph _destination_visgraph;    // holds distances from the destination to all other nodes
+    bool _destination_visgraph_ok;          // true if _destination_visgraph is valid for _path_destination
+    Vector2f _destination_visgraph_pos;     // destination _destination_visgraph was created for (offset in cm from EKF origin)
 
     // updates visibility graph for a given position which is an offset (in cm) from the ekf origin
     // to add an additional position (i.e. the destination) set add_extra_position = true and provide the position in the extra_position argument
@@ -174,6 +204,8 @@ private:
         bool visited;                   // true if all this node's neighbour's distances have been updated
         node_index distance_from_idx;   // index into _short_path_data from where distance was updated (or 255 if not set)
         float distance_cm;              // distance from source (number is tentative until this node is the current node and/or visited = true)
+        float heuristic_cm;             // straight line distance to the destination
+        float destination_cm;           // distance to the destination if visible from this node, FLT_MAX if not
     };
     AP_ExpandingArray<ShortPathNode> _short_path_data;
     node_index _short_path_data_numpoints;  // number of elements in _short_path_data array
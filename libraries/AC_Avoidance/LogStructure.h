@@ -7,7 +7,8 @@
     LOG_OA_BENDYRULER_MSG, \
     LOG_OA_DIJKSTRA_MSG, \
     LOG_SIMPLE_AVOID_MSG, \
-    LOG_OD_VISGRAPH_MSG
+    LOG_OD_VISGRAPH_MSG, \
+    LOG_OA_DATABASE_MSG
 
 // @LoggerMessage: OABR
 // @Description: Object avoidance (Bendy Ruler) diagnostics
@@ -107,6 +108,28 @@ struct PACKED log_OD_Visgraph {
   int32_t Lon;
 };
 
+// @LoggerMessage: OADB
+// @Description: Object avoidance database throughput
+// @Field: TimeUS: Time since system startup
+// @Field: Cnt: Number of objects in the database
+// @Field: Push: Objects pushed into the queue since the last message
+// @Field: QDrop: Objects dropped since the last message because the queue was full
+// @Field: Add: Objects added to the database since the last message
+// @Field: Ref: Objects since the last message which refreshed a close object already in the database
+// @Field: DDrop: Objects dropped since the last message because the database was full
+// @Field: Exp: Objects expired since the last message
+struct PACKED log_OADatabase {
+  LOG_PACKET_HEADER;
+  uint64_t time_us;
+  uint16_t count;
+  uint32_t pushed;
+  uint32_t queue_full;
+  uint32_t added;
+  uint32_t refreshed;
+  uint32_t database_full;
+  uint32_t expired;
+};
+
 #if AP_AVOIDANCE_ENABLED
 #define LOG_STRUCTURE_FROM_AVOIDANCE \
     { LOG_OA_BENDYRULER_MSG, sizeof(log_OABendyRuler), \
@@ -116,7 +139,9 @@ struct PACKED log_OD_Visgraph {
     { LOG_SIMPLE_AVOID_MSG, sizeof(log_SimpleAvoid), \
       "SA",  "QBffffffB","TimeUS,State,DVelX,DVelY,DVelZ,MVelX,MVelY,MVelZ,Back", "s-nnnnnn-", "F--------", true }, \
      { LOG_OD_VISGRAPH_MSG, sizeof(log_OD_Visgraph), \
-      "OAVG", "QBBLL", "TimeUS,version,point_num,Lat,Lon", "s--DU", "F--GG", true},
+      "OAVG", "QBBLL", "TimeUS,version,point_num,Lat,Lon", "s--DU", "F--GG", true}, \
+    { LOG_OA_DATABASE_MSG, sizeof(log_OADatabase), \
+      "OADB", "QHIIIIII", "TimeUS,Cnt,Push,QDrop,Add,Ref,DDrop,Exp", "s-------", "F-------", true },
 #else
 #define LOG_STRUCTURE_FROM_AVOIDANCE
 #endif // AP_AVOIDANCE_ENABLED
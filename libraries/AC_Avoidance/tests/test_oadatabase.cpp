@@ -0,0 +1,271 @@
+#include <AP_gtest.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AC_Avoidance/AP_OADatabase.h>
+#include <AP_Logger/AP_Logger.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+#include <stdlib.h>
+#include <vector>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+const struct AP_Param::GroupInfo        GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+#if AP_OADATABASE_ENABLED
+
+#define OA_DB_TEST_SIZE         300     // database size
+#define OA_DB_TEST_STEPS        20000   // number of updates in each test
+#define OA_DB_TEST_STEP_MS      7       // system time between updates
+#define OA_DB_INDEX_NONE        0xFFFF
+
+// stats are logged once a second, a logger without backends drops them
+static AP_Logger logger;
+static AP_OADatabase oadb;
+
+// the database as found by comparing a new object with every object
+// in turn, kept in the same order as the database adds them
+class OADatabase_Reference
+{
+public:
+    struct Item {
+        Vector3f pos;
+        uint32_t timestamp_ms;
+        float radius;
+    };
+
+    void push(const Vector3f &pos, uint32_t timestamp_ms, float radius)
+    {
+        for (Item &item : items) {
+            const float distance_sq = (item.pos - pos).length_squared();
+            if (distance_sq < sq(radius) || distance_sq < sq(item.radius)) {
+                if (!is_equal(item.radius, radius) || timestamp_ms - item.timestamp_ms >= 500) {
+                    item.timestamp_ms = timestamp_ms;
+                    item.radius = radius;
+                }
+                return;
+            }
+        }
+        if (items.size() < OA_DB_TEST_SIZE) {
+            items.push_back({pos, timestamp_ms, radius});
+        }
+    }
+
+    std::vector<Item> items;
+};
+
+class AP_OADatabase_Test
+{
+public:
+    AP_OADatabase_Test(AP_OADatabase &_db) : db(_db) {}
+
+    // set up the database once, the same object is used by every test
+    void init(int8_t expiry_seconds)
+    {
+        if (!db.healthy()) {
+            db._database_size_param.set(OA_DB_TEST_SIZE);
+            db._queue_size_param.set(200);
+            db._beam_width.set(5);
+            db._radius_min.set(0.01f);
+            db._dist_max.set(0);
+            db._min_alt.set(0);
+            db._output_level.set(AP_OADatabase::OutputLevel::NONE);
+            db.init();
+        }
+        db._database_expiry_seconds.set(expiry_seconds);
+        while (db._database.count > 0) {
+            db.database_item_remove(0);
+        }
+    }
+
+    float radius(float distance) const
+    {
+        return MAX(db._radius_min, distance * db.dist_to_radius_scalar);
+    }
+
+    // true if the hash holds each object once, in the bucket of its
+    // position, and the expiry list holds each object once, ordered
+    // oldest to newest with none older than the expiry time
+    ::testing::AssertionResult links_valid(uint32_t now_ms) const
+    {
+        const uint16_t count = db._database.count;
+        std::vector<uint8_t> seen(count);
+        for (uint32_t b=0; b<=db._hash.mask; b++) {
+            uint16_t steps = 0;
+            for (uint16_t i=db._hash.head[b]; i!=OA_DB_INDEX_NONE; i=db._database.links[i].hash_next) {
+                if (i >= count || ++steps > count) {
+                    return ::testing::AssertionFailure() << "bucket " << b << " holds index " << i;
+                }
+                int32_t x, y, z;
+                db.hash_cell(db._database.items[i].pos, x, y, z);
+                if (db.hash_bucket(x, y, z) != b) {
+                    return ::testing::AssertionFailure() << "object " << i << " in wrong bucket " << b;
+                }
+                seen[i]++;
+            }
+        }
+        for (uint16_t i=0; i<count; i++) {
+            if (seen[i] != 1) {
+                return ::testing::AssertionFailure() << "object " << i << " in hash " << unsigned(seen[i]) << " times";
+            }
+        }
+
+        const uint32_t expiry_ms = uint32_t(db._database_expiry_seconds) * 1000;
+        uint16_t listed = 0;
+        uint16_t prev = OA_DB_INDEX_NONE;
+        for (uint16_t i=db._database.oldest; i!=OA_DB_INDEX_NONE; i=db._database.links[i].newer) {
+            if (i >= count || ++listed > count) {
+                return ::testing::AssertionFailure() << "expiry list holds index " << i;
+            }
+            if (db._database.links[i].older != prev) {
+                return ::testing::AssertionFailure() << "object " << i << " links back to " << db._database.links[i].older;
+            }
+            const uint32_t timestamp_ms = db._database.items[i].timestamp_ms;
+            if (prev != OA_DB_INDEX_NONE && int32_t(timestamp_ms - db._database.items[prev].timestamp_ms) < 0) {
+                return ::testing::AssertionFailure() << "object " << i << " listed after a newer object";
+            }
+            if (expiry_ms > 0 && now_ms - timestamp_ms > expiry_ms) {
+                return ::testing::AssertionFailure() << "object " << i << " has expired";
+            }
+            prev = i;
+        }
+        if (listed != count || db._database.newest != prev) {
+            return ::testing::AssertionFailure() << "expiry list holds " << listed << " of " << count << " objects";
+        }
+        return ::testing::AssertionSuccess();
+    }
+
+    // true if the hash finds the same close object as a search of
+    // every object in index order
+    ::testing::AssertionResult search_matches(const Vector3f &pos, float radius) const
+    {
+        AP_OADatabase::OA_DbItem item {};
+        item.pos = pos;
+        item.radius = radius;
+        uint16_t expected = OA_DB_INDEX_NONE;
+        for (uint16_t i=0; i<db._database.count; i++) {
+            if (db.is_close_to_item_in_database(i, item)) {
+                expected = i;
+                break;
+            }
+        }
+        const uint16_t found = db.find_close_item_in_database(item);
+        if (found != expected) {
+            return ::testing::AssertionFailure() << "hash found " << found << ", expected " << expected;
+        }
+        return ::testing::AssertionSuccess();
+    }
+
+private:
+    AP_OADatabase &db;
+};
+
+// objects spread over 20m x 20m x 1m, with distances up to 15m so
+// radii range from the minimum up to about 1.3m
+static Vector3f random_pos()
+{
+    return Vector3f(((rand() % 2000) - 1000) * 0.01f,
+                    ((rand() % 2000) - 1000) * 0.01f,
+                    ((rand() % 100) - 50) * 0.01f);
+}
+
+static float random_distance()
+{
+    return (rand() % 1500) * 0.01f;
+}
+
+static uint32_t now_ms = 1000;
+
+static void advance_clock()
+{
+    now_ms += OA_DB_TEST_STEP_MS;
+    hal.scheduler->stop_clock(uint64_t(now_ms) * 1000);
+}
+
+// push random objects and process them, the way the proximity library
+// and the vehicle's update loop do
+static void push_random_objects(AP_OADatabase_Test &test, OADatabase_Reference *reference)
+{
+    const int n = rand() % 5;
+    for (int k=0; k<n; k++) {
+        const Vector3f pos = random_pos();
+        const float distance = random_distance();
+        const uint32_t timestamp_ms = now_ms - (rand() % 3);
+        oadb.queue_push(pos, timestamp_ms, distance);
+        if (reference != nullptr) {
+            reference->push(pos, timestamp_ms, test.radius(distance));
+        }
+    }
+    while (oadb.process_queue()) {}
+    oadb.update();
+}
+
+// without expiry the database matches a search of every object
+TEST(AP_OADatabase, MatchesLinearSearch)
+{
+    AP_OADatabase_Test test(oadb);
+    test.init(0);
+    ASSERT_TRUE(oadb.healthy());
+    srand(1);
+
+    OADatabase_Reference reference;
+    for (uint32_t step=0; step<OA_DB_TEST_STEPS; step++) {
+        advance_clock();
+        push_random_objects(test, &reference);
+
+        ASSERT_TRUE(test.links_valid(now_ms)) << "step " << step;
+        ASSERT_EQ(oadb.database_count(), reference.items.size()) << "step " << step;
+        for (uint16_t i=0; i<oadb.database_count(); i++) {
+            const AP_OADatabase::OA_DbItem &item = oadb.get_item(i);
+            const OADatabase_Reference::Item &expected = reference.items[i];
+            ASSERT_EQ(item.pos, expected.pos) << "step " << step << " object " << i;
+            ASSERT_EQ(item.timestamp_ms, expected.timestamp_ms) << "step " << step << " object " << i;
+            ASSERT_FLOAT_EQ(item.radius, expected.radius) << "step " << step << " object " << i;
+        }
+        for (uint8_t q=0; q<20; q++) {
+            ASSERT_TRUE(test.search_matches(random_pos(), test.radius(random_distance()))) << "step " << step;
+        }
+    }
+    // the database filled up part way through
+    EXPECT_EQ(oadb.database_count(), OA_DB_TEST_SIZE);
+}
+
+// with expiry objects are removed oldest first, which moves other
+// objects within the arrays, and the hash and list must follow them
+TEST(AP_OADatabase, Expiry)
+{
+    AP_OADatabase_Test test(oadb);
+    test.init(2);
+    ASSERT_TRUE(oadb.healthy());
+    srand(2);
+
+    uint16_t count_max = 0;
+    for (uint32_t step=0; step<OA_DB_TEST_STEPS; step++) {
+        advance_clock();
+        push_random_objects(test, nullptr);
+        count_max = MAX(count_max, oadb.database_count());
+
+        ASSERT_TRUE(test.links_valid(now_ms)) << "step " << step;
+        for (uint8_t q=0; q<20; q++) {
+            ASSERT_TRUE(test.search_matches(random_pos(), test.radius(random_distance()))) << "step " << step;
+        }
+    }
+    // objects were both added and expired
+    EXPECT_GT(count_max, 0U);
+    EXPECT_LT(oadb.database_count(), OA_DB_TEST_SIZE);
+
+    // everything expires once pushes stop
+    for (uint32_t step=0; step<1000; step++) {
+        advance_clock();
+        oadb.update();
+    }
+    EXPECT_EQ(oadb.database_count(), 0U);
+    EXPECT_TRUE(test.links_valid(now_ms));
+}
+
+#endif  // AP_OADATABASE_ENABLED
+
+AP_GTEST_MAIN()
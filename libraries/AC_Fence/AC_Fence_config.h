@@ -19,3 +19,9 @@
 #ifndef AC_POLYFENCE_FENCE_POINT_PROTOCOL_SUPPORT
 #define AC_POLYFENCE_FENCE_POINT_PROTOCOL_SUPPORT 0
 #endif
+
+// grid index over the edges of loaded polygon fences, so fence checks
+// only test the edges near the vehicle
+#ifndef AC_POLYFENCE_INDEX_ENABLED
+#define AC_POLYFENCE_INDEX_ENABLED (BOARD_FLASH_SIZE > 1024)
+#endif
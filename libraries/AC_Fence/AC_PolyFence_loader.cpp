@@ -223,6 +223,18 @@ bool AC_PolyFence_loader::breached() const
     return breached(loc);
 }
 
+// returns true if pos (lat/lng) is outside a loaded polygon
+template <typename Boundary>
+static bool polygon_outside(const Vector2l &pos, const Boundary &boundary)
+{
+#if AC_POLYFENCE_INDEX_ENABLED
+    if (boundary.index_lla.built()) {
+        return boundary.index_lla.outside(pos);
+    }
+#endif
+    return Polygon_outside(pos, boundary.points_lla, boundary.count);
+}
+
 // check if a position (expressed as lat/lng) is within the boundary
 //   returns true if location is outside the boundary
 bool AC_PolyFence_loader::breached(const Location& loc) const
@@ -241,7 +253,7 @@ bool AC_PolyFence_loader::breached(const Location& loc) const
     // check we are inside each inclusion zone:
     for (uint8_t i=0; i<_num_loaded_inclusion_boundaries; i++) {
         const InclusionBoundary &boundary = _loaded_inclusion_boundary[i];
-        if (Polygon_outside(pos, boundary.points_lla, boundary.count)) {
+        if (polygon_outside(pos, boundary)) {
             num_inclusion_outside++;
         }
     }
@@ -249,7 +261,7 @@ bool AC_PolyFence_loader::breached(const Location& loc) const
     // check we are outside each exclusion zone:
     for (uint8_t i=0; i<_num_loaded_exclusion_boundaries; i++) {
         const ExclusionBoundary &boundary = _loaded_exclusion_boundary[i];
-        if (!Polygon_outside(pos, boundary.points_lla, boundary.count)) {
+        if (!polygon_outside(pos, boundary)) {
             return true;
         }
     }
@@ -603,6 +615,20 @@ uint16_t AC_PolyFence_loader::sum_of_polygon_point_counts_and_returnpoint()
     return ret;
 }
 
+#if AC_POLYFENCE_INDEX_ENABLED
+// build the edge indexes of a loaded polygon.  Failure is not fatal;
+// the polygon is then checked edge by edge
+template <typename Boundary>
+static void index_polygon(Boundary &boundary)
+{
+    if (!boundary.index.build(boundary.points, boundary.count) ||
+        !boundary.index_lla.build(boundary.points_lla, boundary.count)) {
+        boundary.index.clear();
+        boundary.index_lla.clear();
+    }
+}
+#endif
+
 bool AC_PolyFence_loader::load_from_eeprom()
 {
     if (!check_indexed()) {
@@ -735,6 +761,9 @@ bool AC_PolyFence_loader::load_from_eeprom()
                 storage_valid = false;
                 break;
             }
+#if AC_POLYFENCE_INDEX_ENABLED
+            index_polygon(boundary);
+#endif
             _num_loaded_inclusion_boundaries++;
             break;
         }
@@ -754,6 +783,9 @@ bool AC_PolyFence_loader::load_from_eeprom()
                 storage_valid = false;
                 break;
             }
+#if AC_POLYFENCE_INDEX_ENABLED
+            index_polygon(boundary);
+#endif
             _num_loaded_exclusion_boundaries++;
             break;
         }
@@ -867,6 +899,17 @@ Vector2f* AC_PolyFence_loader::get_exclusion_polygon(uint16_t index, uint16_t &n
     return boundary.points;
 }
 
+const Polygon_index<float> *AC_PolyFence_loader::get_exclusion_polygon_index(uint16_t index) const
+{
+#if AC_POLYFENCE_INDEX_ENABLED
+    if (index < _num_loaded_exclusion_boundaries &&
+        _loaded_exclusion_boundary[index].index.built()) {
+        return &_loaded_exclusion_boundary[index].index;
+    }
+#endif
+    return nullptr;
+}
+
 /// returns pointer to array of inclusion polygon points and num_points is filled in with the number of points in the polygon
 /// points are offsets in cm from EKF origin in NE frame
 Vector2f* AC_PolyFence_loader::get_inclusion_polygon(uint16_t index, uint16_t &num_points) const
@@ -881,6 +924,17 @@ Vector2f* AC_PolyFence_loader::get_inclusion_polygon(uint16_t index, uint16_t &n
     return boundary.points;
 }
 
+const Polygon_index<float> *AC_PolyFence_loader::get_inclusion_polygon_index(uint16_t index) const
+{
+#if AC_POLYFENCE_INDEX_ENABLED
+    if (index < _num_loaded_inclusion_boundaries &&
+        _loaded_inclusion_boundary[index].index.built()) {
+        return &_loaded_inclusion_boundary[index].index;
+    }
+#endif
+    return nullptr;
+}
+
 /// returns the specified exclusion circle
 /// circle center offsets in cm from EKF origin in NE frame, radius is in meters
 bool AC_PolyFence_loader::get_exclusion_circle(uint8_t index, Vector2f &center_pos_cm, float &radius) const
@@ -1650,6 +1704,8 @@ bool AC_PolyFence_loader::get_item(const uint16_t seq, AC_PolyFenceItem &item) {
 
 Vector2f* AC_PolyFence_loader::get_exclusion_polygon(uint16_t index, uint16_t &num_points) const { return nullptr; }
 Vector2f* AC_PolyFence_loader::get_inclusion_polygon(uint16_t index, uint16_t &num_points) const { return nullptr; }
+const Polygon_index<float> *AC_PolyFence_loader::get_exclusion_polygon_index(uint16_t index) const { return nullptr; }
+const Polygon_index<float> *AC_PolyFence_loader::get_inclusion_polygon_index(uint16_t index) const { return nullptr; }
 
 bool AC_PolyFence_loader::get_exclusion_circle(uint8_t index, Vector2f &center_pos_cm, float &radius) const { return false; }
 bool AC_PolyFence_loader::get_inclusion_circle(uint8_t index, Vector2f &center_pos_cm, float &radius) const { return false; }
@@ -70,6 +70,10 @@ public:
     /// points are offsets in cm from EKF origin in NE frame
     Vector2f* get_exclusion_polygon(uint16_t index, uint16_t &num_points) const;
 
+    /// returns the index of the edges of an exclusion polygon, or
+    /// nullptr if the polygon has not been indexed
+    const Polygon_index<float> *get_exclusion_polygon_index(uint16_t index) const;
+
     /// return system time of last update to the exclusion polygon points
     uint32_t get_exclusion_polygon_update_ms() const {
         return _load_time_ms;
@@ -87,6 +91,10 @@ public:
     /// points are offsets in cm from EKF origin in NE frame
     Vector2f* get_inclusion_polygon(uint16_t index, uint16_t &num_points) const;
 
+    /// returns the index of the edges of an inclusion polygon, or
+    /// nullptr if the polygon has not been indexed
+    const Polygon_index<float> *get_inclusion_polygon_index(uint16_t index) const;
+
     /// return system time of last update to the inclusion polygon points
     uint32_t get_inclusion_polygon_update_ms() const {
         return _load_time_ms;
@@ -287,6 +295,10 @@ private:
         Vector2f *points; // pointer into the _loaded_offsets_from_origin array
         Vector2l *points_lla; // pointer into the _loaded_points_lla array
         uint8_t count; // count of points in the boundary
+#if AC_POLYFENCE_INDEX_ENABLED
+        Polygon_index<float> index; // edges of points
+        Polygon_index<int32_t> index_lla; // edges of points_lla
+#endif
     };
     InclusionBoundary *_loaded_inclusion_boundary;
 
@@ -297,6 +309,10 @@ private:
         Vector2f *points; // pointer into the _loaded_offsets_from_origin array
         Vector2l *points_lla; // pointer into the _loaded_points_lla_lla array
         uint8_t count; // count of points in the boundary
+#if AC_POLYFENCE_INDEX_ENABLED
+        Polygon_index<float> index; // edges of points
+        Polygon_index<int32_t> index_lla; // edges of points_lla
+#endif
     };
     ExclusionBoundary *_loaded_exclusion_boundary;
 
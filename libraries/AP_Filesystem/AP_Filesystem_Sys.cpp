@@ -26,6 +26,11 @@
 #include <AP_CANManager/AP_CANManager.h>
 #include <AP_Scheduler/AP_Scheduler.h>
 #include <AP_Common/ExpandingString.h>
+#include <GCS_MAVLink/GCS_config.h>
+#if HAL_GCS_ENABLED
+#include <GCS_MAVLink/GCS.h>
+#endif
+#include <AP_Scripting/AP_Scripting.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -40,6 +45,15 @@ static const SysFileList sysfs_file_list[] = {
     {"memory.txt"},
     {"uarts.txt"},
     {"timers.txt"},
+#if HAL_GCS_ENABLED
+    {"routes.txt"},
+#endif
+#if AP_MAVLINK_STREAM_BUDGET_ENABLED
+    {"streams.txt"},
+#endif
+#if AP_SCRIPTING_ENABLED
+    {"scripts.txt"},
+#endif
 #if HAL_MAX_CAN_PROTOCOL_DRIVERS
     {"can_log.txt"},
 #endif
@@ -120,6 +134,29 @@ int AP_Filesystem_Sys::open(const char *fname, int flags, bool allow_absolute_pa
     if (strcmp(fname, "timers.txt") == 0) {
         hal.util->timer_info(*r.str);
     }
+#if HAL_GCS_ENABLED
+    if (strcmp(fname, "routes.txt") == 0) {
+        GCS_MAVLINK::routing_info(*r.str);
+    }
+#endif
+#if AP_MAVLINK_STREAM_BUDGET_ENABLED
+    if (strcmp(fname, "streams.txt") == 0) {
+        for (uint8_t i=0; i<gcs().num_gcs(); i++) {
+            const GCS_MAVLINK *link = gcs().chan(i);
+            if (link != nullptr) {
+                link->stream_budget_info(*r.str);
+            }
+        }
+    }
+#endif
+#if AP_SCRIPTING_ENABLED
+    if (strcmp(fname, "scripts.txt") == 0) {
+        AP_Scripting *scripting = AP::scripting();
+        if (scripting != nullptr) {
+            scripting->script_info(*r.str);
+        }
+    }
+#endif
 #if HAL_CANMANAGER_ENABLED
     if (strcmp(fname, "can_log.txt") == 0) {
         AP::can().log_retrieve(*r.str);
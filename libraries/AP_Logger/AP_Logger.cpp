@@ -200,6 +200,15 @@ const AP_Param::GroupInfo AP_Logger::var_info[] = {
     // @RebootRequired: True
     AP_GROUPINFO("_MAX_FILES", 12, AP_Logger, _params.max_log_files, MAX_LOG_FILES),
 
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    // @Param: _FILE_CMPRS
+    // @DisplayName: Compress logs on the file backend
+    // @Description: When enabled, logs on the file backend are written in a compressed form which takes less space on the card and less write bandwidth. Compressed logs start with the characters APLZ. Replay reads them directly; other tools need them decompressed first with Tools/scripts/decompress_log.py. Takes effect when the next log is started.
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("_FILE_CMPRS", 13, AP_Logger, _params.file_compress, 0),
+#endif
+
     AP_GROUPEND
 };
 
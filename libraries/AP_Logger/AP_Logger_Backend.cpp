@@ -99,6 +99,7 @@ void AP_Logger_Backend::periodic_tasks()
 void AP_Logger_Backend::start_new_log_reset_variables()
 {
     _dropped = 0;
+    _dropped_main = 0;
     _startup_messagewriter->reset();
     _front.backend_starting_new_log(this);
     _formats_written.clearall();
@@ -691,6 +692,7 @@ void AP_Logger_Backend::Write_AP_Logger_Stats_File(const struct df_stats &_stats
         LOG_PACKET_HEADER_INIT(LOG_DF_FILE_STATS),
         time_us         : AP_HAL::micros64(),
         dropped         : _dropped,
+        dropped_main    : _dropped_main,
         blocks          : _stats.blocks,
         bytes           : _stats.bytes,
         buf_space_min   : _stats.buf_space_min,
@@ -213,6 +213,8 @@ protected:
     uint16_t _cached_oldest_log;
 
     uint32_t _dropped;
+    // number of the dropped writes which came from the main thread
+    uint32_t _dropped_main;
     // should we rotate when we next stop logging
     bool _rotate_pending;
 
@@ -0,0 +1,278 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  streaming compression of the log byte stream, see
+  AP_Logger_Compression.h for a description of the format
+ */
+
+#include "AP_Logger_Compression.h"
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+
+#include <string.h>
+#include <AP_Math/AP_Math.h>
+#include "LogStructure.h"
+
+const uint8_t AP_Logger_Compression::header[HEADER_LEN] { 'A', 'P', 'L', 'Z', AP_LOGGER_COMPRESSION_VERSION };
+
+AP_Logger_Compression::~AP_Logger_Compression()
+{
+    reset_state();
+}
+
+bool AP_Logger_Compression::is_compressed_header(const uint8_t *buf, uint32_t len)
+{
+    return len >= HEADER_LEN && memcmp(buf, header, HEADER_LEN) == 0;
+}
+
+void AP_Logger_Compression::reset_state()
+{
+    for (uint16_t i=0; i<ARRAY_SIZE(prev); i++) {
+        delete[] prev[i];
+        prev[i] = nullptr;
+    }
+    memset(lengths, 0, sizeof(lengths));
+    lengths[LOG_FORMAT_MSG] = sizeof(struct log_Format);
+}
+
+void AP_Logger_Compression::learn_format(const uint8_t *msg)
+{
+    const struct log_Format &f = *(const struct log_Format *)msg;
+    learn_format(f.type, f.length);
+}
+
+void AP_Logger_Compression::learn_format(uint8_t type, uint8_t length)
+{
+    if (length < LOG_PACKET_HEADER_LEN || lengths[type] == length) {
+        return;
+    }
+    // the previous body no longer matches the message layout
+    delete[] prev[type];
+    prev[type] = nullptr;
+    lengths[type] = length;
+}
+
+uint8_t *AP_Logger_Compression::prev_body(uint8_t type, bool &allocated)
+{
+    allocated = false;
+    if (prev[type] == nullptr) {
+        const uint8_t body_len = lengths[type] - LOG_PACKET_HEADER_LEN;
+        prev[type] = NEW_NOTHROW uint8_t[MAX(body_len, 1)];
+        if (prev[type] == nullptr) {
+            return nullptr;
+        }
+        memset(prev[type], 0, body_len);
+        allocated = true;
+    }
+    return prev[type];
+}
+
+void AP_Logger_Compressor::reset()
+{
+    reset_state();
+    header_written = false;
+    msg_len = 0;
+}
+
+uint32_t AP_Logger_Compressor::compress(const uint8_t *in, uint32_t len, ByteBuffer &out)
+{
+    if (!header_written) {
+        if (out.space() < HEADER_LEN) {
+            return 0;
+        }
+        out.write(header, HEADER_LEN);
+        header_written = true;
+    }
+
+    uint32_t consumed = 0;
+    while (consumed < len) {
+        if (msg_len < LOG_PACKET_HEADER_LEN) {
+            msg[msg_len++] = in[consumed++];
+            if (msg_len < LOG_PACKET_HEADER_LEN) {
+                continue;
+            }
+            if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2 ||
+                lengths[msg[2]] < LOG_PACKET_HEADER_LEN) {
+                // not a message we can describe; slide along a byte
+                msg[0] = msg[1];
+                msg[1] = msg[2];
+                msg_len = 2;
+                resync_bytes++;
+                continue;
+            }
+        }
+        if (msg_len == LOG_PACKET_HEADER_LEN && out.space() < MAX_RECORD_LEN) {
+            // wait for the output to drain before taking the body
+            break;
+        }
+        const uint8_t length = lengths[msg[2]];
+        const uint32_t n = MIN(uint32_t(length - msg_len), len - consumed);
+        memcpy(&msg[msg_len], &in[consumed], n);
+        msg_len += n;
+        consumed += n;
+        if (msg_len == length) {
+            if (msg[2] == LOG_FORMAT_MSG) {
+                // encoding modifies msg, so take the format now and
+                // apply it afterwards, in the order the decoder sees it
+                const struct log_Format &f = *(const struct log_Format *)msg;
+                const uint8_t fmt_type = f.type;
+                const uint8_t fmt_length = f.length;
+                encode_message(out);
+                learn_format(fmt_type, fmt_length);
+            } else {
+                encode_message(out);
+            }
+            msg_len = 0;
+        }
+    }
+    return consumed;
+}
+
+void AP_Logger_Compressor::encode_message(ByteBuffer &out)
+{
+    const uint8_t type = msg[2];
+    const uint8_t body_len = lengths[type] - LOG_PACKET_HEADER_LEN;
+    uint8_t *body = &msg[LOG_PACKET_HEADER_LEN];
+
+    uint16_t r = 0;
+    record[r++] = type;
+
+    if (body_len > 0) {
+        bool allocated;
+        uint8_t *p = prev_body(type, allocated);
+        if (p == nullptr || allocated) {
+            // encode against zeros
+            record[r++] = TOKEN_KEYFRAME;
+        }
+        if (p != nullptr) {
+            for (uint8_t i=0; i<body_len; i++) {
+                const uint8_t b = body[i];
+                body[i] ^= p[i];
+                p[i] = b;
+            }
+        }
+    }
+
+    uint8_t i = 0;
+    while (i < body_len) {
+        uint8_t zeros = 0;
+        while (i+zeros < body_len && body[i+zeros] == 0 && zeros < 128) {
+            zeros++;
+        }
+        if (zeros >= 2) {
+            record[r++] = TOKEN_ZERO_RUN + (zeros - 2);
+            i += zeros;
+            continue;
+        }
+        // literal run, ending at the next pair of zeros
+        const uint8_t start = i;
+        while (i < body_len && i - start < 128) {
+            if (body[i] == 0 && i+1 < body_len && body[i+1] == 0) {
+                break;
+            }
+            i++;
+        }
+        const uint8_t n = i - start;
+        record[r++] = n - 1;
+        memcpy(&record[r], &body[start], n);
+        r += n;
+    }
+
+    out.write(record, r);
+}
+
+int32_t AP_Logger_Decompressor::decompress(const uint8_t *in, uint32_t len, uint8_t *msg, uint8_t &msg_len)
+{
+    if (len == 0) {
+        return 0;
+    }
+    const uint8_t type = in[0];
+    const uint8_t length = lengths[type];
+    if (length < LOG_PACKET_HEADER_LEN) {
+        // no FMT seen for this type
+        return -1;
+    }
+    const uint8_t body_len = length - LOG_PACKET_HEADER_LEN;
+    uint8_t *body = &msg[LOG_PACKET_HEADER_LEN];
+    uint32_t ofs = 1;
+
+    bool keyframe = false;
+    if (body_len > 0) {
+        if (ofs >= len) {
+            return 0;
+        }
+        if (in[ofs] == TOKEN_KEYFRAME) {
+            keyframe = true;
+            ofs++;
+        }
+    }
+
+    uint8_t i = 0;
+    while (i < body_len) {
+        if (ofs >= len) {
+            return 0;
+        }
+        const uint8_t token = in[ofs++];
+        if (token == TOKEN_KEYFRAME) {
+            return -1;
+        }
+        if (token >= TOKEN_ZERO_RUN) {
+            const uint8_t n = token - TOKEN_ZERO_RUN + 2;
+            if (n > body_len - i) {
+                return -1;
+            }
+            memset(&body[i], 0, n);
+            i += n;
+        } else {
+            const uint8_t n = token + 1;
+            if (n > body_len - i) {
+                return -1;
+            }
+            if (ofs + n > len) {
+                return 0;
+            }
+            memcpy(&body[i], &in[ofs], n);
+            ofs += n;
+            i += n;
+        }
+    }
+
+    if (body_len > 0) {
+        bool allocated;
+        uint8_t *p = prev_body(type, allocated);
+        if (p == nullptr) {
+            return -1;
+        }
+        if (keyframe) {
+            memset(p, 0, body_len);
+        }
+        for (i=0; i<body_len; i++) {
+            body[i] ^= p[i];
+            p[i] = body[i];
+        }
+    }
+
+    msg[0] = HEAD_BYTE1;
+    msg[1] = HEAD_BYTE2;
+    msg[2] = type;
+    msg_len = length;
+
+    if (type == LOG_FORMAT_MSG) {
+        learn_format(msg);
+    }
+    return ofs;
+}
+
+#endif  // AP_LOGGER_FILE_COMPRESSION_ENABLED
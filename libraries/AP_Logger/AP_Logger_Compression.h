@@ -0,0 +1,127 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  streaming compression of the log byte stream
+
+  A compressed log starts with the five byte header "APLZ" followed by
+  a format version byte. After that each message is stored as a
+  record holding the message type followed by tokens encoding the
+  message body (everything after the three header bytes) XORed with
+  the body of the previous message of the same type:
+
+    0x00-0x7F: (token+1) literal bytes follow
+    0x80-0xFE: (token-0x7E) zero bytes
+    0xFF:      only valid as the first token; the previous message of
+               this type is taken to be all zeros
+
+  Message lengths are learnt from the FMT messages in the stream, the
+  same way log readers do, so the format is self-describing.
+ */
+#pragma once
+
+#include "AP_Logger_config.h"
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+
+#include <stdint.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_HAL/utility/RingBuffer.h>
+
+#define AP_LOGGER_COMPRESSION_VERSION 1
+
+class AP_Logger_Compression
+{
+public:
+    AP_Logger_Compression() {}
+    ~AP_Logger_Compression();
+
+    CLASS_NO_COPY(AP_Logger_Compression);
+
+    static constexpr uint8_t HEADER_LEN = 5;
+    // largest possible encoded size of a single message
+    static constexpr uint16_t MAX_RECORD_LEN = 260;
+
+    // return true if buf starts with a compressed log header
+    static bool is_compressed_header(const uint8_t *buf, uint32_t len);
+
+protected:
+    static const uint8_t header[HEADER_LEN];
+
+    // forget all message lengths and previous messages
+    void reset_state();
+
+    // record the length of a message type from a FMT message
+    void learn_format(const uint8_t *msg);
+    void learn_format(uint8_t type, uint8_t length);
+
+    // return the previous body of a message type, allocating it if
+    // needed. Sets allocated true if the body is new
+    uint8_t *prev_body(uint8_t type, bool &allocated);
+
+    // length of each message type including the header, 0 if unknown
+    uint8_t lengths[256] {};
+    // body of the last message of each type
+    uint8_t *prev[256] {};
+
+    static constexpr uint8_t TOKEN_ZERO_RUN = 0x80;
+    static constexpr uint8_t TOKEN_KEYFRAME = 0xFF;
+};
+
+class AP_Logger_Compressor : public AP_Logger_Compression
+{
+public:
+    // start a new compressed stream
+    void reset();
+
+    /*
+      compress len bytes of raw log data into out, returning the
+      number of bytes consumed. Partial messages at the end of the
+      input are held until the rest arrives. Less than len is consumed
+      if out fills up
+     */
+    uint32_t compress(const uint8_t *in, uint32_t len, ByteBuffer &out);
+
+    // number of bytes skipped while looking for a message header
+    uint32_t get_resync_bytes() const { return resync_bytes; }
+
+private:
+    // encode the message held in msg to out
+    void encode_message(ByteBuffer &out);
+
+    bool header_written;
+    uint32_t resync_bytes;
+
+    // message being assembled
+    uint8_t msg[256];
+    uint16_t msg_len;
+
+    uint8_t record[MAX_RECORD_LEN];
+};
+
+class AP_Logger_Decompressor : public AP_Logger_Compression
+{
+public:
+    // start a new compressed stream, after the file header
+    void reset() { reset_state(); }
+
+    /*
+      decode one record from in into msg, which must hold 256 bytes.
+      Returns the number of bytes consumed, 0 if the record is
+      incomplete or -1 if the stream is corrupt
+     */
+    int32_t decompress(const uint8_t *in, uint32_t len, uint8_t *msg, uint8_t &msg_len);
+};
+
+#endif  // AP_LOGGER_FILE_COMPRESSION_ENABLED
@@ -94,6 +94,13 @@ void AP_Logger_File::Init()
 
     DEV_PRINTF("AP_Logger_File: buffer size=%u\n", (unsigned)bufsize);
 
+#if AP_LOGGER_FILE_STAGING_ENABLED && !APM_BUILD_TYPE(APM_BUILD_Replay)
+    // without a staging ring all writes go through the semaphore
+    if (!_staging.set_size(MIN(uint32_t(HAL_LOGGER_STAGING_BUFFER_SIZE), bufsize/4))) {
+        DEV_PRINTF("AP_Logger_File: no staging buffer\n");
+    }
+#endif
+
     _initialised = true;
 
     const char* custom_dir = hal.util->get_custom_log_directory();
@@ -187,8 +194,13 @@ void AP_Logger_File::periodic_fullrate()
 
 uint32_t AP_Logger_File::bufferspace_available()
 {
-    const uint32_t space = _writebuf.space();
+    uint32_t space = _writebuf.space();
     const uint32_t crit = critical_message_reserved_space(_writebuf.get_size());
+#if AP_LOGGER_FILE_STAGING_ENABLED
+    // staged data is headed for _writebuf
+    const uint32_t staged = _staging.available();
+    space = (space > staged) ? space - staged : 0;
+#endif
 
     return (space > crit) ? space - crit : 0;
 }
@@ -442,6 +454,20 @@ bool AP_Logger_File::StartNewLogOK() const
 /* Write a block of data at current offset */
 bool AP_Logger_File::_WritePrioritisedBlock(const void *pBuffer, uint16_t size, bool is_critical)
 {
+#if AP_LOGGER_FILE_STAGING_ENABLED
+    /*
+      critical messages (including formats) and the startup messages
+      go straight into _writebuf so they always precede any staged
+      messages which depend on them
+     */
+    if (!is_critical &&
+        !_writing_startup_messages &&
+        _staging.get_size() != 0 &&
+        hal.scheduler->in_main_thread()) {
+        return write_staged(pBuffer, size);
+    }
+#endif
+
     WITH_SEMAPHORE(semaphore);
 
 #if APM_BUILD_TYPE(APM_BUILD_Replay)
@@ -487,6 +513,112 @@ bool AP_Logger_File::_WritePrioritisedBlock(const void *pBuffer, uint16_t size,
     return true;
 }
 
+#if AP_LOGGER_FILE_STAGING_ENABLED
+/*
+  write a block from the main thread into the staging ring. Only the
+  main thread writes to the ring, and all reads are made with the
+  semaphore held, so the ring needs no lock on this path
+ */
+bool AP_Logger_File::write_staged(const void *pBuffer, uint16_t size)
+{
+    if (_staging.space() < size) {
+        // the IO thread has not kept up; drain the ring ourselves
+        WITH_SEMAPHORE(semaphore);
+        drain_staging();
+        if (_staging.space() < size) {
+            _dropped++;
+            _dropped_main++;
+            return false;
+        }
+    }
+    _staging.write((const uint8_t*)pBuffer, size);
+    return true;
+}
+
+/*
+  move everything in the staging ring into _writebuf. The ring only
+  holds whole messages, so it is moved all at once or not at all to
+  avoid interleaving part of a message with writes from other threads
+ */
+void AP_Logger_File::drain_staging(void)
+{
+    const uint32_t nbytes = _staging.available();
+    if (nbytes == 0) {
+        return;
+    }
+    const uint32_t space = _writebuf.space();
+    const uint32_t crit = critical_message_reserved_space(_writebuf.get_size());
+    if (space < crit || space - crit < nbytes) {
+        return;
+    }
+    uint32_t remaining = nbytes;
+    while (remaining > 0) {
+        uint32_t n;
+        const uint8_t *ptr = _staging.readptr(n);
+        if (ptr == nullptr) {
+            break;
+        }
+        n = MIN(n, remaining);
+        _writebuf.write(ptr, n);
+        _staging.advance(n);
+        remaining -= n;
+    }
+    df_stats_gather(nbytes, _writebuf.space());
+}
+#endif  // AP_LOGGER_FILE_STAGING_ENABLED
+
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+/*
+  choose whether the log being started is compressed. Called with
+  write_fd_semaphore held
+ */
+void AP_Logger_File::compression_start(void)
+{
+    _compressing = false;
+    if (!_front._params.file_compress) {
+        return;
+    }
+    if (_compressor == nullptr) {
+        _compressor = NEW_NOTHROW AP_Logger_Compressor;
+    }
+    if (_compressed.get_size() == 0) {
+        // allow a full chunk to accumulate while the next is compressed
+        _compressed.set_size(2*_writebuf_chunk);
+    }
+    if (_compressor == nullptr || _compressed.get_size() == 0) {
+        DEV_PRINTF("AP_Logger_File: no memory for compression\n");
+        return;
+    }
+    _compressor->reset();
+    _compressed.clear();
+    _compressing = true;
+}
+
+/*
+  compress as much of _writebuf as will fit in the compressed
+  buffer. Called with write_fd_semaphore held
+ */
+void AP_Logger_File::compress_writebuf(void)
+{
+    if (!_compressing) {
+        return;
+    }
+    while (_writebuf.available() != 0) {
+        uint32_t n;
+        const uint8_t *ptr = _writebuf.readptr(n);
+        if (ptr == nullptr || n == 0) {
+            break;
+        }
+        const uint32_t consumed = _compressor->compress(ptr, n, _compressed);
+        _writebuf.advance(consumed);
+        if (consumed < n) {
+            // compressed buffer is full
+            break;
+        }
+    }
+}
+#endif  // AP_LOGGER_FILE_COMPRESSION_ENABLED
+
 /*
   find the highest log number
  */
@@ -846,6 +978,16 @@ void AP_Logger_File::start_new_log(void)
     _open_error_ms = 0;
     _write_offset = 0;
     _writebuf.clear();
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    compression_start();
+#endif
+#if AP_LOGGER_FILE_STAGING_ENABLED
+    {
+        // discard anything staged for the previous log
+        WITH_SEMAPHORE(semaphore);
+        _staging.advance(_staging.available());
+    }
+#endif
     write_fd_semaphore.give();
 
     // now update lastlog.txt with the new log number
@@ -883,7 +1025,14 @@ void AP_Logger_File::flush(void)
 #if APM_BUILD_TYPE(APM_BUILD_Replay) || APM_BUILD_TYPE(APM_BUILD_UNKNOWN)
 {
     uint32_t tnow = AP_HAL::millis();
-    while (_write_fd != -1 && _initialised && !recent_open_error() && _writebuf.available()) {
+    while (_write_fd != -1 && _initialised && !recent_open_error() && (_writebuf.available()
+#if AP_LOGGER_FILE_STAGING_ENABLED
+                                                                       || _staging.available()
+#endif
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+                                                                       || _compressed.available()
+#endif
+               )) {
         // convince the IO timer that it really is OK to write out
         // less than _writebuf_chunk bytes:
         if (tnow > 2001) { // avoid resetting _last_write_time to 0
@@ -923,6 +1072,13 @@ void AP_Logger_File::io_timer(void)
         return;
     }
 
+#if AP_LOGGER_FILE_STAGING_ENABLED
+    if (_staging.available() != 0) {
+        WITH_SEMAPHORE(semaphore);
+        drain_staging();
+    }
+#endif
+
     if (_write_fd == -1 || !_initialised || recent_open_error()) {
         return;
     }
@@ -934,7 +1090,18 @@ void AP_Logger_File::io_timer(void)
         write_lastlog_file(log_num);
     }
 
-    uint32_t nbytes = _writebuf.available();
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    if (_compressing && _writebuf.available() != 0 && write_fd_semaphore.take(1)) {
+        compress_writebuf();
+        write_fd_semaphore.give();
+    }
+    // when compressing, the file is written from the compressed buffer
+    ByteBuffer &outbuf = _compressing ? _compressed : _writebuf;
+#else
+    ByteBuffer &outbuf = _writebuf;
+#endif
+
+    uint32_t nbytes = outbuf.available();
     if (nbytes == 0) {
         return;
     }
@@ -966,7 +1133,7 @@ void AP_Logger_File::io_timer(void)
     }
 
     uint32_t size;
-    const uint8_t *head = _writebuf.readptr(size);
+    const uint8_t *head = outbuf.readptr(size);
     nbytes = MIN(nbytes, size);
 
 #if !AP_FILESYSTEM_LITTLEFS_ENABLED
@@ -1015,7 +1182,7 @@ void AP_Logger_File::io_timer(void)
         _last_write_failed = false;
         _last_write_ms = tnow;
         _write_offset += nwritten;
-        _writebuf.advance(nwritten);
+        outbuf.advance(nwritten);
 
         // we know nwritten > 0 so we won't sync if bytes_until_fsync == 0
         if ((uint32_t)nwritten == bytes_until_fsync) {
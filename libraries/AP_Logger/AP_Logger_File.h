@@ -10,9 +10,14 @@
 
 #include <AP_HAL/utility/RingBuffer.h>
 #include "AP_Logger_Backend.h"
+#include "AP_Logger_Compression.h"
 
 #if HAL_LOGGING_FILESYSTEM_ENABLED
 
+#ifndef HAL_LOGGER_STAGING_BUFFER_SIZE
+#define HAL_LOGGER_STAGING_BUFFER_SIZE 8192
+#endif
+
 #ifndef HAL_LOGGER_WRITE_CHUNK_SIZE
 #if AP_FILESYSTEM_LITTLEFS_ENABLED
 #define HAL_LOGGER_WRITE_CHUNK_SIZE 2048
@@ -111,6 +116,26 @@ private:
 
     // write buffer
     ByteBuffer _writebuf{0};
+#if AP_LOGGER_FILE_STAGING_ENABLED
+    /*
+      non-critical writes from the main thread go into this ring
+      without taking the semaphore. It is drained into _writebuf in
+      batches by the IO thread, or by the main thread itself if the
+      ring fills
+     */
+    ByteBuffer _staging{0};
+    bool write_staged(const void *pBuffer, uint16_t size);
+    // move the whole staging ring into _writebuf, semaphore must be held
+    void drain_staging(void);
+#endif
+#if AP_LOGGER_FILE_COMPRESSION_ENABLED
+    // compressed output waiting to be written when _compressing
+    AP_Logger_Compressor *_compressor;
+    ByteBuffer _compressed{0};
+    bool _compressing;
+    void compression_start(void);
+    void compress_writebuf(void);
+#endif
     const uint16_t _writebuf_chunk = HAL_LOGGER_WRITE_CHUNK_SIZE;
     uint32_t _last_write_time;
 
@@ -47,6 +47,16 @@
 
 #endif
 
+// lock-free staging ring for writes from the main thread to the file backend
+#ifndef AP_LOGGER_FILE_STAGING_ENABLED
+#define AP_LOGGER_FILE_STAGING_ENABLED HAL_LOGGING_FILESYSTEM_ENABLED && BOARD_FLASH_SIZE > 1024
+#endif
+
+// optional compressed format for logs written by the file backend
+#ifndef AP_LOGGER_FILE_COMPRESSION_ENABLED
+#define AP_LOGGER_FILE_COMPRESSION_ENABLED HAL_LOGGING_FILESYSTEM_ENABLED && BOARD_FLASH_SIZE > 1024
+#endif
+
 #ifndef HAL_LOGGER_FILE_CONTENTS_ENABLED
 #define HAL_LOGGER_FILE_CONTENTS_ENABLED HAL_LOGGING_FILESYSTEM_ENABLED && !AP_FILESYSTEM_LITTLEFS_ENABLED
 #endif
@@ -223,6 +223,7 @@ struct PACKED log_DSF {
     LOG_PACKET_HEADER;
     uint64_t time_us;
     uint32_t dropped;
+    uint32_t dropped_main;
     uint16_t blocks;
     uint32_t bytes;
     uint32_t buf_space_min;
@@ -318,6 +319,21 @@ struct PACKED log_MAV {
     uint16_t times_full;
 };
 
+struct PACKED log_MAV_Stream {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t chan;
+    uint8_t bucket;
+    uint8_t num_messages;
+    uint8_t weight;
+    uint16_t interval_ms;
+    uint16_t achieved_ms;
+    float stretch;
+    uint16_t demand;
+    uint16_t allocation;
+    uint32_t capacity;
+};
+
 struct PACKED log_RSSI {
     LOG_PACKET_HEADER;
     uint64_t time_us;
@@ -479,6 +495,19 @@ struct PACKED log_TERRAIN {
     float reference_offset;
 };
 
+struct PACKED log_TERRAIN_CACHE {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint16_t cache_size;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t diskwait;
+    uint32_t prefetches;
+    uint32_t disk_reads;
+    uint32_t disk_writes;
+    uint32_t map_reads;
+};
+
 struct PACKED log_ARSP {
     LOG_PACKET_HEADER;
     uint64_t time_us;
@@ -611,6 +640,21 @@ struct PACKED log_Scripting {
     int32_t run_mem;
 };
 
+struct PACKED log_ScriptingStats {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    char name[16];
+    uint32_t runs;
+    float cpu;
+    uint32_t run_p50;
+    uint32_t run_p95;
+    uint32_t run_max;
+    uint32_t mem_p50;
+    uint32_t mem_p95;
+    int32_t mem_max;
+    uint32_t throttled;
+};
+
 struct PACKED log_MotBatt {
     LOG_PACKET_HEADER;
     uint64_t time_us;
@@ -708,6 +752,7 @@ struct PACKED log_VER {
 // @Description: Onboard logging statistics
 // @Field: TimeUS: Time since system startup
 // @Field: Dp: Number of times we rejected a write to the backend
+// @Field: DpM: Number of the rejected writes which came from the main thread
 // @Field: Blk: Current block number
 // @Field: Bytes: Current write offset
 // @Field: FMn: Minimum free space in write buffer in last time period
@@ -779,6 +824,20 @@ struct PACKED log_VER {
 // @Field: ss: stream slowdown is the number of ms being added to each message to fit within bandwidth
 // @Field: tf: times buffer was full when a message was going to be sent
 
+// @LoggerMessage: MAVS
+// @Description: GCS MAVLink stream bucket bandwidth share
+// @Field: TimeUS: Time since system startup
+// @Field: chan: mavlink channel number
+// @Field: Bkt: stream bucket number
+// @Field: NMsg: number of messages in this bucket
+// @Field: Wt: weight of this bucket when sharing the link
+// @Field: Int: requested interval between sends of this bucket
+// @Field: Act: achieved interval between sends of this bucket over the last second, zero if not sent
+// @Field: Str: factor the requested interval is being stretched by to fit the link
+// @Field: Dem: bandwidth this bucket needs at its requested interval
+// @Field: Alloc: bandwidth given to this bucket
+// @Field: Cap: estimated capacity of the link
+
 // @LoggerMessage: MAVC
 // @Description: MAVLink command we have just executed
 // @Field: TimeUS: Time since system startup
@@ -1048,6 +1107,18 @@ struct PACKED log_VER {
 // @Field: Loaded: Number of tiles in memory
 // @Field: ROfs: terrain reference offset for arming altitude
 
+// @LoggerMessage: TERC
+// @Description: Terrain cache statistics
+// @Field: TimeUS: Time since system startup
+// @Field: Size: Number of grid blocks the cache holds
+// @Field: Hit: Number of lookups that found their grid block in the cache
+// @Field: Miss: Number of lookups that had to load their grid block
+// @Field: DWait: Number of height lookups that failed while waiting for the grid block to be read from storage
+// @Field: PFetch: Number of grid blocks loaded ahead of the vehicle
+// @Field: Rd: Number of grid blocks read from storage
+// @Field: Wr: Number of grid blocks written to storage
+// @Field: MRd: Number of grid blocks taken from memory mapped terrain files
+
 // @LoggerMessage: TSYN
 // @Description: Time synchronisation response information
 // @Field: TimeUS: Time since system startup
@@ -1107,6 +1178,20 @@ struct PACKED log_VER {
 // @Field: Total_mem: total memory usage of all scripts
 // @Field: Run_mem: run memory usage
 
+// @LoggerMessage: SCRS
+// @Description: Scripting statistics of one script, written every 10 seconds
+// @Field: TimeUS: Time since system startup
+// @Field: Name: script name
+// @Field: Runs: number of times the script has run
+// @Field: CPU: share of the time since the script was loaded spent running it
+// @Field: RunP50: run time that half of the runs are shorter than, rounded up to a power of two
+// @Field: RunP95: run time that 95% of the runs are shorter than, rounded up to a power of two
+// @Field: RunMax: longest run time
+// @Field: MemP50: memory growth that half of the runs are below, rounded up to a power of two
+// @Field: MemP95: memory growth that 95% of the runs are below, rounded up to a power of two
+// @Field: MemMax: largest memory growth in one run
+// @Field: Thr: number of runs delayed to keep the script within SCR_CPU_BUDGET
+
 // @LoggerMessage: VER
 // @Description: Ardupilot version
 // @Field: TimeUS: Time since system startup
@@ -1199,6 +1284,8 @@ LOG_STRUCTURE_FROM_AVOIDANCE \
       "SIM","QccCfLLffff","TimeUS,Roll,Pitch,Yaw,Alt,Lat,Lng,Q1,Q2,Q3,Q4", "sddhmDU----", "FBBB0GG0000", true }, \
     { LOG_TERRAIN_MSG, sizeof(log_TERRAIN), \
       "TERR","QBLLHffHHf","TimeUS,Status,Lat,Lng,Spacing,TerrH,CHeight,Pending,Loaded,ROfs", "s-DU-mm--m", "F-GG-00--0", true }, \
+    { LOG_TERRAIN_CACHE_MSG, sizeof(log_TERRAIN_CACHE), \
+      "TERC","QHIIIIIII","TimeUS,Size,Hit,Miss,DWait,PFetch,Rd,Wr,MRd", "s--------", "F--------", true }, \
 LOG_STRUCTURE_FROM_ESC_TELEM \
 LOG_STRUCTURE_FROM_SERVO_TELEM \
     { LOG_PIDR_MSG, sizeof(log_PID), \
@@ -1227,11 +1314,13 @@ LOG_STRUCTURE_FROM_HAL \
 LOG_STRUCTURE_FROM_RPM \
 LOG_STRUCTURE_FROM_FENCE \
     { LOG_DF_FILE_STATS, sizeof(log_DSF), \
-      "DSF", "QIHIIII", "TimeUS,Dp,Blk,Bytes,FMn,FMx,FAv", "s--b---", "F--0---" }, \
+      "DSF", "QIIHIIII", "TimeUS,Dp,DpM,Blk,Bytes,FMn,FMx,FAv", "s---b---", "F---0---" }, \
     { LOG_RALLY_MSG, sizeof(log_Rally), \
       "RALY", "QBBLLhB", "TimeUS,Tot,Seq,Lat,Lng,Alt,Flags", "s--DUm-", "F--GGB-" },  \
     { LOG_MAV_MSG, sizeof(log_MAV),   \
       "MAV", "QBHHHBHH",   "TimeUS,chan,txp,rxp,rxdp,flags,ss,tf", "s#----s-", "F-000-C-" },   \
+    { LOG_MAV_STREAM_MSG, sizeof(log_MAV_Stream),   \
+      "MAVS", "QBBBBHHfHHI",   "TimeUS,chan,Bkt,NMsg,Wt,Int,Act,Str,Dem,Alloc,Cap", "s#---ss-BBB", "F----CC-000" },   \
 LOG_STRUCTURE_FROM_VISUALODOM \
     { LOG_OPTFLOW_MSG, sizeof(log_Optflow), \
       "OF",   "QBffff",   "TimeUS,Qual,flowX,flowY,bodyX,bodyY", "s-EEEE", "F-0000" , true }, \
@@ -1255,6 +1344,8 @@ LOG_STRUCTURE_FROM_VISUALODOM \
 LOG_STRUCTURE_FROM_AIS \
     { LOG_SCRIPTING_MSG, sizeof(log_Scripting), \
       "SCR",   "QNIii", "TimeUS,Name,Runtime,Total_mem,Run_mem", "s#sbb", "F-F--", true }, \
+    { LOG_SCRIPTING_STATS_MSG, sizeof(log_ScriptingStats), \
+      "SCRS",  "QNIfIIIIIiI", "TimeUS,Name,Runs,CPU,RunP50,RunP95,RunMax,MemP50,MemP95,MemMax,Thr", "s#-%sssbbb-", "F---FFF----", true }, \
     { LOG_VER_MSG, sizeof(log_VER), \
       "VER",   "QBHBBBBIZHBBII", "TimeUS,BT,BST,Maj,Min,Pat,FWT,GH,FWS,APJ,BU,FV,IMI,ICI", "s-------------", "F-------------", false }, \
     { LOG_MOTBATT_MSG, sizeof(log_MotBatt), \
@@ -1329,6 +1420,8 @@ enum LogMessages : uint8_t {
     LOG_EVENT_MSG,
     LOG_WHEELENCODER_MSG,
     LOG_MAV_MSG,
+    LOG_MAV_STREAM_MSG,
+    LOG_TERRAIN_CACHE_MSG,
     LOG_ERROR_MSG,
     LOG_ADSB_MSG,
     LOG_ARM_DISARM_MSG,
@@ -1339,6 +1432,7 @@ enum LogMessages : uint8_t {
     LOG_STAK_MSG,
     LOG_FILE_MSG,
     LOG_SCRIPTING_MSG,
+    LOG_SCRIPTING_STATS_MSG,
     LOG_VIDEO_STABILISATION_MSG,
     LOG_MOTBATT_MSG,
     LOG_VER_MSG,
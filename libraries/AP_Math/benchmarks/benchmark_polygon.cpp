@@ -0,0 +1,75 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+
+/*
+  fence checks against a polygon of many edges, testing every edge
+  and with an index
+ */
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static const uint16_t num_points = 250;
+static Vector2f polygon[num_points];
+static Polygon_index<float> polygon_index;
+
+static void setup_polygon()
+{
+    if (polygon_index.built()) {
+        return;
+    }
+    for (uint16_t i=0; i<num_points; i++) {
+        const float radius = (i % 2) ? 50000.0f : 45000.0f;
+        const float angle = M_2PI * i / num_points;
+        polygon[i] = Vector2f{radius * cosf(angle), radius * sinf(angle)};
+    }
+    if (!polygon_index.build(polygon, num_points)) {
+        abort();
+    }
+}
+
+static const Vector2f p1{30000.0f, 1000.0f};
+static const Vector2f p2{31000.0f, 1500.0f};
+
+static void BM_PolygonOutside(benchmark::State& state)
+{
+    setup_polygon();
+    while (state.KeepRunning()) {
+        bool outside = Polygon_outside(p1, polygon, num_points);
+        gbenchmark_escape(&outside);
+    }
+}
+
+static void BM_PolygonIndexOutside(benchmark::State& state)
+{
+    setup_polygon();
+    while (state.KeepRunning()) {
+        bool outside = polygon_index.outside(p1);
+        gbenchmark_escape(&outside);
+    }
+}
+
+static void BM_PolygonClosestDistanceLine(benchmark::State& state)
+{
+    setup_polygon();
+    while (state.KeepRunning()) {
+        float distance = Polygon_closest_distance_line(polygon, num_points, p1, p2);
+        gbenchmark_escape(&distance);
+    }
+}
+
+static void BM_PolygonIndexClosestDistanceLine(benchmark::State& state)
+{
+    setup_polygon();
+    while (state.KeepRunning()) {
+        float distance = Polygon_closest_distance_line(polygon_index, p1, p2);
+        gbenchmark_escape(&distance);
+    }
+}
+
+BENCHMARK(BM_PolygonOutside);
+BENCHMARK(BM_PolygonIndexOutside);
+BENCHMARK(BM_PolygonClosestDistanceLine);
+BENCHMARK(BM_PolygonIndexClosestDistanceLine);
+
+BENCHMARK_MAIN();
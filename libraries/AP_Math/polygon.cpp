@@ -26,6 +26,49 @@
  */
 
 
+/*
+  return true if the edge from Vi to Vj crosses a ray cast from P,
+  toggling whether P is outside the polygon
+ */
+template <typename T>
+static inline bool Polygon_edge_crossed(const Vector2<T> &P, const Vector2<T> &Vi, const Vector2<T> &Vj)
+{
+    if ((Vi.y > P.y) == (Vj.y > P.y)) {
+        return false;
+    }
+    const T dx1 = P.x - Vi.x;
+    const T dx2 = Vj.x - Vi.x;
+    const T dy1 = P.y - Vi.y;
+    const T dy2 = Vj.y - Vi.y;
+    const int8_t dx1s = (dx1 < 0) ? -1 : 1;
+    const int8_t dx2s = (dx2 < 0) ? -1 : 1;
+    const int8_t dy1s = (dy1 < 0) ? -1 : 1;
+    const int8_t dy2s = (dy2 < 0) ? -1 : 1;
+    const int8_t m1 = dx1s * dy2s;
+    const int8_t m2 = dx2s * dy1s;
+    // we avoid the 64 bit multiplies if we can based on sign checks.
+    if (dy2 < 0) {
+        if (m1 > m2) {
+            return true;
+        } else if (m1 < m2) {
+            return false;
+        }
+        if (std::is_floating_point<T>::value) {
+            return dx1 * dy2 > dx2 * dy1;
+        }
+        return dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1;
+    }
+    if (m1 < m2) {
+        return true;
+    } else if (m1 > m2) {
+        return false;
+    }
+    if (std::is_floating_point<T>::value) {
+        return dx1 * dy2 < dx2 * dy1;
+    }
+    return dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1;
+}
+
 /*
  *  Polygon_outside(): test for a point in a polygon
  *     Input:   P = a point,
@@ -54,52 +97,8 @@ bool Polygon_outside(const Vector2<T> &P, const Vector2<T> *V, unsigned n)
         if (j >= n) {
             j = 0;
         }
-        if ((V[i].y > P.y) == (V[j].y > P.y)) {
-            continue;
-        }
-        const T dx1 = P.x - V[i].x;
-        const T dx2 = V[j].x - V[i].x;
-        const T dy1 = P.y - V[i].y;
-        const T dy2 = V[j].y - V[i].y;
-        const int8_t dx1s = (dx1 < 0) ? -1 : 1;
-        const int8_t dx2s = (dx2 < 0) ? -1 : 1;
-        const int8_t dy1s = (dy1 < 0) ? -1 : 1;
-        const int8_t dy2s = (dy2 < 0) ? -1 : 1;
-        const int8_t m1 = dx1s * dy2s;
-        const int8_t m2 = dx2s * dy1s;
-        // we avoid the 64 bit multiplies if we can based on sign checks.
-        if (dy2 < 0) {
-            if (m1 > m2) {
-                outside = !outside;
-            } else if (m1 < m2) {
-                continue;
-            } else {
-                if (std::is_floating_point<T>::value) {
-                    if ( dx1 * dy2 > dx2 * dy1 ) {
-                        outside = !outside;
-                    }
-                } else {
-                    if ( dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1 ) {
-                        outside = !outside;
-                    }
-                }
-            }
-        } else {
-            if (m1 < m2) {
-                outside = !outside;
-            } else if (m1 > m2) {
-                continue;
-            } else {
-                if (std::is_floating_point<T>::value) {
-                    if ( dx1 * dy2 < dx2 * dy1 ) {
-                        outside = !outside;
-                    }
-                } else {
-                    if ( dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1 ) {
-                        outside = !outside;
-                    }
-                }
-            }
+        if (Polygon_edge_crossed(P, V[i], V[j])) {
+            outside = !outside;
         }
     }
     return outside;
@@ -124,6 +123,172 @@ template bool Polygon_complete<int32_t>(const Vector2l *V, unsigned n);
 template bool Polygon_outside<float>(const Vector2f &P, const Vector2f *V, unsigned n);
 template bool Polygon_complete<float>(const Vector2f *V, unsigned n);
 
+/*
+  build the grid. The grid is square in cells, with about two edges
+  per cell; edges are added to every cell their bounding box overlaps,
+  so a polygon of long diagonal edges gets a coarser grid to bound the
+  memory used
+ */
+template <typename T>
+bool Polygon_index<T>::build(const Vector2<T> *V, uint16_t n)
+{
+    clear();
+    if (V == nullptr || n < 3 || n > MAX_EDGES) {
+        return false;
+    }
+
+    _min = _max = V[0];
+    for (uint16_t i=1; i<n; i++) {
+        _min.x = MIN(_min.x, V[i].x);
+        _min.y = MIN(_min.y, V[i].y);
+        _max.x = MAX(_max.x, V[i].x);
+        _max.y = MAX(_max.y, V[i].y);
+    }
+    _points = V;
+    _num_points = n;
+
+    const float range_x = float(_max.x) - float(_min.x);
+    const float range_y = float(_max.y) - float(_min.y);
+    uint32_t total;
+    _grid_size = constrain_int16(ceilf(sqrtf(n * 0.5f)), 1, 16);
+    while (true) {
+        _scale_x = is_positive(range_x) ? _grid_size / range_x : 0;
+        _scale_y = is_positive(range_y) ? _grid_size / range_y : 0;
+        total = 0;
+        for (uint16_t i=0; i<n; i++) {
+            const Vector2<T> &v1 = V[i];
+            const Vector2<T> &v2 = V[(i+1) % n];
+            const uint8_t x0 = cell(MIN(v1.x, v2.x), _min.x, _scale_x);
+            const uint8_t x1 = cell(MAX(v1.x, v2.x), _min.x, _scale_x);
+            const uint8_t y0 = cell(MIN(v1.y, v2.y), _min.y, _scale_y);
+            const uint8_t y1 = cell(MAX(v1.y, v2.y), _min.y, _scale_y);
+            total += (x1 - x0 + 1) * (y1 - y0 + 1);
+        }
+        if (total <= 4U * n || _grid_size == 1) {
+            break;
+        }
+        _grid_size /= 2;
+    }
+
+    const uint16_t num_cells = _grid_size * _grid_size;
+    _cell_start = NEW_NOTHROW uint16_t[num_cells + 1];
+    _cell_edges = NEW_NOTHROW uint8_t[total];
+    if (_cell_start == nullptr || _cell_edges == nullptr) {
+        clear();
+        return false;
+    }
+
+    // count the edges in each cell, then make the counts into the
+    // offset of the end of each cell and fill the cells backwards
+    memset(_cell_start, 0, (num_cells + 1) * sizeof(_cell_start[0]));
+    for (uint8_t pass=0; pass<2; pass++) {
+        for (int16_t i=n-1; i>=0; i--) {
+            const Vector2<T> &v1 = V[i];
+            const Vector2<T> &v2 = V[(i+1) % n];
+            const uint8_t x0 = cell(MIN(v1.x, v2.x), _min.x, _scale_x);
+            const uint8_t x1 = cell(MAX(v1.x, v2.x), _min.x, _scale_x);
+            const uint8_t y0 = cell(MIN(v1.y, v2.y), _min.y, _scale_y);
+            const uint8_t y1 = cell(MAX(v1.y, v2.y), _min.y, _scale_y);
+            for (uint8_t y=y0; y<=y1; y++) {
+                for (uint8_t x=x0; x<=x1; x++) {
+                    const uint16_t c = y * _grid_size + x;
+                    if (pass == 0) {
+                        _cell_start[c]++;
+                    } else {
+                        _cell_edges[--_cell_start[c]] = i;
+                    }
+                }
+            }
+        }
+        if (pass == 0) {
+            for (uint16_t c=1; c<=num_cells; c++) {
+                _cell_start[c] += _cell_start[c-1];
+            }
+        }
+    }
+
+    return true;
+}
+
+template <typename T>
+void Polygon_index<T>::clear()
+{
+    delete[] _cell_start;
+    _cell_start = nullptr;
+    delete[] _cell_edges;
+    _cell_edges = nullptr;
+    _points = nullptr;
+    _num_points = 0;
+}
+
+/*
+  the cell along one axis holding v. This is monotonic in v, so an
+  edge and a box which overlap always share a cell
+ */
+template <typename T>
+uint8_t Polygon_index<T>::cell(T v, T min_v, float scale) const
+{
+    const float c = (float(v) - float(min_v)) * scale;
+    if (!(c > 0)) {
+        return 0;
+    }
+    if (c >= _grid_size - 1) {
+        return _grid_size - 1;
+    }
+    return uint8_t(c);
+}
+
+template <typename T>
+void Polygon_index<T>::edges_in_box(const Vector2<T> &lo, const Vector2<T> &hi, EdgeMask &edges) const
+{
+    if (!built() ||
+        hi.x < _min.x || lo.x > _max.x ||
+        hi.y < _min.y || lo.y > _max.y) {
+        return;
+    }
+    const uint8_t x0 = cell(lo.x, _min.x, _scale_x);
+    const uint8_t x1 = cell(hi.x, _min.x, _scale_x);
+    const uint8_t y0 = cell(lo.y, _min.y, _scale_y);
+    const uint8_t y1 = cell(hi.y, _min.y, _scale_y);
+    for (uint8_t y=y0; y<=y1; y++) {
+        for (uint8_t x=x0; x<=x1; x++) {
+            const uint16_t c = y * _grid_size + x;
+            for (uint16_t k=_cell_start[c]; k<_cell_start[c+1]; k++) {
+                edges.set(_cell_edges[k]);
+            }
+        }
+    }
+}
+
+/*
+  only edges which span P.y can be crossed, and they are all in the
+  row of cells holding P. A closing point equal to the first point
+  only adds an edge of zero length, which is never crossed
+ */
+template <typename T>
+bool Polygon_index<T>::outside(const Vector2<T> &P) const
+{
+    if (!built()) {
+        return true;
+    }
+    if (P.x < _min.x || P.x > _max.x || P.y < _min.y || P.y > _max.y) {
+        return true;
+    }
+    EdgeMask edges;
+    edges_in_box(Vector2<T>{_min.x, P.y}, Vector2<T>{_max.x, P.y}, edges);
+    bool outside = true;
+    for (int16_t i = edges.first_set(); i >= 0; i = edges.first_set()) {
+        edges.clear(i);
+        if (Polygon_edge_crossed(P, _points[i], _points[(i+1) % _num_points])) {
+            outside = !outside;
+        }
+    }
+    return outside;
+}
+
+template class Polygon_index<int32_t>;
+template class Polygon_index<float>;
+
 
 /*
   determine if the polygon of N verticies defined by points V is
@@ -196,6 +361,87 @@ float Polygon_closest_distance_line(const Vector2f *V, unsigned N, const Vector2
     return sqrtf(closest_sq);
 }
 
+/*
+  Polygon_intersects() using an index; only edges overlapping the
+  bounding box of the line can intersect it. Edges are tested in the
+  same order, so ties are resolved the same way
+ */
+bool Polygon_intersects(const Polygon_index<float> &index, const Vector2f &p1, const Vector2f &p2, Vector2f &intersection)
+{
+    const Vector2f *V = index.points();
+    uint16_t N = index.num_points();
+    if (Polygon_complete(V, N)) {
+        // the closing edge has no length
+        N--;
+    }
+
+    Polygon_index<float>::EdgeMask edges;
+    index.edges_in_box(Vector2f{MIN(p1.x, p2.x), MIN(p1.y, p2.y)},
+                       Vector2f{MAX(p1.x, p2.x), MAX(p1.y, p2.y)},
+                       edges);
+
+    float intersect_dist_sq = FLT_MAX;
+    for (int16_t i = edges.first_set(); i >= 0 && i < N; i = edges.first_set()) {
+        edges.clear(i);
+        const Vector2f &v1 = V[i];
+        const Vector2f &v2 = V[(i+1 == N) ? 0 : i+1];
+        Vector2f intersect_tmp;
+        if (Vector2f::segment_intersection(v1,v2,p1,p2,intersect_tmp)) {
+            float dist_sq = sq(intersect_tmp.x - p1.x) + sq(intersect_tmp.y - p1.y);
+            if (dist_sq < intersect_dist_sq) {
+                intersect_dist_sq = dist_sq;
+                intersection = intersect_tmp;
+            }
+        }
+    }
+    return (intersect_dist_sq < FLT_MAX);
+}
+
+/*
+  Polygon_closest_distance_line() using an index. The box around the
+  line is grown until the closest edge found is nearer than the edge
+  of the box, as no edge outside the box can then be closer
+ */
+float Polygon_closest_distance_line(const Polygon_index<float> &index, const Vector2f &p1, const Vector2f &p2)
+{
+    Vector2f intersection;
+    if (Polygon_intersects(index, p1, p2, intersection)) {
+        return -sqrtf(sq(intersection.x - p2.x) + sq(intersection.y - p2.y));
+    }
+
+    const Vector2f *V = index.points();
+    const uint16_t N = index.num_points();
+    const Vector2f line_min{MIN(p1.x, p2.x), MIN(p1.y, p2.y)};
+    const Vector2f line_max{MAX(p1.x, p2.x), MAX(p1.y, p2.y)};
+    const Vector2f &poly_min = index.box_min();
+    const Vector2f &poly_max = index.box_max();
+    // start with a box about a cell larger than the line
+    float range = MAX(MAX(poly_max.x - poly_min.x, poly_max.y - poly_min.y) * 0.1f, 1.0f);
+    float closest_sq = FLT_MAX;
+    while (true) {
+        const Vector2f lo = line_min - Vector2f{range, range};
+        const Vector2f hi = line_max + Vector2f{range, range};
+        Polygon_index<float>::EdgeMask edges;
+        index.edges_in_box(lo, hi, edges);
+        // as in Polygon_closest_distance_line() the closing edge is
+        // not checked
+        for (int16_t i = edges.first_set(); i >= 0 && i < N-1; i = edges.first_set()) {
+            edges.clear(i);
+            const float dist_sq = Vector2f::closest_distance_between_lines_squared(V[i], V[i+1], p1, p2);
+            if (dist_sq < closest_sq) {
+                closest_sq = dist_sq;
+            }
+        }
+        if (closest_sq <= sq(range) ||
+            (lo.x <= poly_min.x && lo.y <= poly_min.y &&
+             hi.x >= poly_max.x && hi.y >= poly_max.y)) {
+            break;
+        }
+        range *= 2;
+    }
+    return sqrtf(closest_sq);
+}
+
 /*
   return the closest distance that point p comes to an edge of closed
   polygon V, defined by N points
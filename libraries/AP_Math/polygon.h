@@ -18,6 +18,8 @@
 #pragma once
 
 #include "vector2.h"
+#include <AP_Common/AP_Common.h>
+#include <AP_Common/Bitmask.h>
 
 template <typename T>
 bool        Polygon_outside(const Vector2<T> &P, const Vector2<T> *V, unsigned n) WARN_IF_UNUSED;
@@ -44,3 +46,66 @@ float Polygon_closest_distance_line(const Vector2f *V, unsigned N, const Vector2
   closed polygon V, defined by N points
  */
 float Polygon_closest_distance_point(const Vector2f *V, unsigned N, const Vector2f &p);
+
+/*
+  a grid over the edges of a polygon, so the edges near a point or a
+  line can be found without testing every edge. Edge i runs from V[i]
+  to V[(i+1)%n]; the points are not copied and must outlive the index
+ */
+template <typename T>
+class Polygon_index {
+public:
+    static constexpr uint16_t MAX_EDGES = 256;
+    typedef Bitmask<MAX_EDGES> EdgeMask;
+
+    Polygon_index() {}
+    ~Polygon_index() { clear(); }
+
+    CLASS_NO_COPY(Polygon_index);
+
+    // build the index for the polygon of n points V, returning false
+    // if the polygon has too many edges or allocation fails
+    bool build(const Vector2<T> *V, uint16_t n) WARN_IF_UNUSED;
+    void clear();
+    bool built() const { return _cell_start != nullptr; }
+
+    const Vector2<T> *points() const { return _points; }
+    uint16_t num_points() const { return _num_points; }
+
+    // bounding box of the polygon
+    const Vector2<T> &box_min() const { return _min; }
+    const Vector2<T> &box_max() const { return _max; }
+
+    // set the bits of all edges whose bounding box may overlap the
+    // box from lo to hi. Edges are never missed, but some may be
+    // added which don't overlap the box
+    void edges_in_box(const Vector2<T> &lo, const Vector2<T> &hi, EdgeMask &edges) const;
+
+    // same result as Polygon_outside() on the indexed points
+    bool outside(const Vector2<T> &P) const WARN_IF_UNUSED;
+
+private:
+    uint8_t cell(T v, T min_v, float scale) const;
+
+    const Vector2<T> *_points = nullptr;
+    uint16_t _num_points = 0;
+    Vector2<T> _min;
+    Vector2<T> _max;
+    // cells per unit along each axis
+    float _scale_x;
+    float _scale_y;
+    // number of cells along each side of the grid
+    uint8_t _grid_size;
+    // the edges in cell c are _cell_edges[_cell_start[c]] to
+    // _cell_edges[_cell_start[c+1]-1], in ascending order
+    uint16_t *_cell_start = nullptr;
+    uint8_t *_cell_edges = nullptr;
+};
+
+/*
+  versions of Polygon_intersects() and
+  Polygon_closest_distance_line() which use an index to test only the
+  edges near the line, with the same results
+ */
+bool Polygon_intersects(const Polygon_index<float> &index, const Vector2f &p1, const Vector2f &p2, Vector2f &intersection) WARN_IF_UNUSED;
+float Polygon_closest_distance_line(const Polygon_index<float> &index, const Vector2f &p1, const Vector2f &p2);
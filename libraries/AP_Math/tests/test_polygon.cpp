@@ -241,12 +241,23 @@ TEST(Polygon, outside_long_closed_equal_to_unclosed)
 }
 
 
+// Polygon_outside() using an index of the polygon
+template <typename T, size_t N>
+static bool index_outside(const Vector2<T> (&polygon)[N], const Vector2<T> &point)
+{
+    Polygon_index<T> index;
+    EXPECT_TRUE(index.build(polygon, N));
+    return index.outside(point);
+}
+
 #define TEST_POLYGON_POINTS(POLYGON, TEST_POINTS)                       \
     do {                                                                \
         for (uint32_t i = 0; i < ARRAY_SIZE(TEST_POINTS); i++) {        \
             EXPECT_EQ(TEST_POINTS[i].outside,                           \
                       Polygon_outside(TEST_POINTS[i].point,             \
                                       POLYGON, ARRAY_SIZE(POLYGON)));   \
+            EXPECT_EQ(TEST_POINTS[i].outside,                           \
+                      index_outside(POLYGON, TEST_POINTS[i].point));    \
         }                                                               \
     } while(0)
 
@@ -356,6 +367,52 @@ TEST(Polygon, simple)
     TEST_POLYGON_POINTS(SIMPLE_boundary, SIMPLE_test_points);
 }
 
+/*
+  the indexed functions must give exactly the same results as testing
+  every edge, for points and lines inside, outside and across a
+  polygon of many edges
+ */
+TEST(Polygon, index)
+{
+    static const uint16_t n = 200;
+    Vector2f poly[n];
+    Vector2l poly_l[n];
+    uint32_t seed = 1;
+    for (uint16_t i=0; i<n; i++) {
+        seed = seed * 1103515245U + 12345U;
+        const float radius = 500.0f + (seed >> 16) % 400;
+        const float angle = M_2PI * i / n;
+        poly[i] = Vector2f{radius * cosf(angle), radius * sinf(angle)};
+        poly_l[i] = Vector2l{int32_t(poly[i].x * 100), int32_t(poly[i].y * 100)};
+    }
+    Polygon_index<float> index;
+    Polygon_index<int32_t> index_l;
+    EXPECT_TRUE(index.build(poly, n));
+    EXPECT_TRUE(index_l.build(poly_l, n));
+
+    for (uint16_t i=0; i<2000; i++) {
+        seed = seed * 1103515245U + 12345U;
+        const Vector2f p1{float(int16_t(seed >> 16) % 1200), float(int16_t(seed) % 1200)};
+        const Vector2f p2 = p1 + Vector2f{float(int16_t(seed >> 8) % 200), float(int16_t(seed >> 4) % 200)};
+        const Vector2l p1_l{int32_t(p1.x * 100), int32_t(p1.y * 100)};
+        EXPECT_EQ(Polygon_outside(p1, poly, n), index.outside(p1));
+        EXPECT_EQ(Polygon_outside(p1_l, poly_l, n), index_l.outside(p1_l));
+        Vector2f intersection1, intersection2;
+        const bool intersects = Polygon_intersects(poly, n, p1, p2, intersection1);
+        EXPECT_EQ(intersects, Polygon_intersects(index, p1, p2, intersection2));
+        if (intersects) {
+            EXPECT_EQ(intersection1, intersection2);
+        }
+        EXPECT_FLOAT_EQ(Polygon_closest_distance_line(poly, n, p1, p2),
+                        Polygon_closest_distance_line(index, p1, p2));
+    }
+
+    // too many edges to index
+    Vector2f big[Polygon_index<float>::MAX_EDGES + 1] {};
+    EXPECT_FALSE(index.build(big, ARRAY_SIZE(big)));
+    EXPECT_FALSE(index.built());
+}
+
 AP_GTEST_MAIN()
 
 
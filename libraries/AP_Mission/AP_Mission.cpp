@@ -87,6 +87,17 @@ void AP_Mission::init()
         _cmd_total.set(0);
     }
 
+#if AP_MISSION_CACHE_SIZE > 0
+    if (_cache == nullptr && _commands_max > 0) {
+        const uint16_t cache_size = MIN(_commands_max, uint16_t(AP_MISSION_CACHE_SIZE));
+        _cache = NEW_NOTHROW Mission_Command[cache_size];
+        if (_cache != nullptr) {
+            memset((void *)_cache, 0, cache_size * sizeof(_cache[0]));
+            _cache_size = cache_size;
+        }
+    }
+#endif
+
 
     // check_eeprom_version - checks version of missions stored in eeprom matches this library
     // command list will be cleared if they do not match
@@ -553,6 +564,18 @@ bool AP_Mission::get_next_nav_cmd(uint16_t start_index, Mission_Command& cmd)
 {
     // search until the end of the mission command list
     for (uint16_t cmd_index = start_index; cmd_index < (unsigned)_cmd_total; cmd_index++) {
+#if AP_MISSION_INDEX_ENABLED
+        {
+            // skip straight to the next navigation or jump command
+            WITH_SEMAPHORE(_rsem);
+            if (update_index() && cmd_index < _index_total) {
+                cmd_index = _index[cmd_index].next_nav;
+                if (cmd_index == AP_MISSION_CMD_INDEX_NONE) {
+                    return false;
+                }
+            }
+        }
+#endif
         // get next command
         if (!get_next_cmd(cmd_index, cmd, false)) {
             // no more commands so return failure
@@ -832,6 +855,16 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
         return false;
     }
 
+#if AP_MISSION_CACHE_SIZE > 0
+    if (_cache != nullptr) {
+        const Mission_Command &cached = _cache[index % _cache_size];
+        if (cached.index == index) {
+            cmd = cached;
+            return true;
+        }
+    }
+#endif
+
     // ensure all bytes of cmd are zeroed
     cmd = {};
 
@@ -890,6 +923,12 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
     // set command's index to it's position in eeprom
     cmd.index = index;
 
+#if AP_MISSION_CACHE_SIZE > 0
+    if (_cache != nullptr) {
+        _cache[index % _cache_size] = cmd;
+    }
+#endif
+
     // return success
     return true;
 }
@@ -953,6 +992,14 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, const Mission_Command& cmd
         memcpy(packed.bytes, &cmd.content, 12);
     }
 
+#if AP_MISSION_CACHE_SIZE > 0
+    if (_cache != nullptr && _cache[index % _cache_size].index == index) {
+        // the command is decoded again on its next read, as storage
+        // does not hold everything in cmd
+        _cache[index % _cache_size].index = 0;
+    }
+#endif
+
     // calculate where in storage the command should be placed
     uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
 
@@ -977,6 +1024,11 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, const Mission_Command& cmd
         _storage.write_block(pos_in_storage+5, packed.bytes, 10);
     }
 
+#if AP_MISSION_INDEX_ENABLED
+    _index_dirty_lo = MIN(_index_dirty_lo, index);
+    _index_dirty_hi = MAX(_index_dirty_hi, index);
+#endif
+
     // remember when the mission last changed
     if (index != 0) {
         // Update of home location is not a true change
@@ -2389,11 +2441,9 @@ uint16_t AP_Mission::get_landing_sequence_start(const Location &current_loc)
     float min_distance = -1;
 
     // Go through mission looking for nearest landing start command
-    const auto count = num_commands();
-    for (uint16_t i = 1; i < count; i++) {
-        if (get_command_id(i) != uint16_t(MAV_CMD_DO_LAND_START)) {
-            continue;
-        }
+    for (uint16_t i = find_command(1, MAV_CMD_DO_LAND_START);
+         i != AP_MISSION_CMD_INDEX_NONE;
+         i = find_command(i+1, MAV_CMD_DO_LAND_START)) {
         Mission_Command tmp;
         if (!read_cmd_from_storage(i, tmp)) {
             continue;
@@ -2462,18 +2512,18 @@ bool AP_Mission::jump_to_closest_mission_leg(const Location &current_loc)
     uint16_t search_remaining = 1000;
 
     // Go through mission and check each DO_RETURN_PATH_START
-    for (uint16_t i = 1; i < num_commands(); i++) {
-        if (get_command_id(i) == uint16_t(MAV_CMD_DO_RETURN_PATH_START)) {
-            uint16_t tmp_index;
-            float tmp_distance;
-            if (distance_to_mission_leg(i, search_remaining, tmp_distance, tmp_index, current_loc) && (min_distance < 0 || tmp_distance <= min_distance)){
-                min_distance = tmp_distance;
-                landing_start_index = tmp_index;
-            }
-            if (search_remaining == 0) {
-                // Run out of time to search, stop and return the best so far
-                break;
-            }
+    for (uint16_t i = find_command(1, MAV_CMD_DO_RETURN_PATH_START);
+         i != AP_MISSION_CMD_INDEX_NONE;
+         i = find_command(i+1, MAV_CMD_DO_RETURN_PATH_START)) {
+        uint16_t tmp_index;
+        float tmp_distance;
+        if (distance_to_mission_leg(i, search_remaining, tmp_distance, tmp_index, current_loc) && (min_distance < 0 || tmp_distance <= min_distance)){
+            min_distance = tmp_distance;
+            landing_start_index = tmp_index;
+        }
+        if (search_remaining == 0) {
+            // Run out of time to search, stop and return the best so far
+            break;
         }
     }
 
@@ -2499,11 +2549,9 @@ bool AP_Mission::jump_to_abort_landing_sequence(const Location &current_loc)
     uint16_t abort_index = 0;
     float min_distance = FLT_MAX;
 
-    const auto count = num_commands();
-    for (uint16_t i = 1; i < count; i++) {
-        if (get_command_id(i) != uint16_t(MAV_CMD_DO_GO_AROUND)) {
-            continue;
-        }
+    for (uint16_t i = find_command(1, MAV_CMD_DO_GO_AROUND);
+         i != AP_MISSION_CMD_INDEX_NONE;
+         i = find_command(i+1, MAV_CMD_DO_GO_AROUND)) {
         Mission_Command tmp;
         if (!read_cmd_from_storage(i, tmp)) {
             continue;
@@ -2594,6 +2642,13 @@ bool AP_Mission::distance_to_landing(uint16_t index, float &tot_distance, Locati
     tot_distance = 0.0f;
     bool ret = false;  // reached end of loop without getting to a landing
 
+#if AP_MISSION_INDEX_ENABLED
+    // without jumps on the way the index has the answer
+    if (index_distance_to_landing(index, tot_distance, prev_loc, ret)) {
+        return ret;
+    }
+#endif
+
     // back up jump tracking to reset after distance calculation
     jump_tracking_struct _jump_tracking_backup[AP_MISSION_MAX_NUM_DO_JUMP_COMMANDS];
     for (uint8_t i=0; i<AP_MISSION_MAX_NUM_DO_JUMP_COMMANDS; i++) {
@@ -2897,6 +2952,15 @@ const char *AP_Mission::Mission_Command::type() const
  */
 uint16_t AP_Mission::get_command_id(uint16_t index) const
 {
+#if AP_MISSION_CACHE_SIZE > 0
+    if (_cache != nullptr && index != 0) {
+        WITH_SEMAPHORE(_rsem);
+        const Mission_Command &cached = _cache[index % _cache_size];
+        if (cached.index == index) {
+            return cached.id;
+        }
+    }
+#endif
     const uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
     uint8_t b[3] {};
     if (!_storage.read_block(b, pos_in_storage, sizeof(b))) {
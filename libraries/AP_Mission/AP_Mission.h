@@ -781,6 +781,8 @@ public:
 #endif
 
 private:
+    friend class AP_Mission_Index_Test;
+
     static AP_Mission *_singleton;
 
     static StorageAccess _storage;
@@ -929,6 +931,62 @@ private:
     // fast call to get command ID of a mission index
     uint16_t get_command_id(uint16_t index) const;
 
+#if AP_MISSION_CACHE_SIZE > 0
+    // decoded commands, each in slot index modulo _cache_size. A slot
+    // holding index 0 is empty, as home is never read from storage.
+    // Writing a command drops it from the cache
+    Mission_Command *_cache;
+    uint16_t _cache_size;
+#endif
+
+#if AP_MISSION_INDEX_ENABLED
+    /*
+      index of the commands in storage order. It is built the first
+      time it is needed and afterwards updated from the lowest
+      command written since. The next_* fields are the index of the
+      first such command at or after this one, or
+      AP_MISSION_CMD_INDEX_NONE if there is none before the end of
+      the mission
+     */
+    struct IndexEntry {
+        uint16_t id;
+        uint16_t next_nav;      // navigation or jump command
+        uint16_t next_stop;     // command ending a distance_to_landing() search
+        uint16_t next_leg;      // waypoint or landing with a location
+        uint16_t next_marker;   // DO_LAND_START, DO_RETURN_PATH_START or DO_GO_AROUND
+        uint8_t flags;
+        // path length from the first leg of the mission to the last
+        // leg at or before this command, ignoring jumps
+        float distance;
+    };
+    enum IndexFlags : uint8_t {
+        INDEX_NAV    = (1U<<0),
+        INDEX_STOP   = (1U<<1),
+        INDEX_LEG    = (1U<<2),
+        INDEX_MARKER = (1U<<3),
+    };
+    IndexEntry *_index;
+    uint16_t _index_size;       // number of entries allocated
+    uint16_t _index_total;      // number of commands the index covers
+    uint16_t _index_dirty_lo;   // range of commands written since the index was updated
+    uint16_t _index_dirty_hi;
+
+    // bring the index up to date, returning false if it is not
+    // available. Must be called with _rsem held
+    bool update_index(void);
+
+    // flags for a command in the index
+    uint8_t index_flags(const Mission_Command &cmd) const;
+
+    // distance_to_landing() from the index. Returns false if the
+    // path to the landing has jumps, which need the full search
+    bool index_distance_to_landing(uint16_t index, float &tot_distance, const Location &prev_loc, bool &ret);
+#endif
+
+    // first command at or after start_index with the given id,
+    // AP_MISSION_CMD_INDEX_NONE if there is none
+    uint16_t find_command(uint16_t start_index, uint16_t id);
+
     // memoisation of contains-relative:
     bool _contains_terrain_alt_items;  // true if the mission has terrain-relative items
     uint32_t _last_contains_relative_calculated_ms;  // will be equal to _last_change_time_ms if _contains_terrain_alt_items is up-to-date
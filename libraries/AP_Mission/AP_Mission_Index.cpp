@@ -0,0 +1,259 @@
+/// @file    AP_Mission_Index.cpp
+/// @brief   Index of the mission commands, for searching the mission without reading it from storage
+
+#include "AP_Mission_config.h"
+
+#if AP_MISSION_ENABLED
+
+#include "AP_Mission.h"
+
+#if AP_MISSION_INDEX_ENABLED
+
+uint8_t AP_Mission::index_flags(const Mission_Command &cmd) const
+{
+    uint8_t flags = 0;
+    switch (cmd.id) {
+    case MAV_CMD_DO_JUMP:
+    case MAV_CMD_DO_JUMP_TAG:
+        return INDEX_NAV | INDEX_STOP;
+    case MAV_CMD_CONDITION_DELAY:
+        return INDEX_STOP;
+    case MAV_CMD_DO_LAND_START:
+    case MAV_CMD_DO_RETURN_PATH_START:
+    case MAV_CMD_DO_GO_AROUND:
+        return INDEX_MARKER;
+    case MAV_CMD_NAV_WAYPOINT:
+    case MAV_CMD_NAV_SPLINE_WAYPOINT:
+        break;
+    default:
+        if (is_landing_type_cmd(cmd.id)) {
+            flags |= INDEX_STOP;
+        } else if (is_nav_cmd(cmd)) {
+            // distance_to_landing() can't measure other nav commands
+            return INDEX_NAV | INDEX_STOP;
+        } else {
+            return 0;
+        }
+        break;
+    }
+    flags |= INDEX_NAV;
+    // the same test distance_to_landing() uses for a location. Home
+    // comes from the AHRS rather than storage, so is never a leg
+    if (cmd.index != 0 &&
+        !(cmd.content.location.lat == 0 && cmd.content.location.lng == 0)) {
+        flags |= INDEX_LEG;
+    }
+    return flags;
+}
+
+/*
+  bring the index up to date with storage. Commands written since the
+  last update are read again, then the searches are updated backwards
+  from the highest written command until they are unchanged, and the
+  path lengths forwards from the lowest written command until the
+  first unchanged leg, after which they all move by the same amount
+ */
+bool AP_Mission::update_index(void)
+{
+    const uint16_t total = MIN(uint16_t(_cmd_total.get()), _commands_max);
+    if (_index == nullptr || total > _index_size) {
+        // the index is sized to the mission rather than to storage,
+        // growing AP_MISSION_INDEX_GROWTH commands at a time
+        const uint16_t size = MIN(uint32_t(total) + AP_MISSION_INDEX_GROWTH, uint32_t(_commands_max));
+        if (size == 0) {
+            return false;
+        }
+        IndexEntry *index = NEW_NOTHROW IndexEntry[size];
+        if (index == nullptr) {
+            return false;
+        }
+        if (_index != nullptr) {
+            memcpy(index, _index, _index_total * sizeof(index[0]));
+            delete[] _index;
+        }
+        _index = index;
+        _index_size = size;
+    }
+
+    const bool shrunk = total < _index_total;
+    uint16_t lo = _index_dirty_lo;
+    uint16_t hi = _index_dirty_hi;
+    if (total != _index_total) {
+        // commands may have been added or removed without being
+        // written, and the end of the mission has moved
+        lo = MIN(lo, MIN(total, _index_total));
+        hi = MAX(hi, uint16_t(total-1));
+    }
+    _index_total = total;
+    _index_dirty_lo = AP_MISSION_CMD_INDEX_NONE;
+    _index_dirty_hi = 0;
+    if (total == 0) {
+        return true;
+    }
+    hi = MIN(hi, uint16_t(total-1));
+    if (shrunk) {
+        // the searches of the remaining commands may point past the
+        // new end, so update them backwards from the last command
+        lo = MIN(lo, hi);
+    }
+    if (lo > hi) {
+        return true;
+    }
+
+    for (uint16_t i=lo; i<=hi; i++) {
+        Mission_Command cmd;
+        if (!read_cmd_from_storage(i, cmd)) {
+            cmd = {};
+            cmd.id = MAV_CMD_NAV_LAST;
+        }
+        _index[i].id = cmd.id;
+        _index[i].flags = index_flags(cmd);
+    }
+
+    // searches, backwards from the last written command
+    for (int32_t i=hi; i>=0; i--) {
+        IndexEntry &e = _index[i];
+        const IndexEntry *n = (i+1 < total) ? &_index[i+1] : nullptr;
+        const uint16_t next_nav = (e.flags & INDEX_NAV) ? i : (n ? n->next_nav : AP_MISSION_CMD_INDEX_NONE);
+        const uint16_t next_stop = (e.flags & INDEX_STOP) ? i : (n ? n->next_stop : AP_MISSION_CMD_INDEX_NONE);
+        const uint16_t next_leg = (e.flags & INDEX_LEG) ? i : (n ? n->next_leg : AP_MISSION_CMD_INDEX_NONE);
+        const uint16_t next_marker = (e.flags & INDEX_MARKER) ? i : (n ? n->next_marker : AP_MISSION_CMD_INDEX_NONE);
+        if (i < lo &&
+            e.next_nav == next_nav && e.next_stop == next_stop &&
+            e.next_leg == next_leg && e.next_marker == next_marker) {
+            // nothing earlier can change
+            break;
+        }
+        e.next_nav = next_nav;
+        e.next_stop = next_stop;
+        e.next_leg = next_leg;
+        e.next_marker = next_marker;
+    }
+
+    // path lengths, continuing from the last leg before the first
+    // written command
+    float distance = 0;
+    Location prev_loc;
+    bool have_prev = false;
+    for (int32_t i=int32_t(lo)-1; i>=0; i--) {
+        Mission_Command cmd;
+        if ((_index[i].flags & INDEX_LEG) && read_cmd_from_storage(i, cmd)) {
+            prev_loc = cmd.content.location;
+            have_prev = true;
+            distance = _index[i].distance;
+            break;
+        }
+    }
+    for (uint16_t i=lo; i<total; i++) {
+        IndexEntry &e = _index[i];
+        Mission_Command cmd;
+        if ((e.flags & INDEX_LEG) && read_cmd_from_storage(i, cmd)) {
+            if (have_prev) {
+                distance += prev_loc.get_distance(cmd.content.location);
+            }
+            prev_loc = cmd.content.location;
+            have_prev = true;
+            if (i > hi) {
+                // this leg and everything after it is unchanged
+                const float change = distance - e.distance;
+                for (uint16_t j=i; j<total; j++) {
+                    _index[j].distance += change;
+                }
+                break;
+            }
+        }
+        e.distance = distance;
+    }
+
+    return true;
+}
+
+/*
+  distance_to_landing() for a path with no jumps: the distance to the
+  first leg plus the path length from there to the landing. Returns
+  false if the search must be done by walking the mission, with ret
+  holding the result otherwise
+ */
+bool AP_Mission::index_distance_to_landing(uint16_t index, float &tot_distance, const Location &prev_loc, bool &ret)
+{
+    WITH_SEMAPHORE(_rsem);
+
+    if (index == 0 || !update_index() || index >= _index_total) {
+        return false;
+    }
+    tot_distance = 0;
+    ret = false;
+
+    const uint16_t stop = _index[index].next_stop;
+    if (stop == AP_MISSION_CMD_INDEX_NONE) {
+        // no landing before the end of the mission
+        return true;
+    }
+    if (stop >= _index_total) {
+        return false;
+    }
+    const uint16_t stop_id = _index[stop].id;
+    if (stop_id == MAV_CMD_DO_JUMP || stop_id == MAV_CMD_DO_JUMP_TAG) {
+        return false;
+    }
+    if (!is_landing_type_cmd(stop_id)) {
+        // delay or a nav command we can't measure
+        return true;
+    }
+
+    const uint16_t first_leg = _index[index].next_leg;
+    if (first_leg <= stop) {
+        Mission_Command cmd;
+        if (!read_cmd_from_storage(first_leg, cmd)) {
+            return false;
+        }
+        tot_distance = prev_loc.get_distance(cmd.content.location) +
+            _index[stop].distance - _index[first_leg].distance;
+    }
+    ret = true;
+    return true;
+}
+
+#endif  // AP_MISSION_INDEX_ENABLED
+
+/*
+  find the first command at or after start_index with the given id
+ */
+uint16_t AP_Mission::find_command(uint16_t start_index, uint16_t id)
+{
+#if AP_MISSION_INDEX_ENABLED
+    {
+        WITH_SEMAPHORE(_rsem);
+        if (update_index()) {
+            const bool marker = (id == MAV_CMD_DO_LAND_START ||
+                                 id == MAV_CMD_DO_RETURN_PATH_START ||
+                                 id == MAV_CMD_DO_GO_AROUND);
+            uint16_t i = start_index;
+            while (i < _index_total) {
+                if (marker) {
+                    i = _index[i].next_marker;
+                    if (i >= _index_total) {
+                        // no more markers, including AP_MISSION_CMD_INDEX_NONE
+                        break;
+                    }
+                }
+                if (_index[i].id == id) {
+                    return i;
+                }
+                i++;
+            }
+            return AP_MISSION_CMD_INDEX_NONE;
+        }
+    }
+#endif
+
+    const auto count = num_commands();
+    for (uint16_t i = start_index; i < count; i++) {
+        if (get_command_id(i) == id) {
+            return i;
+        }
+    }
+    return AP_MISSION_CMD_INDEX_NONE;
+}
+
+#endif  // AP_MISSION_ENABLED
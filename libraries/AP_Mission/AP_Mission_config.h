@@ -7,3 +7,30 @@
 #ifndef AP_MISSION_NAV_PAYLOAD_PLACE_ENABLED
 #define AP_MISSION_NAV_PAYLOAD_PLACE_ENABLED 1
 #endif
+
+// number of decoded commands kept in memory, saving them being
+// unpacked from storage on every read
+#ifndef AP_MISSION_CACHE_SIZE
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#define AP_MISSION_CACHE_SIZE 1024
+#elif BOARD_FLASH_SIZE > 1024
+#define AP_MISSION_CACHE_SIZE 64
+#else
+#define AP_MISSION_CACHE_SIZE 0
+#endif
+#endif
+
+// index of the commands in storage, for searching the mission
+// without reading every command from storage. It uses 16 bytes of
+// RAM per mission command, allocated when the mission is first
+// searched and grown as the mission is extended
+#ifndef AP_MISSION_INDEX_ENABLED
+#define AP_MISSION_INDEX_ENABLED (BOARD_FLASH_SIZE > 1024)
+#endif
+
+// number of commands the index is grown by beyond the mission, so
+// that uploading a mission a command at a time doesn't reallocate it
+// for every command
+#ifndef AP_MISSION_INDEX_GROWTH
+#define AP_MISSION_INDEX_GROWTH 32
+#endif
@@ -0,0 +1,153 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Mission/AP_Mission.h>
+#include <AP_InertialSensor/AP_InertialSensor.h>
+#include <AP_Baro/AP_Baro.h>
+#include <AP_GPS/AP_GPS.h>
+#include <AP_Compass/AP_Compass.h>
+#include <AP_AHRS/AP_AHRS.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+/*
+  benchmarks of the mission operations that read every item:
+  uploading, downloading, walking a mission and searching it for a
+  landing sequence. Build with -DAP_MISSION_CACHE_SIZE=0 or
+  -DAP_MISSION_INDEX_ENABLED=0 to compare against reading storage
+  directly
+ */
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+const struct AP_Param::GroupInfo        GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+
+class MissionBenchmark {
+public:
+    bool start_cmd(const AP_Mission::Mission_Command& cmd) { return true; }
+    bool verify_cmd(const AP_Mission::Mission_Command& cmd) { return true; }
+    void mission_complete(void) {}
+
+    AP_InertialSensor ins;
+    AP_Baro baro;
+    AP_GPS  gps;
+    Compass compass;
+    AP_AHRS ahrs{};
+    GCS_Dummy _gcs;
+
+    AP_Mission mission{
+            FUNCTOR_BIND_MEMBER(&MissionBenchmark::start_cmd, bool, const AP_Mission::Mission_Command &),
+            FUNCTOR_BIND_MEMBER(&MissionBenchmark::verify_cmd, bool, const AP_Mission::Mission_Command &),
+            FUNCTOR_BIND_MEMBER(&MissionBenchmark::mission_complete, void)};
+};
+
+static MissionBenchmark bm;
+
+/*
+  a survey style mission item: mostly waypoints, with a speed change
+  every tenth item
+ */
+static void make_item(uint16_t i, mavlink_mission_item_int_t &packet)
+{
+    packet = {};
+    packet.seq = i;
+    packet.frame = MAV_FRAME_GLOBAL_RELATIVE_ALT;
+    if (i % 10 == 0) {
+        packet.command = MAV_CMD_DO_CHANGE_SPEED;
+        packet.param2 = 12;
+        packet.param3 = -1;
+    } else {
+        packet.command = MAV_CMD_NAV_WAYPOINT;
+        packet.x = -353632610 + (i % 20) * 1000;
+        packet.y = 1491652300 + (i / 20) * 1000;
+        packet.z = 100;
+    }
+}
+
+static uint16_t mission_size(const benchmark::State& state)
+{
+    bm.mission.init();
+    return MIN(uint16_t(state.range_x()), uint16_t(bm.mission.num_commands_max()-1));
+}
+
+static void upload_mission(uint16_t count)
+{
+    bm.mission.clear();
+    for (uint16_t i=1; i<=count; i++) {
+        mavlink_mission_item_int_t packet;
+        make_item(i, packet);
+        AP_Mission::Mission_Command cmd;
+        if (AP_Mission::mavlink_int_to_mission_cmd(packet, cmd) == MAV_MISSION_ACCEPTED) {
+            bm.mission.add_cmd(cmd);
+        }
+    }
+}
+
+static void BM_MissionUpload(benchmark::State& state)
+{
+    const uint16_t count = mission_size(state);
+    while (state.KeepRunning()) {
+        upload_mission(count);
+    }
+}
+
+static void BM_MissionDownload(benchmark::State& state)
+{
+    upload_mission(mission_size(state));
+    while (state.KeepRunning()) {
+        for (uint16_t i=0; i<bm.mission.num_commands(); i++) {
+            AP_Mission::Mission_Command cmd;
+            mavlink_mission_item_int_t packet;
+            if (bm.mission.read_cmd_from_storage(i, cmd)) {
+                AP_Mission::mission_cmd_to_mavlink_int(cmd, packet);
+            }
+            gbenchmark_escape(&packet);
+        }
+    }
+}
+
+static void BM_MissionIterateNav(benchmark::State& state)
+{
+    upload_mission(mission_size(state));
+    while (state.KeepRunning()) {
+        AP_Mission::Mission_Command cmd;
+        for (uint16_t i=1; bm.mission.get_next_nav_cmd(i, cmd); i=cmd.index+1) {
+            gbenchmark_escape(&cmd);
+        }
+    }
+}
+
+static void BM_MissionLandingSequence(benchmark::State& state)
+{
+    const uint16_t count = mission_size(state);
+    upload_mission(count - 2);
+    // a landing sequence at the end of the survey
+    mavlink_mission_item_int_t packet;
+    make_item(count - 1, packet);
+    packet.command = MAV_CMD_DO_LAND_START;
+    AP_Mission::Mission_Command cmd;
+    if (AP_Mission::mavlink_int_to_mission_cmd(packet, cmd) == MAV_MISSION_ACCEPTED) {
+        bm.mission.add_cmd(cmd);
+    }
+    make_item(count, packet);
+    packet.command = MAV_CMD_NAV_LAND;
+    if (AP_Mission::mavlink_int_to_mission_cmd(packet, cmd) == MAV_MISSION_ACCEPTED) {
+        bm.mission.add_cmd(cmd);
+    }
+    Location loc;
+    loc.lat = -353632610;
+    loc.lng = 1491652300;
+    while (state.KeepRunning()) {
+        gbenchmark_escape(&loc);
+        uint16_t index = bm.mission.get_landing_sequence_start(loc);
+        gbenchmark_escape(&index);
+    }
+}
+
+BENCHMARK(BM_MissionUpload)->Arg(100)->Arg(700);
+BENCHMARK(BM_MissionDownload)->Arg(100)->Arg(700);
+BENCHMARK(BM_MissionIterateNav)->Arg(100)->Arg(700);
+BENCHMARK(BM_MissionLandingSequence)->Arg(100)->Arg(700);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,325 @@
+#include <AP_gtest.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Mission/AP_Mission.h>
+#include <AP_AHRS/AP_AHRS.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+const struct AP_Param::GroupInfo        GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+#if AP_MISSION_INDEX_ENABLED
+
+class DummyVehicle {
+public:
+    bool start_cmd(const AP_Mission::Mission_Command& cmd) { return true; }
+    bool verify_cmd(const AP_Mission::Mission_Command& cmd) { return true; }
+    void mission_complete(void) {}
+
+    AP_AHRS ahrs{AP_AHRS::FLAG_ALWAYS_USE_EKF};
+
+    AP_Mission mission{
+        FUNCTOR_BIND_MEMBER(&DummyVehicle::start_cmd, bool, const AP_Mission::Mission_Command &),
+        FUNCTOR_BIND_MEMBER(&DummyVehicle::verify_cmd, bool, const AP_Mission::Mission_Command &),
+        FUNCTOR_BIND_MEMBER(&DummyVehicle::mission_complete, void)};
+};
+
+static DummyVehicle vehicle;
+
+class AP_Mission_Index_Test
+{
+public:
+    AP_Mission_Index_Test(AP_Mission &_mission) : mission(_mission) {}
+
+    uint16_t find_command(uint16_t start_index, uint16_t id)
+    {
+        return mission.find_command(start_index, id);
+    }
+
+    static Location start_loc()
+    {
+        Location loc;
+        loc.lat = -353632610;
+        loc.lng = 1491652300;
+        return loc;
+    }
+
+    bool distance_to_landing(uint16_t index, float &tot_distance)
+    {
+        return mission.distance_to_landing(index, tot_distance, start_loc());
+    }
+
+    // true if no search in the index points past the end of the mission
+    bool searches_in_range()
+    {
+        WITH_SEMAPHORE(mission._rsem);
+        if (!mission.update_index()) {
+            return false;
+        }
+        for (uint16_t i=0; i<mission._index_total; i++) {
+            const AP_Mission::IndexEntry &e = mission._index[i];
+            for (const uint16_t next : { e.next_nav, e.next_stop, e.next_leg, e.next_marker }) {
+                if (next != AP_MISSION_CMD_INDEX_NONE && next >= mission._index_total) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // the searches done by walking the commands in storage, for
+    // missions without jumps
+    uint16_t reference_find_command(uint16_t start_index, uint16_t id)
+    {
+        for (uint16_t i=start_index; i<mission.num_commands(); i++) {
+            AP_Mission::Mission_Command cmd;
+            if (mission.read_cmd_from_storage(i, cmd) && cmd.id == id) {
+                return i;
+            }
+        }
+        return AP_MISSION_CMD_INDEX_NONE;
+    }
+
+    uint16_t reference_next_nav(uint16_t start_index)
+    {
+        for (uint16_t i=start_index; i<mission.num_commands(); i++) {
+            AP_Mission::Mission_Command cmd;
+            if (mission.read_cmd_from_storage(i, cmd) && AP_Mission::is_nav_cmd(cmd)) {
+                return i;
+            }
+        }
+        return AP_MISSION_CMD_INDEX_NONE;
+    }
+
+    bool reference_distance_to_landing(uint16_t index, float &tot_distance)
+    {
+        Location prev_loc = start_loc();
+        tot_distance = 0;
+        for (uint16_t i=index; i<mission.num_commands(); i++) {
+            AP_Mission::Mission_Command cmd;
+            if (!mission.read_cmd_from_storage(i, cmd)) {
+                return false;
+            }
+            const bool landing = mission.is_landing_type_cmd(cmd.id);
+            if (cmd.id == MAV_CMD_NAV_WAYPOINT || landing) {
+                tot_distance += prev_loc.get_distance(cmd.content.location);
+                prev_loc = cmd.content.location;
+                if (landing) {
+                    return true;
+                }
+            } else if (AP_Mission::is_nav_cmd(cmd) || cmd.id == MAV_CMD_CONDITION_DELAY) {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    // compare every search from every command with the reference
+    void check_searches()
+    {
+        EXPECT_TRUE(searches_in_range());
+        for (uint16_t i=1; i<=mission.num_commands(); i++) {
+            EXPECT_EQ(find_command(i, MAV_CMD_DO_LAND_START), reference_find_command(i, MAV_CMD_DO_LAND_START)) << "start " << i;
+            EXPECT_EQ(find_command(i, MAV_CMD_NAV_LAND), reference_find_command(i, MAV_CMD_NAV_LAND)) << "start " << i;
+
+            AP_Mission::Mission_Command cmd;
+            const uint16_t next_nav = reference_next_nav(i);
+            if (next_nav == AP_MISSION_CMD_INDEX_NONE) {
+                EXPECT_FALSE(mission.get_next_nav_cmd(i, cmd)) << "start " << i;
+            } else {
+                EXPECT_TRUE(mission.get_next_nav_cmd(i, cmd)) << "start " << i;
+                EXPECT_EQ(cmd.index, next_nav) << "start " << i;
+            }
+
+            float distance, expected_distance;
+            const bool expected = reference_distance_to_landing(i, expected_distance);
+            EXPECT_EQ(distance_to_landing(i, distance), expected) << "start " << i;
+            if (expected) {
+                EXPECT_NEAR(distance, expected_distance, 0.01) << "start " << i;
+            }
+        }
+    }
+
+    // make the mission longer than storage can hold
+    void set_total_beyond_storage()
+    {
+        mission._cmd_total.set(mission._commands_max + 10);
+    }
+
+private:
+    AP_Mission &mission;
+};
+
+static AP_Mission::Mission_Command make_command(uint16_t id, uint16_t i)
+{
+    AP_Mission::Mission_Command cmd {};
+    cmd.id = id;
+    if (id != MAV_CMD_DO_LAND_START && id != MAV_CMD_DO_CHANGE_SPEED) {
+        cmd.content.location.lat = -353632610 + i * 1000;
+        cmd.content.location.lng = 1491652300;
+        cmd.content.location.alt = 10000;
+        cmd.content.location.relative_alt = true;
+    }
+    return cmd;
+}
+
+static void add_command(uint16_t id, uint16_t i)
+{
+    AP_Mission::Mission_Command cmd = make_command(id, i);
+    ASSERT_TRUE(vehicle.mission.add_cmd(cmd));
+}
+
+// insert a command by moving the ones after it up, as a GCS does
+static void insert_command(uint16_t index, const AP_Mission::Mission_Command &cmd)
+{
+    AP_Mission &mission = vehicle.mission;
+    AP_Mission::Mission_Command last;
+    ASSERT_TRUE(mission.read_cmd_from_storage(mission.num_commands()-1, last));
+    for (uint16_t i=mission.num_commands()-1; i>index; i--) {
+        AP_Mission::Mission_Command moved;
+        ASSERT_TRUE(mission.read_cmd_from_storage(i-1, moved));
+        ASSERT_TRUE(mission.replace_cmd(i, moved));
+    }
+    ASSERT_TRUE(mission.replace_cmd(index, cmd));
+    ASSERT_TRUE(mission.add_cmd(last));
+}
+
+/*
+  waypoints 1 to 5 followed by a landing sequence from 6 to 8
+ */
+static void upload_landing_mission(void)
+{
+    vehicle.mission.init();
+    vehicle.mission.clear();
+    for (uint16_t i=1; i<=5; i++) {
+        add_command(MAV_CMD_NAV_WAYPOINT, i);
+    }
+    add_command(MAV_CMD_DO_LAND_START, 6);
+    add_command(MAV_CMD_NAV_WAYPOINT, 7);
+    add_command(MAV_CMD_NAV_LAND, 8);
+    ASSERT_EQ(vehicle.mission.num_commands(), 9U);
+}
+
+TEST(AP_Mission_Index, Searches)
+{
+    AP_Mission_Index_Test test(vehicle.mission);
+    upload_landing_mission();
+
+    EXPECT_EQ(test.find_command(1, MAV_CMD_DO_LAND_START), 6U);
+    EXPECT_EQ(test.find_command(7, MAV_CMD_DO_LAND_START), AP_MISSION_CMD_INDEX_NONE);
+    EXPECT_EQ(test.find_command(1, MAV_CMD_NAV_LAND), 8U);
+    float distance, expected_distance;
+    EXPECT_TRUE(test.distance_to_landing(1, distance));
+    ASSERT_TRUE(test.reference_distance_to_landing(1, expected_distance));
+    EXPECT_GT(expected_distance, 0);
+    EXPECT_NEAR(distance, expected_distance, 0.01);
+    test.check_searches();
+}
+
+TEST(AP_Mission_Index, RewriteMiddle)
+{
+    AP_Mission_Index_Test test(vehicle.mission);
+    upload_landing_mission();
+    test.check_searches();
+
+    float before;
+    ASSERT_TRUE(test.distance_to_landing(1, before));
+
+    // move a waypoint, which changes the path length after it
+    ASSERT_TRUE(vehicle.mission.replace_cmd(3, make_command(MAV_CMD_NAV_WAYPOINT, 30)));
+    test.check_searches();
+    float after;
+    ASSERT_TRUE(test.distance_to_landing(1, after));
+    EXPECT_GT(after, before + 100);
+
+    // replace waypoints with commands that aren't legs
+    ASSERT_TRUE(vehicle.mission.replace_cmd(4, make_command(MAV_CMD_DO_CHANGE_SPEED, 4)));
+    ASSERT_TRUE(vehicle.mission.replace_cmd(2, make_command(MAV_CMD_DO_LAND_START, 2)));
+    test.check_searches();
+    EXPECT_EQ(test.find_command(1, MAV_CMD_DO_LAND_START), 2U);
+
+    // and a landing part way through
+    ASSERT_TRUE(vehicle.mission.replace_cmd(5, make_command(MAV_CMD_NAV_LAND, 5)));
+    test.check_searches();
+    EXPECT_EQ(test.find_command(1, MAV_CMD_NAV_LAND), 5U);
+}
+
+TEST(AP_Mission_Index, Insert)
+{
+    AP_Mission_Index_Test test(vehicle.mission);
+    upload_landing_mission();
+    test.check_searches();
+
+    insert_command(3, make_command(MAV_CMD_NAV_WAYPOINT, 20));
+    ASSERT_EQ(vehicle.mission.num_commands(), 10U);
+    test.check_searches();
+    EXPECT_EQ(test.find_command(1, MAV_CMD_NAV_LAND), 9U);
+
+    insert_command(1, make_command(MAV_CMD_DO_CHANGE_SPEED, 1));
+    ASSERT_EQ(vehicle.mission.num_commands(), 11U);
+    test.check_searches();
+    EXPECT_EQ(test.find_command(1, MAV_CMD_DO_LAND_START), 8U);
+}
+
+TEST(AP_Mission_Index, TruncateAfterBuild)
+{
+    AP_Mission_Index_Test test(vehicle.mission);
+    upload_landing_mission();
+
+    // build the index with the landing sequence in it
+    ASSERT_EQ(test.find_command(1, MAV_CMD_DO_LAND_START), 6U);
+    float distance;
+    ASSERT_TRUE(test.distance_to_landing(1, distance));
+
+    // remove the landing sequence without writing any commands
+    vehicle.mission.truncate(6);
+    ASSERT_EQ(vehicle.mission.num_commands(), 6U);
+
+    test.check_searches();
+    EXPECT_EQ(test.find_command(1, MAV_CMD_DO_LAND_START), AP_MISSION_CMD_INDEX_NONE);
+    EXPECT_EQ(test.find_command(1, MAV_CMD_NAV_LAND), AP_MISSION_CMD_INDEX_NONE);
+    EXPECT_FALSE(test.distance_to_landing(1, distance));
+
+    // commands added after the truncate are searched again
+    add_command(MAV_CMD_NAV_LAND, 6);
+    test.check_searches();
+    EXPECT_EQ(test.find_command(1, MAV_CMD_NAV_LAND), 6U);
+    EXPECT_TRUE(test.distance_to_landing(1, distance));
+}
+
+TEST(AP_Mission_Index, TruncateToOne)
+{
+    AP_Mission_Index_Test test(vehicle.mission);
+    upload_landing_mission();
+
+    ASSERT_EQ(test.find_command(1, MAV_CMD_DO_LAND_START), 6U);
+
+    // only home is left
+    vehicle.mission.truncate(1);
+    EXPECT_TRUE(test.searches_in_range());
+    EXPECT_EQ(test.find_command(0, MAV_CMD_NAV_LAND), AP_MISSION_CMD_INDEX_NONE);
+}
+
+TEST(AP_Mission_Index, LongerThanStorage)
+{
+    AP_Mission_Index_Test test(vehicle.mission);
+    upload_landing_mission();
+    test.check_searches();
+
+    // commands beyond storage can't be read, and are not in the index
+    test.set_total_beyond_storage();
+    AP_Mission::Mission_Command cmd;
+    const uint16_t commands_max = vehicle.mission.num_commands_max();
+    EXPECT_FALSE(vehicle.mission.get_next_nav_cmd(commands_max + 5, cmd));
+    EXPECT_TRUE(vehicle.mission.get_next_nav_cmd(1, cmd));
+    EXPECT_EQ(cmd.index, 1U);
+    EXPECT_TRUE(test.searches_in_range());
+}
+
+#endif  // AP_MISSION_INDEX_ENABLED
+
+AP_GTEST_MAIN()
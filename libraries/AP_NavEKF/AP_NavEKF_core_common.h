@@ -17,10 +17,26 @@
 #pragma once
 
 #include <stdint.h>
+#include <AP_HAL/AP_HAL_Boards.h>
+#include <AP_Vehicle/AP_Vehicle_Type.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_Math/vectorN.h>
 #include "AP_Nav_Common.h"
 
+/*
+  on boards where EKF cores may be updated from more than one thread
+  each thread needs its own copy of the scratch space
+ */
+#ifndef EKF_SCRATCH_THREAD_LOCAL
+#define EKF_SCRATCH_THREAD_LOCAL (CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL) && !APM_BUILD_TYPE(APM_BUILD_Replay)
+#endif
+
+#if EKF_SCRATCH_THREAD_LOCAL
+#define EKF_SCRATCH_TLS thread_local
+#else
+#define EKF_SCRATCH_TLS
+#endif
+
 /*
   this declares a common parent class for AP_NavEKF2 and
   AP_NavEKF3. The purpose of this class is to hold common static
@@ -29,7 +45,9 @@
   placing these in a common parent class we save a lot of memory, but
   we also save a lot of CPU (approx 10% on STM32F427) as the compiler
   is able to resolve the address of these variables at compile time,
-  which means significantly faster code
+  which means significantly faster code. When EKF_SCRATCH_THREAD_LOCAL
+  is set each thread gets its own copy, allowing cores to be updated
+  in parallel
  */
 class NavEKF_core_common {
 public:
@@ -42,10 +60,10 @@ public:
 #endif
 
 protected:
-    static Matrix24 KH;                   // intermediate result used for covariance updates
-    static Matrix24 KHP;                  // intermediate result used for covariance updates
-    static Matrix24 nextP;                // Predicted covariance matrix before addition of process noise to diagonals
-    static Vector28 Kfusion;              // intermediate fusion vector
+    static EKF_SCRATCH_TLS Matrix24 KH;      // intermediate result used for covariance updates
+    static EKF_SCRATCH_TLS Matrix24 KHP;     // intermediate result used for covariance updates
+    static EKF_SCRATCH_TLS Matrix24 nextP;   // Predicted covariance matrix before addition of process noise to diagonals
+    static EKF_SCRATCH_TLS Vector28 Kfusion; // intermediate fusion vector
 
     // fill all the common scratch variables with NaN on SITL
     void fill_scratch_variables(void);
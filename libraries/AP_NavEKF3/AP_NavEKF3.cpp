@@ -8,11 +8,22 @@
 #include <AP_Logger/AP_Logger.h>
 #include <AP_Vehicle/AP_Vehicle_Type.h>
 #include <AP_BoardConfig/AP_BoardConfig.h>
+#include <AP_Common/ExpandingString.h>
 
 #include "AP_DAL/AP_DAL.h"
 
 #include <new>
 
+#if EK3_FEATURE_PARALLEL_CORES
+#if !EKF_SCRATCH_THREAD_LOCAL
+#error "EK3_FEATURE_PARALLEL_CORES requires EKF_SCRATCH_THREAD_LOCAL"
+#endif
+#ifndef EK3_LANE_WORKER_STACK_SIZE
+#define EK3_LANE_WORKER_STACK_SIZE 16384
+#endif
+extern const AP_HAL::HAL& hal;
+#endif
+
 /*
   parameter defaults for different types of vehicle. The
   APM_BUILD_DIRECTORY is taken from the main vehicle directory name
@@ -739,8 +750,8 @@ const AP_Param::GroupInfo NavEKF3::var_info2[] = {
 
     // @Param: OPTIONS
     // @DisplayName: Optional EKF behaviour
-    // @Description: This controls optional EKF behaviour. Setting JammingExpected will change the EKF nehaviour such that if dead reckoning navigation is possible it will require the preflight alignment GPS quality checks controlled by EK3_GPS_CHECK and EK3_CHECK_SCALE to pass before resuming GPS use if GPS lock is lost for more than 2 seconds to prevent bad
-    // @Bitmask: 0:JammingExpected
+    // @Description: This controls optional EKF behaviour. Setting JammingExpected will change the EKF nehaviour such that if dead reckoning navigation is possible it will require the preflight alignment GPS quality checks controlled by EK3_GPS_CHECK and EK3_CHECK_SCALE to pass before resuming GPS use if GPS lock is lost for more than 2 seconds to prevent bad position estimates. Setting SparseCovariancePrediction skips the covariance prediction of inhibited magnetic field states that have no correlation with the other states, reducing CPU load when running multiple EKF cores without changing the filter output. Setting ParallelCores updates each EKF core on its own thread on boards that support it (Linux and SITL), a reboot is not required.
+    // @Bitmask: 0:JammingExpected,1:SparseCovariancePrediction,2:ParallelCores
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",  11, NavEKF3, _options, 0),
 
@@ -917,19 +928,33 @@ void NavEKF3::UpdateFilter(void)
 
     imuSampleTime_us = dal.micros64();
 
-    for (uint8_t i=0; i<num_cores; i++) {
-        // if we have not overrun by more than 3 IMU frames, and we
-        // have already used more than 1/3 of the CPU budget for this
-        // loop then suppress the prediction step. This allows
-        // multiple EKF instances to cooperate on scheduling
-        bool allow_state_prediction = true;
-        if (core[i].getFramesSincePredict() < (_framesPerPrediction+3) &&
-            dal.ekf_low_time_remaining(AP_DAL::EKFType::EKF3, i)) {
-            allow_state_prediction = false;
+    const uint32_t frame_start_us = AP_HAL::micros();
+
+#if EK3_FEATURE_PARALLEL_CORES
+    parallelUpdateActive = num_cores > 1 &&
+        option_is_enabled(Option::ParallelCores) &&
+        createLaneWorkers();
+    if (parallelUpdateActive) {
+        // cores are independent of each other, so update all but
+        // the first on the worker threads and wait for all of them
+        // to complete before running lane selection
+        for (uint8_t i=1; i<num_cores; i++) {
+            laneWorkers[i-1].start(allowStatePrediction(i));
+        }
+        updateCore(0, allowStatePrediction(0));
+        for (uint8_t i=1; i<num_cores; i++) {
+            laneWorkers[i-1].wait();
+        }
+    } else
+#endif
+    {
+        for (uint8_t i=0; i<num_cores; i++) {
+            updateCore(i, allowStatePrediction(i));
         }
-        core[i].UpdateFilter(allow_state_prediction);
     }
 
+    frameUpdateTiming.update(AP_HAL::micros() - frame_start_us);
+
     // If the current core selected has a bad error score or is unhealthy, switch to a healthy core with the lowest fault score
     // Don't start running the check until the primary core has started returned healthy for at least 10 seconds to avoid switching
     // due to initial alignment fluctuations and race conditions
@@ -1016,6 +1041,152 @@ void NavEKF3::UpdateFilter(void)
     sources.align_inactive_sources();
 }
 
+/*
+  if we have not overrun by more than 3 IMU frames, and we have
+  already used more than 1/3 of the CPU budget for this loop then
+  suppress the prediction step. This allows multiple EKF instances to
+  cooperate on scheduling
+ */
+bool NavEKF3::allowStatePrediction(uint8_t core_index)
+{
+    return core[core_index].getFramesSincePredict() >= (_framesPerPrediction+3) ||
+        !dal.ekf_low_time_remaining(AP_DAL::EKFType::EKF3, core_index);
+}
+
+/*
+  update a single core, recording the time taken
+ */
+void NavEKF3::updateCore(uint8_t core_index, bool allow_state_prediction)
+{
+    const uint32_t start_us = AP_HAL::micros();
+    core[core_index].UpdateFilter(allow_state_prediction);
+    laneUpdateTiming[core_index].update(AP_HAL::micros() - start_us);
+}
+
+#if EK3_FEATURE_PARALLEL_CORES
+/*
+  create the worker threads used to update cores in parallel. Returns
+  true if the workers are available
+ */
+bool NavEKF3::createLaneWorkers(void)
+{
+    if (laneWorkers != nullptr) {
+        return true;
+    }
+    if (laneWorkersFailed) {
+        return false;
+    }
+    laneWorkers = NEW_NOTHROW LaneWorker[num_cores-1];
+    if (laneWorkers == nullptr) {
+        laneWorkersFailed = true;
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "EKF3 parallel cores allocation failed");
+        return false;
+    }
+    for (uint8_t i=1; i<num_cores; i++) {
+        if (!laneWorkers[i-1].init(*this, i)) {
+            // threads which were created stay idle as we never start them
+            laneWorkersFailed = true;
+            laneWorkers = nullptr;
+            GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "EKF3 parallel cores unavailable");
+            return false;
+        }
+    }
+    GCS_SEND_TEXT(MAV_SEVERITY_INFO, "EKF3 updating %u cores in parallel", (unsigned)num_cores);
+    return true;
+}
+
+bool NavEKF3::LaneWorker::init(NavEKF3 &_frontend, uint8_t _core_index)
+{
+    frontend = &_frontend;
+    core_index = _core_index;
+    hal.util->snprintf(thread_name, sizeof(thread_name), "EK3L%u", (unsigned)core_index);
+    return hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&NavEKF3::LaneWorker::thread, void),
+                                        thread_name, EK3_LANE_WORKER_STACK_SIZE,
+                                        AP_HAL::Scheduler::PRIORITY_MAIN, 0);
+}
+
+// start an update of our core on the worker thread
+void NavEKF3::LaneWorker::start(bool allow_state_prediction)
+{
+    allow_predict = allow_state_prediction;
+    start_sem.signal();
+}
+
+// wait for the update started by start() to complete
+void NavEKF3::LaneWorker::wait(void)
+{
+    done_sem.wait_blocking();
+}
+
+void NavEKF3::LaneWorker::thread(void)
+{
+    while (true) {
+        start_sem.wait_blocking();
+        frontend->updateCore(core_index, allow_predict);
+        done_sem.signal();
+    }
+}
+#endif // EK3_FEATURE_PARALLEL_CORES
+
+#if EK3_FEATURE_PROFILING
+// names of the profiled functions, in NavEKF3_core::ProfileFunction order
+static const char *profile_names[] {
+    "UpdateFilter",
+    "CovariancePrediction",
+    "FuseMagnetometer",
+    "FuseVelPosNED",
+    "FuseOptFlow",
+};
+static_assert(ARRAY_SIZE(profile_names) == uint8_t(NavEKF3_core::ProfileFunction::NUM_FUNCTIONS), "profile names must match functions");
+
+/*
+  report the execution time of the main filter functions for each core
+ */
+void NavEKF3::profile_report(ExpandingString &str) const
+{
+    str.printf("%-5s %-20s %9s %9s %9s %9s\n", "Core", "Function", "Count", "Avg(us)", "Max(us)", "Total(ms)");
+    for (uint8_t i=0; i<num_cores; i++) {
+        for (uint8_t f=0; f<ARRAY_SIZE(profile_names); f++) {
+            const auto &p = core[i].get_profile(NavEKF3_core::ProfileFunction(f));
+            if (p.count == 0) {
+                continue;
+            }
+            str.printf("%-5u %-20s %9u %9.2f %9u %9.1f\n",
+                       unsigned(i),
+                       profile_names[f],
+                       unsigned(p.count),
+                       double(p.total_us) / p.count,
+                       unsigned(p.max_us),
+                       p.total_us * 0.001);
+        }
+    }
+}
+
+/*
+  get the highest average execution time of a profiled function over
+  all cores. Returns false if the name is unknown or it was not called
+ */
+bool NavEKF3::profile_average_us(const char *name, float &avg_us) const
+{
+    for (uint8_t f=0; f<ARRAY_SIZE(profile_names); f++) {
+        if (strcasecmp(name, profile_names[f]) != 0) {
+            continue;
+        }
+        bool called = false;
+        avg_us = 0;
+        for (uint8_t i=0; i<num_cores; i++) {
+            const auto &p = core[i].get_profile(NavEKF3_core::ProfileFunction(f));
+            if (p.count != 0) {
+                avg_us = MAX(avg_us, float(double(p.total_us) / p.count));
+                called = true;
+            }
+        }
+        return called;
+    }
+    return false;
+}
+#endif  // EK3_FEATURE_PROFILING
+
 /*
   check if switching lanes will reduce the normalised
   innovations. This is called when the vehicle code is about to
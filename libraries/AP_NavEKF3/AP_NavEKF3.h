@@ -24,6 +24,8 @@
 #include <AP_Param/AP_Param.h>
 #include <AP_NavEKF/AP_Nav_Common.h>
 #include <AP_NavEKF/AP_NavEKF_Source.h>
+#include <AP_HAL/Semaphores.h>
+#include "AP_NavEKF3_feature.h"
 
 class NavEKF3_core;
 class EKFGSF_yaw;
@@ -340,6 +342,15 @@ public:
     // write EKF information to on-board logs
     void Log_Write();
 
+#if EK3_FEATURE_PROFILING
+    // append a report of per-core function execution times to str
+    void profile_report(class ExpandingString &str) const;
+
+    // get the highest average execution time of a profiled function
+    // over all cores, false if it is unknown or was not called
+    bool profile_average_us(const char *name, float &avg_us) const;
+#endif
+
     // are we using (aka fusing) a non-compass yaw?
     bool using_noncompass_for_yaw() const;
 
@@ -455,6 +466,8 @@ private:
     // enum for processing options
     enum class Option {
         JammingExpected     = (1<<0),
+        SparseCovPrediction = (1<<1),
+        ParallelCores       = (1<<2),
     };
     bool option_is_enabled(Option option) const {
         return (_options & (uint32_t)option) != 0;
@@ -543,6 +556,60 @@ private:
     // origin set by one of the cores
     Location common_EKF_origin;
     bool common_origin_valid;
+    HAL_Semaphore common_origin_sem;    // protects the common origin when cores are updated in parallel
+
+    // accumulated update time statistics, reset when logged
+    struct update_timing {
+        uint32_t count;
+        uint64_t total_us;
+        uint32_t max_us;
+        void update(uint32_t dt_us) {
+            count++;
+            total_us += dt_us;
+            max_us = MAX(max_us, dt_us);
+        }
+    };
+    update_timing laneUpdateTiming[MAX_EKF_CORES]; // time taken by each core's UpdateFilter
+    update_timing frameUpdateTiming;               // time taken to update all cores
+    uint32_t lastLaneTimingLog_ms;
+
+    // return false if the state prediction for a core should be deferred to save CPU
+    bool allowStatePrediction(uint8_t core_index);
+
+    // run the update for a single core, recording the time taken
+    void updateCore(uint8_t core_index, bool allow_state_prediction);
+
+#if EK3_FEATURE_PARALLEL_CORES
+    /*
+      worker thread used to update one core in parallel with the
+      calling thread. The calling thread starts all workers, updates
+      the first core itself and then waits for all workers to finish
+      before lane selection is run
+     */
+    class LaneWorker {
+    public:
+        bool init(NavEKF3 &_frontend, uint8_t _core_index);
+        void start(bool allow_state_prediction);
+        void wait(void);
+    private:
+        void thread(void);
+        NavEKF3 *frontend;
+        uint8_t core_index;
+        bool allow_predict;
+        char thread_name[8];
+        HAL_BinarySemaphore start_sem;
+        HAL_BinarySemaphore done_sem;
+    };
+    LaneWorker *laneWorkers = nullptr;  // workers for cores 1 to num_cores-1
+    bool laneWorkersFailed;             // true if we could not create the worker threads
+    bool parallelUpdateActive;          // true if the last update used the worker threads
+
+    // create worker threads, returns true if they are available
+    bool createLaneWorkers(void);
+#endif
+
+    // log core update timing statistics
+    void Log_Write_LaneTiming(uint64_t time_us);
     
     // update the yaw reset data to capture changes due to a lane switch
     // new_primary - index of the ekf instance that we are about to switch to as the primary
@@ -714,10 +714,14 @@ bool NavEKF3_core::setOrigin(const Location &loc)
 
     GCS_SEND_TEXT(MAV_SEVERITY_INFO, "EKF3 IMU%u origin set",(unsigned)imu_index);
 
-    if (!frontend->common_origin_valid) {
-        frontend->common_origin_valid = true;
-        // put origin in frontend as well to ensure it stays in sync between lanes
-        public_origin = EKF_origin;
+    {
+        // other cores may be setting their origin at the same time
+        WITH_SEMAPHORE(frontend->common_origin_sem);
+        if (!frontend->common_origin_valid) {
+            frontend->common_origin_valid = true;
+            // put origin in frontend as well to ensure it stays in sync between lanes
+            public_origin = EKF_origin;
+        }
     }
 
 
@@ -374,6 +374,8 @@ void NavEKF3::Log_Write()
         core[i].Log_Write(time_us);
     }
 
+    Log_Write_LaneTiming(time_us);
+
     AP::dal().start_frame(AP_DAL::FrameType::LogWriteEKF3);
 }
 
@@ -445,6 +447,41 @@ void NavEKF3_core::Log_Write_Timing(uint64_t time_us)
     AP::logger().WriteBlock(&xkt, sizeof(xkt));
 }
 
+void NavEKF3::Log_Write_LaneTiming(uint64_t time_us)
+{
+    // log core update timing statistics every 5s
+    if (_log_level == LogLevel::NONE ||
+        AP::dal().millis() - lastLaneTimingLog_ms <= 5000) {
+        return;
+    }
+    lastLaneTimingLog_ms = AP::dal().millis();
+
+    bool parallel = false;
+#if EK3_FEATURE_PARALLEL_CORES
+    parallel = parallelUpdateActive;
+#endif
+
+    const update_timing &frame = frameUpdateTiming;
+    for (uint8_t i=0; i<activeCores(); i++) {
+        const update_timing &lane = laneUpdateTiming[i];
+        const struct log_XKTL xktl{
+            LOG_PACKET_HEADER_INIT(LOG_XKTL_MSG),
+            time_us       : time_us,
+            core          : DAL_CORE(i),
+            parallel      : parallel,
+            count         : lane.count,
+            update_avg_us : lane.count > 0 ? uint32_t(lane.total_us / lane.count) : 0,
+            update_max_us : lane.max_us,
+            frame_avg_us  : frame.count > 0 ? uint32_t(frame.total_us / frame.count) : 0,
+            frame_max_us  : frame.max_us,
+        };
+        AP::logger().WriteBlock(&xktl, sizeof(xktl));
+    }
+
+    memset(laneUpdateTiming, 0, sizeof(laneUpdateTiming));
+    memset(&frameUpdateTiming, 0, sizeof(frameUpdateTiming));
+}
+
 void NavEKF3_core::Log_Write_GSF(uint64_t time_us)
 {
     if (yawEstimator == nullptr) {
@@ -281,6 +281,8 @@ void NavEKF3_core::EstimateTerrainOffset(const of_elements &ofDataDelayed)
 */
 void NavEKF3_core::FuseOptFlow(const of_elements &ofDataDelayed, bool really_fuse)
 {
+    EK3_PROFILE(FuseOptFlow);
+
     Vector24 H_LOS;
     Vector2 losPred;
 
@@ -464,7 +464,60 @@ public:
     // get a yaw estimator instance
     const EKFGSF_yaw *get_yawEstimator(void) const { return yawEstimator; }
 
+    // update the covariance matrix for a direct observation of the state at obsStateIndex using
+    // the Kalman gain vector, over states 0 to lastStateIndex. This is P = (I - K*H)*P where H
+    // selects a single state. Returns false and leaves the matrix unchanged if the update would
+    // drive any variance negative
+    static bool directObsCovarianceUpdate(Matrix24 &covMat, const Vector28 &gain, uint8_t obsStateIndex, uint8_t lastStateIndex);
+
+#if EK3_FEATURE_PROFILING
+    // functions with execution time profiling
+    enum class ProfileFunction : uint8_t {
+        UpdateFilter = 0,
+        CovariancePrediction,
+        FuseMagnetometer,
+        FuseVelPosNED,
+        FuseOptFlow,
+        NUM_FUNCTIONS
+    };
+
+    // cumulative execution time of a profiled function
+    struct profile_stats {
+        uint32_t count;
+        uint64_t total_us;
+        uint32_t max_us;
+    };
+
+    const profile_stats &get_profile(ProfileFunction fn) const {
+        return profile[uint8_t(fn)];
+    }
+#endif
+
 private:
+#if EK3_FEATURE_PROFILING
+    profile_stats profile[uint8_t(ProfileFunction::NUM_FUNCTIONS)] {};
+
+    // accumulate the time spent in a scope into a profile entry
+    class ProfileScope {
+    public:
+        ProfileScope(profile_stats &_stats) :
+            stats(_stats),
+            start_us(AP_HAL::micros64()) {}
+        ~ProfileScope() {
+            const uint32_t dt_us = uint32_t(AP_HAL::micros64() - start_us);
+            stats.count++;
+            stats.total_us += dt_us;
+            stats.max_us = MAX(stats.max_us, dt_us);
+        }
+    private:
+        profile_stats &stats;
+        const uint64_t start_us;
+    };
+#define EK3_PROFILE(fn) ProfileScope profile_scope(profile[uint8_t(ProfileFunction::fn)])
+#else
+#define EK3_PROFILE(fn)
+#endif
+
     EKFGSF_yaw *yawEstimator;
     AP_DAL &dal;
 
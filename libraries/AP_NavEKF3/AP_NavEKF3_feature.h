@@ -46,3 +46,13 @@
 #ifndef EK3_FEATURE_OPTFLOW_FUSION
 #define EK3_FEATURE_OPTFLOW_FUSION HAL_NAVEKF3_AVAILABLE && AP_OPTICALFLOW_ENABLED
 #endif
+
+// option to update EKF cores in parallel on worker threads
+#ifndef EK3_FEATURE_PARALLEL_CORES
+#define EK3_FEATURE_PARALLEL_CORES (CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL) && !APM_BUILD_TYPE(APM_BUILD_Replay) && !APM_BUILD_TYPE(APM_BUILD_AP_DAL_Standalone)
+#endif
+
+// execution time profiling of the main filter functions, reported by Replay
+#ifndef EK3_FEATURE_PROFILING
+#define EK3_FEATURE_PROFILING APM_BUILD_TYPE(APM_BUILD_Replay)
+#endif
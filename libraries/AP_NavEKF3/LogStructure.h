@@ -15,6 +15,7 @@
     LOG_XKFS_MSG, \
     LOG_XKQ_MSG,  \
     LOG_XKT_MSG,  \
+    LOG_XKTL_MSG, \
     LOG_XKTV_MSG, \
     LOG_XKV1_MSG, \
     LOG_XKV2_MSG, \
@@ -297,6 +298,28 @@ struct PACKED log_XKT {
 };
 
 
+// @LoggerMessage: XKTL
+// @Description: EKF3 core update timing information
+// @Field: TimeUS: Time since system startup
+// @Field: C: EKF core this message instance applies to
+// @Field: Par: true if cores were updated in parallel on worker threads
+// @Field: Cnt: count of updates used to create this message
+// @Field: UAvg: average time taken to update this core
+// @Field: UMax: maximum time taken to update this core
+// @Field: FAvg: average time taken to update all cores
+// @Field: FMax: maximum time taken to update all cores
+struct PACKED log_XKTL {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t core;
+    uint8_t parallel;
+    uint32_t count;
+    uint32_t update_avg_us;
+    uint32_t update_max_us;
+    uint32_t frame_avg_us;
+    uint32_t frame_max_us;
+};
+
 // @LoggerMessage: XKFM
 // @Description: EKF3 diagnostic data for on-ground-and-not-moving check
 // @Field: TimeUS: Time since system startup
@@ -451,6 +474,8 @@ struct PACKED log_XKV {
     { LOG_XKQ_MSG, sizeof(log_XKQ), "XKQ", "QBffff", "TimeUS,C,Q1,Q2,Q3,Q4", "s#????", "F-????" , true }, \
     { LOG_XKT_MSG, sizeof(log_XKT),   \
       "XKT", "QBIffffffff", "TimeUS,C,Cnt,IMUMin,IMUMax,EKFMin,EKFMax,AngMin,AngMax,VMin,VMax", "s#sssssssss", "F-000000000", true }, \
+    { LOG_XKTL_MSG, sizeof(log_XKTL),   \
+      "XKTL", "QBBIIIII", "TimeUS,C,Par,Cnt,UAvg,UMax,FAvg,FMax", "s#--ssss", "F---FFFF", true }, \
     { LOG_XKTV_MSG, sizeof(log_XKTV),                         \
       "XKTV", "QBff", "TimeUS,C,TVS,TVD", "s#rr", "F-00", true }, \
     { LOG_XKV1_MSG, sizeof(log_XKV), \
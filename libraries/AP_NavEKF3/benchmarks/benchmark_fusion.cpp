@@ -0,0 +1,96 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_NavEKF3/AP_NavEKF3_core.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+typedef NavEKF_core_common::Matrix24 Matrix24;
+typedef NavEKF_core_common::Vector28 Vector28;
+
+/*
+  fill a covariance matrix with a symmetric, diagonally dominant set
+  of values representative of a converged filter
+ */
+static void fill_covariance(Matrix24 &P)
+{
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=0; j<24; j++) {
+            P[i][j] = 1.0e-4f * (1 + ((i * 7 + j * 7) % 5));
+        }
+        P[i][i] = 1.0f + 0.1f * i;
+    }
+}
+
+/*
+  sequential fusion of velocity and position observations as done by
+  FuseVelPosNED() before the direct observation covariance update was
+  added
+ */
+static bool fuse_reference(Matrix24 &P, Vector28 &K, Matrix24 &KHP, uint8_t stateIndex)
+{
+    const ftype SK = 1.0f / (P[stateIndex][stateIndex] + 0.1f);
+    for (uint8_t i=0; i<24; i++) {
+        K[i] = P[i][stateIndex] * SK;
+    }
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=0; j<24; j++) {
+            KHP[i][j] = K[i] * P[stateIndex][j];
+        }
+    }
+    bool healthyFusion = true;
+    for (uint8_t i=0; i<24; i++) {
+        if (KHP[i][i] > P[i][i]) {
+            healthyFusion = false;
+        }
+    }
+    if (healthyFusion) {
+        for (uint8_t i=0; i<24; i++) {
+            for (uint8_t j=0; j<24; j++) {
+                P[i][j] = P[i][j] - KHP[i][j];
+            }
+        }
+    }
+    return healthyFusion;
+}
+
+static void BM_FuseVelPosReference(benchmark::State& state)
+{
+    Matrix24 P0, P, KHP;
+    Vector28 K;
+    fill_covariance(P0);
+
+    while (state.KeepRunning()) {
+        memcpy(&P, &P0, sizeof(P));
+        for (uint8_t obsIndex=0; obsIndex<=5; obsIndex++) {
+            bool ok = fuse_reference(P, K, KHP, 4 + obsIndex);
+            gbenchmark_escape(&ok);
+        }
+        gbenchmark_escape(&P);
+    }
+}
+
+static void BM_FuseVelPosDirectObs(benchmark::State& state)
+{
+    Matrix24 P0, P;
+    Vector28 K;
+    fill_covariance(P0);
+
+    while (state.KeepRunning()) {
+        memcpy(&P, &P0, sizeof(P));
+        for (uint8_t obsIndex=0; obsIndex<=5; obsIndex++) {
+            const uint8_t stateIndex = 4 + obsIndex;
+            const ftype SK = 1.0f / (P[stateIndex][stateIndex] + 0.1f);
+            for (uint8_t i=0; i<24; i++) {
+                K[i] = P[i][stateIndex] * SK;
+            }
+            bool ok = NavEKF3_core::directObsCovarianceUpdate(P, K, stateIndex, 23);
+            gbenchmark_escape(&ok);
+        }
+        gbenchmark_escape(&P);
+    }
+}
+
+BENCHMARK(BM_FuseVelPosReference);
+BENCHMARK(BM_FuseVelPosDirectObs);
+
+BENCHMARK_MAIN();
@@ -34,6 +34,7 @@
 
 
 #include <AP_Logger/AP_Logger.h>
+#include <GCS_MAVLink/GCS.h>
 
 extern const AP_HAL::HAL &hal;
 
@@ -79,6 +80,26 @@ const AP_Param::GroupInfo AP_Proximity::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO_FRAME("_ALT_MIN", 25, AP_Proximity, _alt_min, 1.0f, AP_PARAM_FRAME_COPTER | AP_PARAM_FRAME_HELI | AP_PARAM_FRAME_TRICOPTER),
 
+#if AP_PROXIMITY_GRID_ENABLED
+    // @Param: _GRID_SECT
+    // @DisplayName: Proximity grid horizontal cells
+    // @Description: Number of horizontal cells in the high resolution proximity grid. When non-zero, every reading from the proximity sensors is kept in a grid of this many cells around the vehicle by PRX_GRID_LAYR cells vertically, and simple avoidance and BendyRuler use the grid as well as the 8 sector boundary. This suits scanning lidars with many readings per revolution. The grid uses 4 bytes of memory for each cell, plus 8 bytes for each horizontal cell. Set to zero to disable
+    // @Range: 0 360
+    // @Increment: 1
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("_GRID_SECT", 30, AP_Proximity, _grid_sectors, 0),
+
+    // @Param: _GRID_LAYR
+    // @DisplayName: Proximity grid vertical cells
+    // @Description: Number of vertical cells in the high resolution proximity grid, evenly dividing pitch angles from -75 to 75 degrees. Only used if PRX_GRID_SECT is non-zero
+    // @Range: 1 15
+    // @Increment: 1
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("_GRID_LAYR", 31, AP_Proximity, _grid_layers, 5),
+#endif
+
     // @Group: 1
     // @Path: AP_Proximity_Params.cpp
     AP_SUBGROUPINFO(params[0], "1", 21, AP_Proximity, AP_Proximity_Params),
@@ -271,6 +292,12 @@ void AP_Proximity::init()
             AP_Param::load_object_from_eeprom(drivers[instance], backend_var_info[instance]);
         }
     }
+
+#if AP_PROXIMITY_GRID_ENABLED
+    if (num_instances > 0 && _grid_sectors > 0 && !grid.init(_grid_sectors, _grid_layers)) {
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Proximity: grid out of memory");
+    }
+#endif
 }
 
 // update Proximity state for all instances. This should be called at a high rate by the main loop
@@ -288,6 +315,11 @@ void AP_Proximity::update()
 
     // check if any face has valid distance when it should not
     boundary.check_face_timeout();
+
+#if AP_PROXIMITY_GRID_ENABLED
+    // empty cells of the grid which have not been updated recently
+    grid.check_cell_timeout();
+#endif
 }
 
 AP_Proximity::Type AP_Proximity::get_type(uint8_t instance) const
@@ -24,6 +24,7 @@
 #include <GCS_MAVLink/GCS_MAVLink.h>
 #include "AP_Proximity_Params.h"
 #include "AP_Proximity_Boundary_3D.h"
+#include "AP_Proximity_Grid.h"
 #include <AP_Vehicle/AP_Vehicle_Type.h>
 
 #include <AP_HAL/Semaphores.h>
@@ -204,6 +205,11 @@ public:
     // 3D boundary
     AP_Proximity_Boundary_3D boundary;
 
+#if AP_PROXIMITY_GRID_ENABLED
+    // high resolution grid, enabled if PRX_GRID_SECT is non-zero
+    AP_Proximity_Grid grid;
+#endif
+
     // Check if Obstacle defined by body-frame yaw and pitch is near ground
     bool check_obstacle_near_ground(float pitch, float yaw, float distance) const;
 
@@ -231,6 +237,10 @@ private:
     AP_Int8 _ign_gnd_enable;                           // true if land detection should be enabled
     AP_Float _filt_freq;                               // cutoff frequency for low pass filter
     AP_Float _alt_min;                                 // Minimum altitude -in meters- below which proximity should not work.
+#if AP_PROXIMITY_GRID_ENABLED
+    AP_Int16 _grid_sectors;                            // number of horizontal cells in the high resolution grid, zero to disable
+    AP_Int8 _grid_layers;                              // number of vertical cells in the high resolution grid
+#endif
 
     // get alt from rangefinder in meters. This reading is corrected for vehicle tilt
     bool get_rangefinder_alt(float &alt_m) const;
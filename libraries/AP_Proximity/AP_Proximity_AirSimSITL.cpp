@@ -62,6 +62,8 @@ void AP_Proximity_AirSimSITL::update(void)
             const AP_Proximity_Boundary_3D::Face face = frontend.boundary.get_face(yaw_angle_deg);
             // store the min distance in each face in a temp boundary
             temp_boundary.add_distance(face, yaw_angle_deg, safe_sqrt(distance_sq));
+            // update high resolution grid
+            grid_push(yaw_angle_deg, safe_sqrt(distance_sq));
 
             // check distance from previous point to reduce amount of data sent to object database
             if (!prev_pos_valid || ((new_pos - prev_pos).length_squared() >= accuracy_sq)) {
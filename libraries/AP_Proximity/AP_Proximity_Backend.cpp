@@ -85,6 +85,15 @@ bool AP_Proximity_Backend::ignore_reading(float pitch, float yaw, float distance
    return frontend.check_obstacle_near_ground(pitch, yaw, distance_m);
 }
 
+// add a reading to the high resolution grid, if enabled
+// pitch and yaw are body-frame angles in degrees, distance is in meters
+void AP_Proximity_Backend::grid_push(float pitch, float yaw, float distance)
+{
+#if AP_PROXIMITY_GRID_ENABLED
+    frontend.grid.add_distance(pitch, yaw, distance);
+#endif
+}
+
 // returns true if database is ready to be pushed to and all cached data is ready
 bool AP_Proximity_Backend::database_prepare_for_push(Vector3f &current_pos, Matrix3f &body_to_ned)
 {
@@ -71,6 +71,11 @@ protected:
     bool ignore_reading(float pitch, float yaw, float distance_m, bool check_for_ign_area = true) const;
     bool ignore_reading(float yaw, float distance_m, bool check_for_ign_area = true) const { return ignore_reading(0.0f, yaw, distance_m, check_for_ign_area); }
 
+    // add a reading to the high resolution grid, if enabled
+    // pitch and yaw are body-frame angles in degrees, distance is in meters
+    void grid_push(float pitch, float yaw, float distance);
+    void grid_push(float yaw, float distance) { grid_push(0.0f, yaw, distance); }
+
     // database helpers. All angles are in degrees
     static bool database_prepare_for_push(Vector3f &current_pos, Matrix3f &body_to_ned);
     // Note: "angle" refers to yaw (in body frame) towards the obstacle
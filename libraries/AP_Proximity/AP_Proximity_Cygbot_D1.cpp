@@ -155,6 +155,8 @@ void AP_Proximity_Cygbot_D1::parse_payload()
 
             // push face to temp boundary
             _temp_boundary.add_distance(face, corrected_angle, distance_m);
+            // update high resolution grid
+            grid_push(corrected_angle, distance_m);
             // push to OA_DB
             database_push(corrected_angle, distance_m);
         }
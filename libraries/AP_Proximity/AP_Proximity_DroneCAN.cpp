@@ -126,6 +126,8 @@ void AP_Proximity_DroneCAN::update(void)
             if (!is_zero(object_item.distance_m) && !ignore_reading(object_item.pitch_deg, object_item.yaw_deg, object_item.distance_m, false)) {
                 // update boundary used for avoidance
                 frontend.boundary.set_face_attributes(face, object_item.pitch_deg, object_item.yaw_deg, object_item.distance_m, state.instance);
+                // update high resolution grid
+                grid_push(object_item.pitch_deg, object_item.yaw_deg, object_item.distance_m);
                 // update OA database
                 database_push(object_item.pitch_deg, object_item.yaw_deg, object_item.distance_m);
             }
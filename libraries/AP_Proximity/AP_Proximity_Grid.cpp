@@ -0,0 +1,156 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Proximity_Grid.h"
+
+#if AP_PROXIMITY_GRID_ENABLED
+
+#include <AP_HAL/AP_HAL.h>
+#include "AP_Proximity_Boundary_3D.h"
+
+#define PROXIMITY_GRID_MERGE_MS         50      // readings within this many ms of a cell's last update are combined, keeping the shortest
+#define PROXIMITY_GRID_TIMEOUT_CHECK_MS 500     // cells are checked for timeout at this interval
+
+// allocate a grid with the given number of cells
+// returns false if the grid is disabled (num_sectors is zero) or could not be allocated
+bool AP_Proximity_Grid::init(uint16_t num_sectors, uint8_t num_layers)
+{
+    if (enabled() || num_sectors == 0) {
+        return false;
+    }
+    num_sectors = MIN(num_sectors, PROXIMITY_GRID_SECTORS_MAX);
+    num_layers = constrain_int16(num_layers, 1, PROXIMITY_GRID_LAYERS_MAX);
+
+    _sector_sin = NEW_NOTHROW float[num_sectors * 2];
+    if (_sector_sin == nullptr) {
+        return false;
+    }
+    _sector_cos = &_sector_sin[num_sectors];
+    _sector_width_deg = 360.0f / num_sectors;
+    for (uint16_t sector = 0; sector < num_sectors; sector++) {
+        const float yaw_rad = radians(sector * _sector_width_deg);
+        _sector_sin[sector] = sinf(yaw_rad);
+        _sector_cos[sector] = cosf(yaw_rad);
+    }
+    _layer_width_deg = (PROXIMITY_GRID_PITCH_MAX_DEG * 2.0f) / num_layers;
+    for (uint8_t layer = 0; layer < num_layers; layer++) {
+        const float pitch_rad = radians(-PROXIMITY_GRID_PITCH_MAX_DEG + (layer + 0.5f) * _layer_width_deg);
+        _layer_sin[layer] = sinf(pitch_rad);
+        _layer_cos[layer] = cosf(pitch_rad);
+    }
+
+    // cells are zero, i.e. empty, after allocation
+    _cells = NEW_NOTHROW std::atomic<uint32_t>[num_sectors * num_layers];
+    if (_cells == nullptr) {
+        delete[] _sector_sin;
+        _sector_sin = nullptr;
+        _sector_cos = nullptr;
+        return false;
+    }
+    _num_sectors = num_sectors;
+    _num_layers = num_layers;
+    _num_cells = num_sectors * num_layers;
+    return true;
+}
+
+// returns true if a cell holds a distance updated within PROXIMITY_FACE_RESET_MS of now_ms
+bool AP_Proximity_Grid::cell_valid(uint32_t cell, uint16_t now_ms)
+{
+    return (cell_distance_cm(cell) != 0) && (uint16_t(now_ms - cell_time_ms(cell)) <= PROXIMITY_FACE_RESET_MS);
+}
+
+// add a reading to the cell it falls in
+// pitch and yaw are body-frame angles in degrees, distance is in meters
+void AP_Proximity_Grid::add_distance(float pitch, float yaw, float distance)
+{
+    if (!enabled() || !is_positive(distance) || isinf(distance)) {
+        return;
+    }
+
+    // cell 0 of each layer is centred directly ahead, like sector 0 of the 3D boundary
+    const uint16_t sector = uint16_t(wrap_360(yaw + _sector_width_deg * 0.5f) / _sector_width_deg) % _num_sectors;
+    const float pitch_limited = constrain_float(pitch, -PROXIMITY_GRID_PITCH_MAX_DEG, PROXIMITY_GRID_PITCH_MAX_DEG);
+    const uint8_t layer = MIN(uint8_t((pitch_limited + PROXIMITY_GRID_PITCH_MAX_DEG) / _layer_width_deg), _num_layers - 1);
+    std::atomic<uint32_t> &cell = _cells[layer * _num_sectors + sector];
+
+    const uint16_t distance_cm = constrain_float(distance * 100.0f, 1.0f, float(UINT16_MAX));
+    const uint16_t now_ms = AP_HAL::millis();
+    const uint32_t old_cell = cell;
+
+    // a scanning sensor usually sweeps several readings into a cell at
+    // once, of which we keep the shortest. A longer distance only
+    // replaces the cell's once it is no longer part of the same sweep
+    if ((cell_distance_cm(old_cell) != 0) &&
+        (distance_cm > cell_distance_cm(old_cell)) &&
+        (uint16_t(now_ms - cell_time_ms(old_cell)) < PROXIMITY_GRID_MERGE_MS)) {
+        return;
+    }
+    cell = (uint32_t(now_ms) << 16) | distance_cm;
+}
+
+// empty cells which have not been updated for PROXIMITY_FACE_RESET_MS.
+// Readers also ignore stale cells, this only stops the 16 bit update
+// times of old cells wrapping around to look recent again
+void AP_Proximity_Grid::check_cell_timeout()
+{
+    if (!enabled()) {
+        return;
+    }
+
+    // exit immediately if already checked recently
+    const uint32_t now_ms = AP_HAL::millis();
+    if ((now_ms - _last_check_cell_timeout_ms) < PROXIMITY_GRID_TIMEOUT_CHECK_MS) {
+        return;
+    }
+    _last_check_cell_timeout_ms = now_ms;
+
+    for (uint16_t i = 0; i < _num_cells; i++) {
+        // read the cell before the time, as a cell updated by another
+        // thread after now_ms was taken would look about 65 seconds old
+        uint32_t cell = _cells[i];
+        if ((cell != 0) && !cell_valid(cell, AP_HAL::millis())) {
+            // only empty the cell if it still holds the stale reading,
+            // so a reading added since by another thread is kept
+            _cells[i].compare_exchange_strong(cell, 0);
+        }
+    }
+}
+
+// returns a body frame vector (in cm, z up) to the obstacle in a cell
+// false is returned if the cell is empty, stale or its obstacle is further than dist_max_cm
+bool AP_Proximity_Grid::get_obstacle(uint16_t obstacle_num, float dist_max_cm, Vector3f &vec_to_obstacle) const
+{
+    if (obstacle_num >= _num_cells) {
+        return false;
+    }
+    // read the cell once, it may be updated by another thread
+    const uint32_t cell = _cells[obstacle_num];
+    const uint16_t distance_cm = cell_distance_cm(cell);
+    if ((distance_cm > dist_max_cm) || !cell_valid(cell, AP_HAL::millis())) {
+        return false;
+    }
+
+    // obstacle lies at the middle of the cell, as
+    // Vector3f::offset_bearing(yaw, pitch, distance_cm) would place it
+    const uint8_t layer = obstacle_num / _num_sectors;
+    const uint16_t sector = obstacle_num % _num_sectors;
+    const float horizontal_cm = _layer_cos[layer] * distance_cm;
+    vec_to_obstacle.x = _sector_cos[sector] * horizontal_cm;
+    vec_to_obstacle.y = _sector_sin[sector] * horizontal_cm;
+    vec_to_obstacle.z = _layer_sin[layer] * distance_cm;
+    return true;
+}
+
+#endif // AP_PROXIMITY_GRID_ENABLED
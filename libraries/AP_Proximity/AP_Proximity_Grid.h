@@ -0,0 +1,96 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "AP_Proximity_config.h"
+
+#if AP_PROXIMITY_GRID_ENABLED
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include <atomic>
+
+#define PROXIMITY_GRID_SECTORS_MAX      360     // maximum number of horizontal cells
+#define PROXIMITY_GRID_LAYERS_MAX       15      // maximum number of vertical cells
+#define PROXIMITY_GRID_PITCH_MAX_DEG    75.0f   // layers cover pitch angles between plus and minus this many degrees, like the 3D boundary
+
+/*
+  High resolution polar grid of the obstacles around the vehicle.
+
+  The 3D boundary keeps one distance for each 45 by 30 degree face,
+  which throws away most of what a scanning lidar sees. The grid
+  instead divides the body-frame yaw and pitch around the vehicle into
+  a configurable number of cells, and backends add every reading to
+  it. Each cell holds the shortest distance seen in it recently.
+
+  Each cell is a single 32 bit word holding the distance and the time
+  it was last updated, so it can be read from other threads without a
+  lock. Obstacle numbers are cell numbers, so a full pass over the
+  obstacles always costs the same no matter how many readings arrive
+ */
+class AP_Proximity_Grid
+{
+public:
+
+    // allocate a grid with the given number of cells
+    // returns false if the grid is disabled (num_sectors is zero) or could not be allocated
+    bool init(uint16_t num_sectors, uint8_t num_layers);
+
+    // true if the grid has been allocated
+    bool enabled() const { return _cells != nullptr; }
+
+    // add a reading to the cell it falls in
+    // pitch is the vertical body-frame angle (in degrees) to the obstacle (0=directly ahead, 90 is above the vehicle)
+    // yaw is the horizontal body-frame angle (in degrees) to the obstacle (0=directly ahead of the vehicle, 90 is to the right of the vehicle)
+    // distance is in meters
+    void add_distance(float pitch, float yaw, float distance);
+    void add_distance(float yaw, float distance) { add_distance(0.0f, yaw, distance); }
+
+    // empty cells which have not been updated for PROXIMITY_FACE_RESET_MS
+    void check_cell_timeout();
+
+    // get the total number of obstacles, one for each cell
+    uint16_t get_obstacle_count() const { return _num_cells; }
+
+    // returns a body frame vector (in cm, z up) to the obstacle in a cell
+    // false is returned if the cell is empty, stale or its obstacle is further than dist_max_cm
+    bool get_obstacle(uint16_t obstacle_num, float dist_max_cm, Vector3f &vec_to_obstacle) const;
+
+private:
+
+    // cells hold the distance in cm in the lower 16 bits, zero if empty,
+    // and the lowest 16 bits of the system time in ms of the last update
+    // in the upper 16 bits
+    static uint16_t cell_distance_cm(uint32_t cell) { return cell & 0xFFFFU; }
+    static uint16_t cell_time_ms(uint32_t cell) { return cell >> 16; }
+
+    // returns true if a cell holds a distance updated within PROXIMITY_FACE_RESET_MS of now_ms
+    static bool cell_valid(uint32_t cell, uint16_t now_ms);
+
+    std::atomic<uint32_t> *_cells;  // cells, layer by layer, each layer starting directly ahead and going clockwise
+    float *_sector_sin;         // sine and cosine of the middle yaw of each sector, allocated together
+    float *_sector_cos;
+    float _layer_sin[PROXIMITY_GRID_LAYERS_MAX];    // sine and cosine of the middle pitch of each layer
+    float _layer_cos[PROXIMITY_GRID_LAYERS_MAX];
+    uint16_t _num_sectors;      // number of horizontal cells
+    uint8_t _num_layers;        // number of vertical cells
+    uint16_t _num_cells;        // total number of cells
+    float _sector_width_deg;    // width of each sector in degrees
+    float _layer_width_deg;     // height of each layer in degrees
+    uint32_t _last_check_cell_timeout_ms;   // system time check_cell_timeout last ran
+};
+
+#endif // AP_PROXIMITY_GRID_ENABLED
@@ -178,6 +178,9 @@ void AP_Proximity_LD06::parse_response_data()
             continue;
         }
 
+        // update high resolution grid
+        grid_push(angle_deg, distance_m);
+
         uint16_t a2d = (int)(angle_deg / 2.0) * 2;
         if (_angle_2deg == a2d) {
             if (distance_m < _dist_2deg_m) {
@@ -344,6 +344,9 @@ void AP_Proximity_LightWareSF40C::process_message()
             if (!ignore_reading(angle_deg, dist_m)) {
                 // check distance reading is valid
                 if ((dist_cm >= dist_min_cm) && (dist_cm <= dist_max_cm)) {
+                    // update high resolution grid
+                    grid_push(angle_deg, dist_m);
+
                     // update shortest distance for this face
                     if (!_face_distance_valid || dist_m < _face_distance) {
                         _face_distance = dist_m;
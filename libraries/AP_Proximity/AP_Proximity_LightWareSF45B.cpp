@@ -174,6 +174,9 @@ void AP_Proximity_LightWareSF45B::process_message()
 
         // check reading is valid
         if (!ignore_reading(angle_deg, distance_m) && (distance_m >= distance_min()) && (distance_m <= distance_max())) {
+            // update high resolution grid
+            grid_push(angle_deg, distance_m);
+
             // update shortest distance for this face
             if (!_face_distance_valid || (distance_m < _face_distance)) {
                 _face_yaw_deg = angle_deg;
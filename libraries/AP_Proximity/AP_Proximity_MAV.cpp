@@ -103,6 +103,8 @@ void AP_Proximity_MAV::handle_distance_sensor_msg(const mavlink_message_t &msg)
         const bool in_range = distance <= _distance_max && distance >= _distance_min;
         if (in_range && !ignore_reading(yaw_angle_deg, distance, false)) {
             temp_boundary.add_distance(face, yaw_angle_deg, distance);
+            // update high resolution grid
+            grid_push(yaw_angle_deg, distance);
             // update OA database
             database_push(yaw_angle_deg, distance);
         }
@@ -196,6 +198,9 @@ void AP_Proximity_MAV::handle_obstacle_distance_msg(const mavlink_message_t &msg
             face_distance_valid = true;
         }
 
+        // update high resolution grid
+        grid_push(mid_angle, packet_distance_m);
+
         // update Object Avoidance database with Earth-frame point
         if (database_ready) {
             database_push(mid_angle, packet_distance_m, _last_update_ms, current_pos, body_to_ned);
@@ -268,6 +273,9 @@ void AP_Proximity_MAV::handle_obstacle_distance_3d_msg(const mavlink_message_t &
     const AP_Proximity_Boundary_3D::Face face = frontend.boundary.get_face(pitch, yaw);
     temp_boundary.add_distance(face, pitch, yaw, obstacle.length());
 
+    // update high resolution grid
+    grid_push(pitch, yaw, obstacle.length());
+
     if (database_ready) {
         database_push(yaw, pitch, obstacle.length(),_last_update_ms, current_pos, body_to_ned);
     }
@@ -398,6 +398,8 @@ void AP_Proximity_RPLidarA2::parse_response_data()
             _last_distance_valid = false;
         }
         if (distance_m > distance_min()) {
+            // update high resolution grid
+            grid_push(angle_deg, distance_m);
             // update shortest distance
             if (!_last_distance_valid || (distance_m < _last_distance_m)) {
                 _last_distance_m = distance_m;
@@ -55,6 +55,8 @@ void AP_Proximity_RangeFinder::update(void)
                 _distance_max = sensor->max_distance();
                 if ((distance <= _distance_max) && (distance >= _distance_min) && !ignore_reading(angle, distance, false)) {
                     frontend.boundary.set_face_attributes(face, angle, distance, state.instance);
+                    // update high resolution grid
+                    grid_push(angle, distance);
                     // update OA database
                     database_push(angle, distance);
                 } else {
@@ -65,6 +65,8 @@ void AP_Proximity_SITL::update(void)
             float fence_distance;
             if (get_distance_to_fence(yaw_angle_deg, fence_distance)) {
                 frontend.boundary.set_face_attributes(face, yaw_angle_deg, fence_distance, state.instance);
+                // update high resolution grid
+                grid_push(yaw_angle_deg, fence_distance);
                 // update OA database
                 database_push(yaw_angle_deg, fence_distance);
             } else {
@@ -90,6 +90,9 @@ bool AP_Proximity_Scripting::handle_script_distance_msg(float dist_m, float yaw_
     // add to temp boundary
     temp_boundary.add_distance(face, pitch_deg, yaw_deg, dist_m);
 
+    // update high resolution grid
+    grid_push(pitch_deg, yaw_deg, dist_m);
+
     if (push_to_boundary) {
         temp_boundary.update_3D_boundary(state.instance, frontend.boundary);
         temp_boundary.reset();
@@ -104,6 +104,8 @@ void AP_Proximity_TeraRangerTower::update_sector_data(int16_t angle_deg, uint16_
     const AP_Proximity_Boundary_3D::Face face = frontend.boundary.get_face(angle_deg);
     if ((distance_mm != 0xffff) && !ignore_reading(angle_deg, distance_mm * 0.001f, false)) {
         frontend.boundary.set_face_attributes(face, angle_deg, ((float) distance_mm) / 1000, state.instance);
+        // update high resolution grid
+        grid_push(angle_deg, ((float) distance_mm) / 1000);
         // update OA database
         database_push(angle_deg, ((float) distance_mm) / 1000);
     } else {
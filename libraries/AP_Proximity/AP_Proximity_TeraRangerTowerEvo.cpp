@@ -159,6 +159,8 @@ void AP_Proximity_TeraRangerTowerEvo::update_sector_data(int16_t angle_deg, uint
     const bool valid = (distance_mm != 0xffff) && (distance_mm > 0x0001);
     if (valid && !ignore_reading(angle_deg, distance_mm * 0.001f, false)) {
         frontend.boundary.set_face_attributes(face, angle_deg, ((float) distance_mm) / 1000, state.instance);
+        // update high resolution grid
+        grid_push(angle_deg, ((float) distance_mm) / 1000);
         // update OA database
         database_push(angle_deg, ((float) distance_mm) / 1000);
     } else {
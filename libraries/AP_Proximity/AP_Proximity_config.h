@@ -12,6 +12,10 @@
 #define AP_PROXIMITY_BACKEND_DEFAULT_ENABLED HAL_PROXIMITY_ENABLED
 #endif
 
+#ifndef AP_PROXIMITY_GRID_ENABLED
+#define AP_PROXIMITY_GRID_ENABLED HAL_PROXIMITY_ENABLED
+#endif
+
 #ifndef AP_PROXIMITY_AIRSIMSITL_ENABLED
 #define AP_PROXIMITY_AIRSIMSITL_ENABLED AP_PROXIMITY_BACKEND_DEFAULT_ENABLED && (CONFIG_HAL_BOARD == HAL_BOARD_SITL)
 #endif
@@ -0,0 +1,189 @@
+#include <AP_gtest.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Proximity/AP_Proximity_Grid.h>
+#include <AP_Proximity/AP_Proximity_Boundary_3D.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_PROXIMITY_GRID_ENABLED
+
+// grid of 5 degree sectors and 30 degree layers, layer 2 centred on level
+#define GRID_SECTORS    72
+#define GRID_LAYERS     5
+#define GRID_LEVEL      (2 * GRID_SECTORS)
+
+static uint32_t now_ms = 1000;
+
+static void set_time(uint32_t time_ms)
+{
+    now_ms = time_ms;
+    hal.scheduler->stop_clock(uint64_t(now_ms) * 1000);
+}
+
+static void advance_time(uint32_t dt_ms)
+{
+    set_time(now_ms + dt_ms);
+}
+
+static uint16_t count_obstacles(const AP_Proximity_Grid &grid)
+{
+    uint16_t count = 0;
+    Vector3f vec;
+    for (uint16_t i=0; i<grid.get_obstacle_count(); i++) {
+        if (grid.get_obstacle(i, FLT_MAX, vec)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+TEST(AP_Proximity_Grid, Init)
+{
+    // grids are static, so start with no cells like the vehicle's
+    static AP_Proximity_Grid grid;
+    EXPECT_FALSE(grid.init(0, GRID_LAYERS));
+    EXPECT_FALSE(grid.enabled());
+    EXPECT_TRUE(grid.init(GRID_SECTORS, GRID_LAYERS));
+    EXPECT_TRUE(grid.enabled());
+    EXPECT_EQ(grid.get_obstacle_count(), GRID_SECTORS * GRID_LAYERS);
+    EXPECT_EQ(count_obstacles(grid), 0U);
+
+    // a second init does not replace the cells
+    EXPECT_FALSE(grid.init(10, 1));
+    EXPECT_EQ(grid.get_obstacle_count(), GRID_SECTORS * GRID_LAYERS);
+
+    static AP_Proximity_Grid limited;
+    EXPECT_TRUE(limited.init(1000, 100));
+    EXPECT_EQ(limited.get_obstacle_count(), PROXIMITY_GRID_SECTORS_MAX * PROXIMITY_GRID_LAYERS_MAX);
+}
+
+TEST(AP_Proximity_Grid, CellGeometry)
+{
+    static AP_Proximity_Grid grid;
+    ASSERT_TRUE(grid.init(GRID_SECTORS, GRID_LAYERS));
+    set_time(10000);
+
+    // sector 0 is centred directly ahead, so 2 degrees either side is in it
+    grid.add_distance(0, -2, 5.0f);
+    Vector3f vec;
+    ASSERT_TRUE(grid.get_obstacle(GRID_LEVEL, FLT_MAX, vec));
+    EXPECT_NEAR(vec.x, 500, 0.1);
+    EXPECT_NEAR(vec.y, 0, 0.1);
+    EXPECT_NEAR(vec.z, 0, 0.1);
+
+    // obstacles lie in the middle of their cell, in cm
+    grid.add_distance(0, 91, 2.0f);
+    ASSERT_TRUE(grid.get_obstacle(GRID_LEVEL + 18, FLT_MAX, vec));
+    EXPECT_NEAR(vec.x, 0, 0.1);
+    EXPECT_NEAR(vec.y, 200, 0.1);
+    EXPECT_NEAR(vec.z, 0, 0.1);
+
+    // yaw wraps, and pitch beyond the top and bottom layers is limited to them
+    grid.add_distance(80, 359, 3.0f);
+    ASSERT_TRUE(grid.get_obstacle(4 * GRID_SECTORS, FLT_MAX, vec));
+    EXPECT_NEAR(vec.length(), 300, 0.1);
+    EXPECT_NEAR(vec.z, 300 * sinf(radians(60)), 0.1);
+    grid.add_distance(-90, 180, 4.0f);
+    ASSERT_TRUE(grid.get_obstacle(GRID_SECTORS / 2, FLT_MAX, vec));
+    EXPECT_NEAR(vec.x, -400 * cosf(radians(60)), 0.1);
+    EXPECT_NEAR(vec.z, -400 * sinf(radians(60)), 0.1);
+    EXPECT_EQ(count_obstacles(grid), 4U);
+
+    // readings which can not be obstacles are ignored
+    grid.add_distance(0, 45, 0);
+    grid.add_distance(0, 45, -1);
+    grid.add_distance(0, 45, INFINITY);
+    EXPECT_EQ(count_obstacles(grid), 4U);
+
+    // obstacles further than the maximum distance are not returned
+    EXPECT_TRUE(grid.get_obstacle(GRID_LEVEL, 500, vec));
+    EXPECT_FALSE(grid.get_obstacle(GRID_LEVEL, 499, vec));
+    EXPECT_FALSE(grid.get_obstacle(grid.get_obstacle_count(), FLT_MAX, vec));
+}
+
+TEST(AP_Proximity_Grid, MergeAndReplace)
+{
+    static AP_Proximity_Grid grid;
+    ASSERT_TRUE(grid.init(GRID_SECTORS, GRID_LAYERS));
+    set_time(20000);
+    Vector3f vec;
+
+    // readings in the same sweep keep the shortest
+    grid.add_distance(0, 10, 5.0f);
+    grid.add_distance(0, 10.5, 4.0f);
+    advance_time(10);
+    grid.add_distance(0, 11, 6.0f);
+    ASSERT_TRUE(grid.get_obstacle(GRID_LEVEL + 2, FLT_MAX, vec));
+    EXPECT_NEAR(vec.length(), 400, 0.1);
+    EXPECT_EQ(count_obstacles(grid), 1U);
+
+    // a later sweep replaces a closer obstacle which has moved away
+    advance_time(60);
+    grid.add_distance(0, 10, 6.0f);
+    ASSERT_TRUE(grid.get_obstacle(GRID_LEVEL + 2, FLT_MAX, vec));
+    EXPECT_NEAR(vec.length(), 600, 0.1);
+
+    // distances are limited to what a cell holds
+    grid.add_distance(0, 20, 1000.0f);
+    ASSERT_TRUE(grid.get_obstacle(GRID_LEVEL + 4, FLT_MAX, vec));
+    EXPECT_NEAR(vec.length(), UINT16_MAX, 1);
+    grid.add_distance(0, 30, 0.001f);
+    ASSERT_TRUE(grid.get_obstacle(GRID_LEVEL + 6, FLT_MAX, vec));
+    EXPECT_NEAR(vec.length(), 1, 0.01);
+}
+
+TEST(AP_Proximity_Grid, Timeout)
+{
+    static AP_Proximity_Grid grid;
+    ASSERT_TRUE(grid.init(GRID_SECTORS, GRID_LAYERS));
+    set_time(30000);
+    Vector3f vec;
+
+    grid.add_distance(0, 0, 5.0f);
+    advance_time(PROXIMITY_FACE_RESET_MS);
+    grid.add_distance(0, 90, 5.0f);
+    EXPECT_TRUE(grid.get_obstacle(GRID_LEVEL, FLT_MAX, vec));
+
+    // readers ignore stale cells even before they are emptied
+    advance_time(1);
+    EXPECT_FALSE(grid.get_obstacle(GRID_LEVEL, FLT_MAX, vec));
+    EXPECT_TRUE(grid.get_obstacle(GRID_LEVEL + 18, FLT_MAX, vec));
+
+    // emptying stale cells keeps recent ones
+    grid.check_cell_timeout();
+    EXPECT_EQ(count_obstacles(grid), 1U);
+    EXPECT_TRUE(grid.get_obstacle(GRID_LEVEL + 18, FLT_MAX, vec));
+
+    // and a stale cell can be filled again
+    grid.add_distance(0, 0, 7.0f);
+    ASSERT_TRUE(grid.get_obstacle(GRID_LEVEL, FLT_MAX, vec));
+    EXPECT_NEAR(vec.length(), 700, 0.1);
+}
+
+TEST(AP_Proximity_Grid, TimeWrap)
+{
+    static AP_Proximity_Grid grid;
+    ASSERT_TRUE(grid.init(GRID_SECTORS, GRID_LAYERS));
+    Vector3f vec;
+
+    // a reading just before the lower 16 bits of the time wrap is
+    // still valid just after it
+    set_time(0x2FFF0);
+    grid.add_distance(0, 0, 5.0f);
+    advance_time(0x20);
+    EXPECT_TRUE(grid.get_obstacle(GRID_LEVEL, FLT_MAX, vec));
+    advance_time(PROXIMITY_FACE_RESET_MS);
+    EXPECT_FALSE(grid.get_obstacle(GRID_LEVEL, FLT_MAX, vec));
+
+    // and once emptied it does not come back when the 16 bit time
+    // comes round to its update time again
+    grid.check_cell_timeout();
+    set_time(0x2FFF0 + 0x10000);
+    EXPECT_FALSE(grid.get_obstacle(GRID_LEVEL, FLT_MAX, vec));
+    EXPECT_EQ(count_obstacles(grid), 0U);
+}
+
+#endif  // AP_PROXIMITY_GRID_ENABLED
+
+AP_GTEST_MAIN()
@@ -69,8 +69,8 @@ const AP_Param::GroupInfo AP_Scheduler::var_info[] = {
 
     // @Param: OPTIONS
     // @DisplayName: Scheduling options
-    // @Description: This controls optional aspects of the scheduler.
-    // @Bitmask: 0:Enable per-task perf info
+    // @Description: This controls optional aspects of the scheduler. Deadline scheduling runs tasks that are due in earliest-deadline-first order using a learnt estimate of each task's cost, and spreads tasks of the same rate across loops to even out the load per loop. Deadline scheduling only takes effect on restart.
+    // @Bitmask: 0:Enable per-task perf info,1:Deadline scheduling
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",  2, AP_Scheduler, _options, 0),
 
@@ -137,6 +137,21 @@ void AP_Scheduler::init(const AP_Scheduler::Task *tasks, uint8_t num_tasks, uint
         perf_info.allocate_task_info(_num_tasks);
     }
 
+#if AP_SCHEDULER_DEADLINE_SCHEDULING_ENABLED
+    if (_options & uint8_t(Options::DEADLINE_SCHEDULING)) {
+        _task_cost_us = NEW_NOTHROW uint16_t[_num_tasks];
+        _deadline_queue = NEW_NOTHROW DeadlineTask[_num_tasks];
+        if (_task_cost_us == nullptr || _deadline_queue == nullptr) {
+            delete[] _task_cost_us;
+            delete[] _deadline_queue;
+            _task_cost_us = nullptr;
+            _deadline_queue = nullptr;
+        } else {
+            spread_task_phases();
+        }
+    }
+#endif
+
     _log_performance_bit = log_performance_bit;
 
     // sanity check the task lists to ensure the priorities are
@@ -222,6 +237,9 @@ void AP_Scheduler::run(uint32_t time_available)
             common_tasks_offset++;
         }
 
+        // number of loops this task has been due for but not run
+        uint16_t late_loops = 0;
+
         if (task.priority > MAX_FAST_TASK_PRIORITIES) {
             const uint16_t dt = _tick_counter - _last_run[i];
             // we allow 0 to mean loop rate
@@ -246,59 +264,32 @@ void AP_Scheduler::run(uint32_t time_available)
                 task_not_achieved++;
             }
 
+#if AP_SCHEDULER_DEADLINE_SCHEDULING_ENABLED
+            if (_deadline_queue != nullptr) {
+                // run in deadline order once the fast tasks have run
+                queue_deadline_task(i, task, dt, interval_ticks);
+                continue;
+            }
+#endif
+
             if (_task_time_allowed > time_available) {
                 // not enough time to run this task.  Continue loop -
                 // maybe another task will fit into time remaining
                 continue;
             }
+            late_loops = dt - interval_ticks;
         } else {
             _task_time_allowed = get_loop_period_us();
         }
 
-        // run it
-        _task_time_started = now;
-        hal.util->persistent_data.scheduler_task = i;
-#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
-        fill_nanf_stack();
-#endif
-        task.function();
-        hal.util->persistent_data.scheduler_task = -1;
-
-        // record the tick counter when we ran. This drives
-        // when we next run the event
-        _last_run[i] = _tick_counter;
-
-        // work out how long the event actually took
-        now = AP_HAL::micros();
-        uint32_t time_taken = now - _task_time_started;
-        bool overrun = false;
-        if (time_taken > _task_time_allowed) {
-            overrun = true;
-            // the event overran!
-            debug(3, "Scheduler overrun task[%u-%s] (%u/%u)\n",
-                  (unsigned)i,
-                  task.name,
-                  (unsigned)time_taken,
-                  (unsigned)_task_time_allowed);
-        }
+        run_task(i, task, late_loops, now, time_available);
+    }
 
-        perf_info.update_task_info(i, time_taken, overrun);
-
-        if (time_taken >= time_available) {
-            /*
-              we are out of time, but we need to keep walking the task
-              table in case there is another fast loop task after this
-              task, plus we need to update the accouting so we can
-              work out if we need to allocate extra time for the loop
-              (lower the loop rate)
-              Just set time_available to zero, which means we will
-              only run fast tasks after this one
-             */
-            time_available = 0;
-        } else {
-            time_available -= time_taken;
-        }
+#if AP_SCHEDULER_DEADLINE_SCHEDULING_ENABLED
+    if (_deadline_queue != nullptr) {
+        run_deadline_tasks(now, time_available);
     }
+#endif
 
     // update number of spare microseconds
     _spare_micros += time_available;
@@ -310,6 +301,151 @@ void AP_Scheduler::run(uint32_t time_available)
     }
 }
 
+/*
+  run a single task and account for the time it took
+ */
+void AP_Scheduler::run_task(uint8_t i, const Task &task, uint16_t late_loops, uint32_t &now, uint32_t &time_available)
+{
+    _task_time_started = now;
+#if AP_SCHEDULER_TASK_HISTOGRAMS_ENABLED
+    // start jitter is measured from the start of the loop the
+    // task became due in
+    perf_info.update_task_latency(i, late_loops * get_loop_period_us() + (now - uint32_t(_loop_sample_time_us)), late_loops);
+#endif
+    hal.util->persistent_data.scheduler_task = i;
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    fill_nanf_stack();
+#endif
+    task.function();
+    hal.util->persistent_data.scheduler_task = -1;
+
+    // record the tick counter when we ran. This drives
+    // when we next run the event
+    _last_run[i] = _tick_counter;
+
+    // work out how long the event actually took
+    now = AP_HAL::micros();
+    uint32_t time_taken = now - _task_time_started;
+    bool overrun = false;
+    if (time_taken > _task_time_allowed) {
+        overrun = true;
+        // the event overran!
+        debug(3, "Scheduler overrun task[%u-%s] (%u/%u)\n",
+              (unsigned)i,
+              task.name,
+              (unsigned)time_taken,
+              (unsigned)_task_time_allowed);
+    }
+
+    perf_info.update_task_info(i, time_taken, overrun);
+
+#if AP_SCHEDULER_DEADLINE_SCHEDULING_ENABLED
+    if (_task_cost_us != nullptr) {
+        /*
+          track a decaying maximum of the task cost, so the estimate
+          follows the upper end of the cost distribution and recovers
+          slowly after a one-off spike
+         */
+        uint16_t &cost = _task_cost_us[i];
+        if (time_taken >= cost) {
+            cost = MIN(time_taken, UINT16_MAX);
+        } else {
+            cost -= (cost - time_taken) / 32;
+        }
+    }
+#endif
+
+    if (time_taken >= time_available) {
+        /*
+          we are out of time, but we need to keep walking the task
+          table in case there is another fast loop task after this
+          task, plus we need to update the accouting so we can
+          work out if we need to allocate extra time for the loop
+          (lower the loop rate)
+          Just set time_available to zero, which means we will
+          only run fast tasks after this one
+         */
+        time_available = 0;
+    } else {
+        time_available -= time_taken;
+    }
+}
+
+#if AP_SCHEDULER_DEADLINE_SCHEDULING_ENABLED
+/*
+  add a task that is due to the deadline queue. The deadline of a task
+  is the tick at which it would become due again, so the queue is
+  kept sorted by the number of ticks left until then. Ties keep
+  priority order
+ */
+void AP_Scheduler::queue_deadline_task(uint8_t i, const Task &task, uint16_t dt, uint16_t interval_ticks)
+{
+    const int32_t slack = int32_t(interval_ticks) * 2 - dt;
+    uint8_t pos = _num_deadline_queued;
+    while (pos > 0 && _deadline_queue[pos-1].slack > slack) {
+        _deadline_queue[pos] = _deadline_queue[pos-1];
+        pos--;
+    }
+    auto &q = _deadline_queue[pos];
+    q.task = &task;
+    q.slack = slack;
+    q.late_loops = dt - interval_ticks;
+    q.index = i;
+    _num_deadline_queued++;
+}
+
+/*
+  run queued tasks earliest deadline first, using the learnt cost of
+  each task to decide if it fits in the remaining time
+ */
+void AP_Scheduler::run_deadline_tasks(uint32_t &now, uint32_t &time_available)
+{
+    for (uint8_t n = 0; n < _num_deadline_queued; n++) {
+        const auto &q = _deadline_queue[n];
+        const uint16_t cost = _task_cost_us[q.index] != 0 ? _task_cost_us[q.index] : q.task->max_time_micros;
+        if (cost > time_available) {
+            // maybe a later task will fit into the time remaining
+            continue;
+        }
+        _task_time_allowed = q.task->max_time_micros;
+        run_task(q.index, *q.task, q.late_loops, now, time_available);
+    }
+    _num_deadline_queued = 0;
+}
+
+/*
+  spread tasks with the same interval across the ticks of that
+  interval so they do not all become due in the same loop
+ */
+void AP_Scheduler::spread_task_phases(void)
+{
+    uint8_t vehicle_tasks_offset = 0;
+    uint8_t common_tasks_offset = 0;
+    uint16_t *interval = NEW_NOTHROW uint16_t[_num_tasks];
+    if (interval == nullptr) {
+        return;
+    }
+    for (uint8_t i = 0; i < _num_tasks; i++) {
+        const Task *task = next_task(vehicle_tasks_offset, common_tasks_offset);
+        if (task == nullptr) {
+            break;
+        }
+        interval[i] = is_zero(task->rate_hz) ? 1 : MAX(_loop_rate_hz / task->rate_hz, 1);
+        if (task->priority <= MAX_FAST_TASK_PRIORITIES || interval[i] == 1) {
+            continue;
+        }
+        uint16_t same_interval = 0;
+        for (uint8_t j = 0; j < i; j++) {
+            if (interval[j] == interval[i]) {
+                same_interval++;
+            }
+        }
+        _last_run[i] = _tick_counter - (same_interval % interval[i]);
+    }
+    delete[] interval;
+}
+#endif  // AP_SCHEDULER_DEADLINE_SCHEDULING_ENABLED
+
 /*
   return number of micros until the current task reaches its deadline
  */
@@ -433,6 +569,9 @@ void AP_Scheduler::update_logging()
     if (_log_performance_bit != (uint32_t)-1 &&
         AP::logger().should_log(_log_performance_bit)) {
         Log_Write_Performance();
+#if AP_SCHEDULER_TASK_HISTOGRAMS_ENABLED
+        Log_Write_TaskHistograms();
+#endif
     }
     perf_info.set_loop_rate(get_loop_rate_hz());
     perf_info.reset();
@@ -473,8 +612,90 @@ void AP_Scheduler::Log_Write_Performance()
     };
     AP::logger().WriteCriticalBlock(&pkt, sizeof(pkt));
 }
+
+#if AP_SCHEDULER_TASK_HISTOGRAMS_ENABLED
+// @LoggerMessage: TSKH
+// @Description: Scheduler per-task timing histograms over the last second, recorded when SCHED_OPTIONS enables per-task perf info. Task numbers match the order in @SYS/tasks.txt
+// @Field: TimeUS: Time since system startup
+// @Field: T: task number
+// @Field: E0: number of runs taking less than 50us
+// @Field: E1: number of runs taking 50us to 100us
+// @Field: E2: number of runs taking 100us to 200us
+// @Field: E3: number of runs taking 200us to 500us
+// @Field: E4: number of runs taking 500us to 1000us
+// @Field: E5: number of runs taking 1000us or more
+// @Field: J0: number of runs starting less than 50us after the start of the loop the task became due in
+// @Field: J1: number of runs starting 50us to 200us after the task became due
+// @Field: J2: number of runs starting 200us to 1000us after the task became due
+// @Field: J3: number of runs starting 1000us to 2500us after the task became due
+// @Field: J4: number of runs starting 2500us to 10000us after the task became due
+// @Field: J5: number of runs starting 10000us or more after the task became due
+// @Field: JMax: maximum start jitter
+// @Field: Stv: maximum number of loops the task was due but not run
+
+// Write per-task timing histograms
+void AP_Scheduler::Log_Write_TaskHistograms()
+{
+    const uint64_t now_us = AP_HAL::micros64();
+    for (uint8_t i = 0; i < _num_tasks; i++) {
+        const AP::PerfInfo::TaskInfo* ti = perf_info.get_task_info(i);
+        if (ti == nullptr) {
+            return;
+        }
+        if (ti->tick_count == 0) {
+            continue;
+        }
+        AP::logger().Write(
+            "TSKH", "TimeUS,T,E0,E1,E2,E3,E4,E5,J0,J1,J2,J3,J4,J5,JMax,Stv", "s#------------s-", "F-------------F-", "QBHHHHHHHHHHHHIH",
+            now_us,
+            i,
+            ti->exec_hist[0], ti->exec_hist[1], ti->exec_hist[2],
+            ti->exec_hist[3], ti->exec_hist[4], ti->exec_hist[5],
+            ti->jitter_hist[0], ti->jitter_hist[1], ti->jitter_hist[2],
+            ti->jitter_hist[3], ti->jitter_hist[4], ti->jitter_hist[5],
+            ti->max_jitter_us,
+            ti->max_starved_loops);
+    }
+}
+#endif  // AP_SCHEDULER_TASK_HISTOGRAMS_ENABLED
 #endif  // HAL_LOGGING_ENABLED
 
+/*
+  return the next task in run() order, merging the vehicle and common
+  task lists by priority, and advance the matching offset
+ */
+const AP_Scheduler::Task *AP_Scheduler::next_task(uint8_t &vehicle_tasks_offset, uint8_t &common_tasks_offset) const
+{
+    // determine which of the common task / vehicle task to run
+    bool run_vehicle_task = false;
+    if (vehicle_tasks_offset < _num_vehicle_tasks &&
+        common_tasks_offset < _num_common_tasks) {
+        // still have entries on both lists; compare the
+        // priorities.  In case of a tie the vehicle-specific
+        // entry wins.
+        const Task &vehicle_task = _vehicle_tasks[vehicle_tasks_offset];
+        const Task &common_task = _common_tasks[common_tasks_offset];
+        if (vehicle_task.priority <= common_task.priority) {
+            run_vehicle_task = true;
+        }
+    } else if (vehicle_tasks_offset < _num_vehicle_tasks) {
+        // out of common tasks to run
+        run_vehicle_task = true;
+    } else if (common_tasks_offset < _num_common_tasks) {
+        // out of vehicle tasks to run
+        run_vehicle_task = false;
+    } else {
+        // this is an error; the outside loop should have terminated
+        INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
+        return nullptr;
+    }
+
+    if (run_vehicle_task) {
+        return &_vehicle_tasks[vehicle_tasks_offset++];
+    }
+    return &_common_tasks[common_tasks_offset++];
+}
+
 // display task statistics as text buffer for @SYS/tasks.txt
 void AP_Scheduler::task_info(ExpandingString &str)
 {
@@ -505,40 +726,30 @@ void AP_Scheduler::task_info(ExpandingString &str)
 
     for (uint8_t i = 0; i < _num_tasks; i++) {
         const AP::PerfInfo::TaskInfo* ti = perf_info.get_task_info(i);
-        const char *task_name;
-
-        // determine which of the common task / vehicle task to run
-        bool run_vehicle_task = false;
-        if (vehicle_tasks_offset < _num_vehicle_tasks &&
-            common_tasks_offset < _num_common_tasks) {
-            // still have entries on both lists; compare the
-            // priorities.  In case of a tie the vehicle-specific
-            // entry wins.
-            const Task &vehicle_task = _vehicle_tasks[vehicle_tasks_offset];
-            const Task &common_task = _common_tasks[common_tasks_offset];
-            if (vehicle_task.priority <= common_task.priority) {
-                run_vehicle_task = true;
-            }
-        } else if (vehicle_tasks_offset < _num_vehicle_tasks) {
-            // out of common tasks to run
-            run_vehicle_task = true;
-        } else if (common_tasks_offset < _num_common_tasks) {
-            // out of vehicle tasks to run
-            run_vehicle_task = false;
-        } else {
-            // this is an error; the outside loop should have terminated
-            INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
+        const Task *task = next_task(vehicle_tasks_offset, common_tasks_offset);
+        if (task == nullptr) {
             return;
         }
+        ti->print(task->name, total_time, str);
+    }
 
-        if (run_vehicle_task) {
-            task_name = _vehicle_tasks[vehicle_tasks_offset++].name;
-        } else {
-            task_name = _common_tasks[common_tasks_offset++].name;
+#if AP_SCHEDULER_TASK_HISTOGRAMS_ENABLED
+    // histograms of execution time and start jitter, bucketed at
+    // <50/<100/<200/<500/<1000/>=1000us for EXEC and
+    // <50/<200/<1000/<2500/<10000/>=10000us for JIT. STV is the
+    // longest run of loops a task was due but not run
+    str.printf("TaskHistogramsV1\n");
+    vehicle_tasks_offset = 0;
+    common_tasks_offset = 0;
+    for (uint8_t i = 0; i < _num_tasks; i++) {
+        const AP::PerfInfo::TaskInfo* ti = perf_info.get_task_info(i);
+        const Task *task = next_task(vehicle_tasks_offset, common_tasks_offset);
+        if (task == nullptr) {
+            return;
         }
-
-        ti->print(task_name, total_time, str);
+        ti->print_histograms(task->name, str);
     }
+#endif
 }
 
 namespace AP {
@@ -93,7 +93,8 @@ public:
     };
 
     enum class Options : uint8_t {
-        RECORD_TASK_INFO = 1 << 0
+        RECORD_TASK_INFO = 1 << 0,
+        DEADLINE_SCHEDULING = 1 << 1,
     };
 
     enum FastTaskPriorities {
@@ -116,6 +117,11 @@ public:
     // write out PERF message to logger
     void Log_Write_Performance();
 
+#if AP_SCHEDULER_TASK_HISTOGRAMS_ENABLED
+    // write out per-task timing histograms to logger
+    void Log_Write_TaskHistograms();
+#endif
+
     // call when one tick has passed
     void tick(void);
 
@@ -273,6 +279,32 @@ private:
 
     // semaphore that is held while not waiting for ins samples
     HAL_Semaphore _rsem;
+
+    // next task in run() order
+    const Task *next_task(uint8_t &vehicle_tasks_offset, uint8_t &common_tasks_offset) const;
+
+    // run one task, updating now and time_available
+    void run_task(uint8_t i, const Task &task, uint16_t late_loops, uint32_t &now, uint32_t &time_available);
+
+#if AP_SCHEDULER_DEADLINE_SCHEDULING_ENABLED
+    // a task that is due to run in this loop
+    struct DeadlineTask {
+        const Task *task;
+        int32_t slack;          // ticks until the task is due again
+        uint16_t late_loops;
+        uint8_t index;
+    };
+    // due tasks sorted by deadline, allocated if deadline scheduling is enabled
+    DeadlineTask *_deadline_queue;
+    uint8_t _num_deadline_queued;
+
+    // learnt cost of each task in microseconds
+    uint16_t *_task_cost_us;
+
+    void queue_deadline_task(uint8_t i, const Task &task, uint16_t dt, uint16_t interval_ticks);
+    void run_deadline_tasks(uint32_t &now, uint32_t &time_available);
+    void spread_task_phases(void);
+#endif
 };
 
 namespace AP {
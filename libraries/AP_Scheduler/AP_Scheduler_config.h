@@ -9,3 +9,14 @@
 #ifndef AP_SCHEDULER_EXTENDED_TASKINFO_ENABLED
 #define AP_SCHEDULER_EXTENDED_TASKINFO_ENABLED 1
 #endif
+
+// per-task execution time and start jitter histograms, recorded when
+// per-task perf info is enabled
+#ifndef AP_SCHEDULER_TASK_HISTOGRAMS_ENABLED
+#define AP_SCHEDULER_TASK_HISTOGRAMS_ENABLED BOARD_FLASH_SIZE > 1024
+#endif
+
+// optional earliest-deadline-first scheduling of due tasks
+#ifndef AP_SCHEDULER_DEADLINE_SCHEDULING_ENABLED
+#define AP_SCHEDULER_DEADLINE_SCHEDULING_ENABLED BOARD_FLASH_SIZE > 1024
+#endif
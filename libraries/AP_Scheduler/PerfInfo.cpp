@@ -89,7 +89,49 @@ void AP::PerfInfo::TaskInfo::update(uint16_t task_time_us, bool overrun)
     if (overrun) {
         overrun_count++;
     }
+#if AP_SCHEDULER_TASK_HISTOGRAMS_ENABLED
+    uint8_t b = 0;
+    while (b < ARRAY_SIZE(exec_bucket_us) && task_time_us >= exec_bucket_us[b]) {
+        b++;
+    }
+    if (exec_hist[b] < UINT16_MAX) {
+        exec_hist[b]++;
+    }
+#endif
+}
+
+#if AP_SCHEDULER_TASK_HISTOGRAMS_ENABLED
+const uint16_t AP::PerfInfo::TaskInfo::exec_bucket_us[] { 50, 100, 200, 500, 1000 };
+const uint16_t AP::PerfInfo::TaskInfo::jitter_bucket_us[] { 50, 200, 1000, 2500, 10000 };
+
+void AP::PerfInfo::TaskInfo::update_latency(uint32_t jitter_us, uint16_t starved_loops)
+{
+    uint8_t b = 0;
+    while (b < ARRAY_SIZE(jitter_bucket_us) && jitter_us >= jitter_bucket_us[b]) {
+        b++;
+    }
+    if (jitter_hist[b] < UINT16_MAX) {
+        jitter_hist[b]++;
+    }
+    max_jitter_us = MAX(max_jitter_us, jitter_us);
+    max_starved_loops = MAX(max_starved_loops, starved_loops);
+}
+
+void AP::PerfInfo::TaskInfo::print_histograms(const char* task_name, ExpandingString& str) const
+{
+#if AP_SCHEDULER_EXTENDED_TASKINFO_ENABLED
+    const char* fmt = "%-32.32s EXEC=%u/%u/%u/%u/%u/%u JIT=%u/%u/%u/%u/%u/%u JMAX=%u STV=%u\n";
+#else
+    const char* fmt = "%-16.16s EXEC=%u/%u/%u/%u/%u/%u JIT=%u/%u/%u/%u/%u/%u JMAX=%u STV=%u\n";
+#endif
+    str.printf(fmt, task_name,
+               unsigned(exec_hist[0]), unsigned(exec_hist[1]), unsigned(exec_hist[2]),
+               unsigned(exec_hist[3]), unsigned(exec_hist[4]), unsigned(exec_hist[5]),
+               unsigned(jitter_hist[0]), unsigned(jitter_hist[1]), unsigned(jitter_hist[2]),
+               unsigned(jitter_hist[3]), unsigned(jitter_hist[4]), unsigned(jitter_hist[5]),
+               unsigned(max_jitter_us), unsigned(max_starved_loops));
 }
+#endif  // AP_SCHEDULER_TASK_HISTOGRAMS_ENABLED
 
 void AP::PerfInfo::TaskInfo::print(const char* task_name, uint32_t total_time, ExpandingString& str) const
 {
@@ -22,8 +22,27 @@ public:
         uint16_t slip_count;
         uint16_t overrun_count;
 
+#if AP_SCHEDULER_TASK_HISTOGRAMS_ENABLED
+        // histogram of execution times and of start times relative
+        // to the start of the loop the task became due in
+        static const uint8_t HIST_BUCKETS = 6;
+        uint16_t exec_hist[HIST_BUCKETS];
+        uint16_t jitter_hist[HIST_BUCKETS];
+        uint32_t max_jitter_us;
+        // longest run of loops a task was due but not run
+        uint16_t max_starved_loops;
+#endif
+
         void update(uint16_t task_time_us, bool overrun);
         void print(const char* task_name, uint32_t total_time, ExpandingString& str) const;
+#if AP_SCHEDULER_TASK_HISTOGRAMS_ENABLED
+        void update_latency(uint32_t jitter_us, uint16_t starved_loops);
+        void print_histograms(const char* task_name, ExpandingString& str) const;
+
+        // upper limits of each bucket but the last
+        static const uint16_t exec_bucket_us[HIST_BUCKETS-1];
+        static const uint16_t jitter_bucket_us[HIST_BUCKETS-1];
+#endif
     };
 
     /* Do not allow copies */
@@ -55,6 +74,15 @@ public:
     }
     // called after each run of a task to update its statistics based on measurements taken by the scheduler
     void update_task_info(uint8_t task_index, uint16_t task_time_us, bool overrun);
+#if AP_SCHEDULER_TASK_HISTOGRAMS_ENABLED
+    // called when a task is started with its start time relative to
+    // the loop it became due in and the number of loops it was late
+    void update_task_latency(uint8_t task_index, uint32_t jitter_us, uint16_t starved_loops) {
+        if (_task_info && task_index < _num_tasks) {
+            _task_info[task_index].update_latency(jitter_us, starved_loops);
+        }
+    }
+#endif
     // record that a task slipped
     void task_slipped(uint8_t task_index) {
         if (_task_info && task_index < _num_tasks) {
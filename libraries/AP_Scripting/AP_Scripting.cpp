@@ -20,6 +20,7 @@
 #include <AP_Scripting/AP_Scripting.h>
 #include <AP_HAL/AP_HAL.h>
 #include <GCS_MAVLink/GCS.h>
+#include <AP_Common/ExpandingString.h>
 
 #include "lua_scripts.h"
 
@@ -95,6 +96,7 @@ const AP_Param::GroupInfo AP_Scripting::var_info[] = {
     // @Bitmask: 4: Disable pre-arm check
     // @Bitmask: 5: Save CRC of current scripts to loaded and running checksum parameters enabling pre-arm
     // @Bitmask: 6: Disable heap expansion on allocation failure
+    // @Bitmask: 7: Cache compiled scripts on the filesystem to speed up loading
     // @User: Advanced
     AP_GROUPINFO("DEBUG_OPTS", 4, AP_Scripting, _debug_options, 0),
 
@@ -162,6 +164,14 @@ const AP_Param::GroupInfo AP_Scripting::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("THD_PRIORITY", 14, AP_Scripting, _thd_priority, uint8_t(ThreadPriority::NORMAL)),
 
+    // @Param: CPU_BUDGET
+    // @DisplayName: Scripting per-script CPU budget
+    // @Description: The largest share of the scripting thread's time that any one script may use. A script that averages more than this is run less often than it asks to be, leaving time for the other scripts. The time each script uses is shown in @SYS/scripts.txt. 0 disables the limit
+    // @Units: %
+    // @Range: 0 100
+    // @User: Advanced
+    AP_GROUPINFO("CPU_BUDGET", 19, AP_Scripting, _cpu_budget, 0),
+
 #if AP_SCRIPTING_SERIALDEVICE_ENABLED
     // @Param: SDEV_EN
     // @DisplayName: Scripting serial device enable
@@ -307,7 +317,7 @@ void AP_Scripting::thread(void) {
         _restart = false;
         _init_failed = false;
 
-        lua_scripts *lua = NEW_NOTHROW lua_scripts(_script_vm_exec_count, _script_heap_size, _debug_options);
+        lua_scripts *lua = NEW_NOTHROW lua_scripts(_script_vm_exec_count, _script_heap_size, _debug_options, _cpu_budget);
         if (lua == nullptr || !lua->heap_allocated()) {
             GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Scripting: %s", "Unable to allocate memory");
             _init_failed = true;
@@ -317,12 +327,20 @@ void AP_Scripting::thread(void) {
             // receive
             _serialdevice.clear();
 #endif
+            {
+                WITH_SEMAPHORE(_lua_sem);
+                _lua = lua;
+            }
             // run won't return while scripting is still active
             lua->run();
 
             // only reachable if the lua backend has died for any reason
             GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Scripting: %s", "stopped");
         }
+        {
+            WITH_SEMAPHORE(_lua_sem);
+            _lua = nullptr;
+        }
         delete lua;
         lua = nullptr;
 
@@ -466,6 +484,17 @@ bool AP_Scripting::arming_checks(size_t buflen, char *buffer) const
     return true;
 }
 
+// runtime statistics of each running script, for @SYS/scripts.txt
+void AP_Scripting::script_info(ExpandingString &str)
+{
+    WITH_SEMAPHORE(_lua_sem);
+    if (_lua == nullptr) {
+        str.printf("Scripting not running\n");
+        return;
+    }
+    _lua->runtime_info(str);
+}
+
 void AP_Scripting::restart_all()
 {
     _restart = true;
@@ -45,6 +45,9 @@ class SocketAPM;
 #include "AP_Scripting_SerialDevice.h"
 #endif
 
+class ExpandingString;
+class lua_scripts;
+
 class AP_Scripting
 {
 public:
@@ -73,6 +76,12 @@ public:
 
     static AP_Scripting * get_singleton(void) { return _singleton; }
 
+    // runtime statistics of each running script, for @SYS/scripts.txt
+    void script_info(ExpandingString &str);
+
+    // true if the arming checks compare the scripts with SCR_LD_CHECKSUM or SCR_RUN_CHECKSUM
+    bool checksums_required() const { return _required_loaded_checksum != -1 || _required_running_checksum != -1; }
+
     static const struct AP_Param::GroupInfo var_info[];
 
 #if HAL_GCS_ENABLED
@@ -160,6 +169,7 @@ public:
         DISABLE_PRE_ARM = 1U << 4,
         SAVE_CHECKSUM = 1U << 5,
         DISABLE_HEAP_EXPANSION = 1U << 6,
+        CACHE_COMPILED = 1U << 7,
     };
 
 private:
@@ -192,6 +202,7 @@ private:
     AP_Int16 _dir_disable;
     AP_Int32 _required_loaded_checksum;
     AP_Int32 _required_running_checksum;
+    AP_Int8 _cpu_budget;
 
     AP_Enum<ThreadPriority> _thd_priority;
 
@@ -210,6 +221,10 @@ private:
 
     static AP_Scripting *_singleton;
     int current_env_ref;
+
+    // the running scripts, for script_info()
+    lua_scripts *_lua;
+    HAL_Semaphore _lua_sem;
 };
 
 namespace AP {
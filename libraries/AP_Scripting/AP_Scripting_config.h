@@ -15,6 +15,12 @@
     #endif
 #endif
 
+// support caching compiled scripts on the filesystem so they load
+// faster, enabled with SCR_DEBUG_OPTS
+#ifndef AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+#define AP_SCRIPTING_BYTECODE_CACHE_ENABLED AP_SCRIPTING_ENABLED && AP_FILESYSTEM_FILE_WRITING_ENABLED
+#endif
+
 #ifndef AP_SCRIPTING_SERIALDEVICE_ENABLED
 #define AP_SCRIPTING_SERIALDEVICE_ENABLED AP_SERIALMANAGER_REGISTER_ENABLED && (BOARD_FLASH_SIZE>1024)
 #endif
@@ -715,6 +715,10 @@ LUALIB_API int luaL_loadfilex (lua_State *L, const char *filename,
   }
   else {
     lua_pushfstring(L, "@%s", filename);
+    if (lua_path_is_private(filename)) {
+      errno = EACCES;
+      return errfile(L, "open", fnameindex);
+    }
     lf.f = fopen(filename, "r");
     if (lf.f == NULL) return errfile(L, "open", fnameindex);
   }
@@ -772,6 +772,8 @@ static void checkmode (lua_State *L, const char *mode, const char *x) {
 }
 
 
+const char lua_trusted_binary_mode[] = "b";
+
 static void f_parser (lua_State *L, void *ud) {
   LClosure *cl;
   struct SParser *p = cast(struct SParser *, ud);
@@ -779,11 +781,14 @@ static void f_parser (lua_State *L, void *ud) {
 #if LUA_SUPPORT_LOAD_BINARY
   // support loading pre-compiled luac
   if (c == LUA_SIGNATURE[0]) {
+#else
+  // only the firmware's own compiled scripts may be binary
+  if (c == LUA_SIGNATURE[0] && p->mode == lua_trusted_binary_mode) {
+#endif
     checkmode(L, p->mode, "binary");
     cl = luaU_undump(L, p->z, p->name);
   }
   else
-#endif
   {
     checkmode(L, p->mode, "text");
     cl = luaY_parser(L, p->z, &p->buff, &p->dyd, p->name, c);
@@ -247,9 +247,21 @@ static LStream *newfile (lua_State *L) {
 }
 
 
+/*
+** open a file unless the firmware keeps it private from scripts
+*/
+static FILE *l_fopen (const char *fname, const char *mode) {
+  if (lua_path_is_private(fname)) {
+    errno = EACCES;
+    return NULL;
+  }
+  return fopen(fname, mode);
+}
+
+
 static void opencheck (lua_State *L, const char *fname, const char *mode) {
   LStream *p = newfile(L);
-  p->f = fopen(fname, mode);
+  p->f = l_fopen(fname, mode);
   if (p->f == NULL)
     luaL_error(L, "cannot open file '%s' (%s)", fname, strerror(errno));
 }
@@ -261,7 +273,7 @@ static int io_open (lua_State *L) {
   LStream *p = newfile(L);
   const char *md = mode;  /* to traverse/check mode */
   luaL_argcheck(L, l_checkmode(md), 2, "invalid mode");
-  p->f = fopen(filename, mode);
+  p->f = l_fopen(filename, mode);
   return (p->f == NULL) ? luaL_fileresult(L, 0, filename) : 1;
 }
 
@@ -281,6 +281,21 @@ LUA_API int   (lua_load) (lua_State *L, lua_Reader reader, void *dt,
 
 LUA_API int (lua_dump) (lua_State *L, lua_Writer writer, void *data, int strip);
 
+/*
+  mode for lua_load() that accepts binary chunks even when
+  LUA_SUPPORT_LOAD_BINARY is disabled. It is matched by address, so
+  scripts cannot pass it; only use it for chunks the firmware dumped
+  itself
+ */
+LUA_API const char lua_trusted_binary_mode[];
+
+/*
+  returns non-zero if scripts may not open or remove the file at path,
+  implemented by the firmware. The compiled chunks loaded with
+  lua_trusted_binary_mode are kept in such files
+ */
+LUA_API int (lua_path_is_private) (const char *path);
+
 
 /*
 ** coroutine functions
@@ -857,6 +857,11 @@ int lua_dirlist(lua_State *L) {
     const char *path = luaL_checkstring(L, 1);
     
     /* open directory */
+    if (lua_path_is_private(path)) {
+        lua_pushnil(L);
+        lua_pushstring(L, strerror(EACCES));
+        return 2;
+    }
     auto dir = AP::FS().opendir(path);
     if (dir == nullptr) {  /* error opening the directory? */
         lua_pushnil(L);  /* return nil and ... */
@@ -883,9 +888,28 @@ int lua_dirlist(lua_State *L) {
 int lua_removefile(lua_State *L) {
     binding_argcheck(L, 1);
     const char *filename = luaL_checkstring(L, 1);
+    if (lua_path_is_private(filename)) {
+        errno = EACCES;
+        return luaL_fileresult(L, false, filename);
+    }
     return luaL_fileresult(L, AP::FS().unlink(filename) == 0, filename);
 }
 
+/*
+  crc32 of a file, manual binding so scripts can't check the contents
+  of private files
+ */
+int lua_fs_crc32(lua_State *L) {
+    binding_argcheck(L, 2);
+    const char *filename = luaL_checkstring(L, 2);
+    uint32_t crc;
+    if (lua_path_is_private(filename) || !AP::FS().crc32(filename, crc)) {
+        return 0;
+    }
+    *new_uint32_t(L) = crc;
+    return 1;
+}
+
 // Manual binding to allow SRV_Channels table to see safety state
 int SRV_Channels_get_safety_state(lua_State *L) {
     binding_argcheck(L, 1);
@@ -17,6 +17,7 @@ int lua_serial_writestring(lua_State *L);
 int lua_serial_readstring(lua_State *L);
 int lua_dirlist(lua_State *L);
 int lua_removefile(lua_State *L);
+int lua_fs_crc32(lua_State *L);
 int SRV_Channels_get_safety_state(lua_State *L);
 int lua_get_PWMSource(lua_State *L);
 int lua_get_SocketAPM(lua_State *L);
@@ -21,6 +21,8 @@
 #include <AP_HAL/AP_HAL.h>
 #include "AP_Scripting.h"
 #include <AP_Logger/AP_Logger.h>
+#include <AP_Common/ExpandingString.h>
+#include <AP_Math/crc.h>
 
 #include <AP_Scripting/lua_generated_bindings.h>
 
@@ -36,13 +38,17 @@ HAL_Semaphore lua_scripts::error_msg_buf_sem;
 uint8_t lua_scripts::print_error_count;
 uint32_t lua_scripts::last_print_ms;
 
+size_t lua_scripts::heap_used;
+size_t lua_scripts::heap_peak;
+
 uint32_t lua_scripts::loaded_checksum;
 uint32_t lua_scripts::running_checksum;
 HAL_Semaphore lua_scripts::crc_sem;
 
-lua_scripts::lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size, AP_Int8 &debug_options)
+lua_scripts::lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size, AP_Int8 &debug_options, const AP_Int8 &cpu_budget)
     : _vm_steps(vm_steps),
-      _debug_options(debug_options)
+      _debug_options(debug_options),
+      _cpu_budget(cpu_budget)
 {
     const bool allow_heap_expansion = !option_is_set(AP_Scripting::DebugOption::DISABLE_HEAP_EXPANSION);
     _heap.create(heap_size, 10, allow_heap_expansion, 20*1024);
@@ -127,6 +133,19 @@ int lua_scripts::atpanic(lua_State *L) {
     return 0;
 }
 
+#if HAL_LOGGING_ENABLED
+// copy a script name to a log message, dropping the directory if it does not fit
+static void copy_log_name(char (&dest)[16], const char *name)
+{
+    const char * name_short = strrchr(name, '/');
+    if ((strlen(name) > sizeof(dest)) && (name_short != nullptr)) {
+        strncpy_noterm(dest, name_short+1, sizeof(dest));
+    } else {
+        strncpy_noterm(dest, name, sizeof(dest));
+    }
+}
+#endif // HAL_LOGGING_ENABLED
+
 // helper for print and log of runtime stats
 void lua_scripts::update_stats(const char *name, uint32_t run_time, int total_mem, int run_mem)
 {
@@ -146,19 +165,396 @@ void lua_scripts::update_stats(const char *name, uint32_t run_time, int total_me
             total_mem    : total_mem,
             run_mem      : run_mem
         };
-        const char * name_short = strrchr(name, '/');
-        if ((strlen(name) > sizeof(pkt.name)) && (name_short != nullptr)) {
-            strncpy_noterm(pkt.name, name_short+1, sizeof(pkt.name));
-        } else {
-            strncpy_noterm(pkt.name, name, sizeof(pkt.name));
+        copy_log_name(pkt.name, name);
+        AP::logger().WriteBlock(&pkt, sizeof(pkt));
+    }
+#endif // HAL_LOGGING_ENABLED
+}
+
+// return the value below which pct percent of a histogram lies
+uint32_t lua_scripts::hist_percentile(const uint16_t *hist, uint8_t pct)
+{
+    uint32_t total = 0;
+    for (uint8_t i=0; i<RUN_HIST_BINS; i++) {
+        total += hist[i];
+    }
+    const uint32_t target = (total * pct + 99) / 100;
+    uint32_t count = 0;
+    for (uint8_t i=0; i<RUN_HIST_BINS; i++) {
+        count += hist[i];
+        if (count >= target) {
+            // bin i holds values below 2^i
+            return 1U << i;
         }
+    }
+    return 1U << (RUN_HIST_BINS-1);
+}
+
+// record a run of a script in its statistics
+void lua_scripts::record_run(script_info *script, uint32_t run_us, int32_t run_mem)
+{
+    WITH_SEMAPHORE(list_sem);
+
+    run_stats &st = script->stats;
+    st.runs++;
+    st.run_time_us += run_us;
+    st.max_run_us = MAX(st.max_run_us, run_us);
+    st.max_run_mem = MAX(st.max_run_mem, run_mem);
+    // average over the last few runs, for SCR_CPU_BUDGET
+    st.avg_run_us = st.runs == 1 ? run_us : (st.avg_run_us * 7U + run_us) / 8U;
+
+    const uint32_t mem = MAX(run_mem, 0);
+    const uint8_t run_bin = MIN(run_us == 0 ? 0 : 32 - __builtin_clz(run_us), RUN_HIST_BINS-1);
+    const uint8_t mem_bin = MIN(mem == 0 ? 0 : 32 - __builtin_clz(mem), RUN_HIST_BINS-1);
+    if (st.run_hist[run_bin] == UINT16_MAX || st.mem_hist[mem_bin] == UINT16_MAX) {
+        // halve the counts, keeping the shape of the histograms while
+        // favouring recent runs
+        for (uint8_t i=0; i<RUN_HIST_BINS; i++) {
+            st.run_hist[i] /= 2;
+            st.mem_hist[i] /= 2;
+        }
+    }
+    st.run_hist[run_bin]++;
+    st.mem_hist[mem_bin]++;
+
+#if HAL_LOGGING_ENABLED
+    const uint32_t now_ms = AP_HAL::millis();
+    if (option_is_set(AP_Scripting::DebugOption::LOG_RUNTIME) && now_ms - st.last_log_ms >= 10000) {
+        st.last_log_ms = now_ms;
+        const uint64_t now_us = AP_HAL::micros64();
+        struct log_ScriptingStats pkt {
+            LOG_PACKET_HEADER_INIT(LOG_SCRIPTING_STATS_MSG),
+            time_us      : now_us,
+            name         : {},
+            runs         : st.runs,
+            cpu          : st.run_time_us * 100.0f / MAX(now_us - st.load_us, 1U),
+            run_p50      : hist_percentile(st.run_hist, 50),
+            run_p95      : hist_percentile(st.run_hist, 95),
+            run_max      : st.max_run_us,
+            mem_p50      : hist_percentile(st.mem_hist, 50),
+            mem_p95      : hist_percentile(st.mem_hist, 95),
+            mem_max      : st.max_run_mem,
+            throttled    : st.throttled
+        };
+        copy_log_name(pkt.name, script->name);
         AP::logger().WriteBlock(&pkt, sizeof(pkt));
     }
 #endif // HAL_LOGGING_ENABLED
 }
 
+/*
+  runtime statistics of each script. Run times are in microseconds
+  and memory in bytes; percentiles are rounded up to a power of two
+ */
+void lua_scripts::runtime_info(ExpandingString &str)
+{
+    WITH_SEMAPHORE(list_sem);
+
+    const uint64_t now_us = AP_HAL::micros64();
+    str.printf("Loaded %u scripts (%u cached) in %ums, heap peak %u bytes\n",
+               unsigned(load_stats.scripts), unsigned(load_stats.cached),
+               unsigned(load_stats.time_us / 1000U), unsigned(load_stats.heap_peak));
+    str.printf("%-20s %8s %6s %8s %8s %8s %8s %8s %8s %6s\n",
+               "Script", "Runs", "CPU%", "RunP50", "RunP95", "RunMax", "MemP50", "MemP95", "MemMax", "Thr");
+    script_info *script = running != nullptr ? running : scripts;
+    while (script != nullptr) {
+        const run_stats &st = script->stats;
+        const char *name = strrchr(script->name, '/');
+        str.printf("%-20s %8u %6.2f %8u %8u %8u %8u %8u %8d %6u\n",
+                   name != nullptr ? name+1 : script->name,
+                   unsigned(st.runs),
+                   st.run_time_us * 100.0f / MAX(now_us - st.load_us, 1U),
+                   unsigned(hist_percentile(st.run_hist, 50)),
+                   unsigned(hist_percentile(st.run_hist, 95)),
+                   unsigned(st.max_run_us),
+                   unsigned(hist_percentile(st.mem_hist, 50)),
+                   unsigned(hist_percentile(st.mem_hist, 95)),
+                   int(st.max_run_mem),
+                   unsigned(st.throttled));
+        script = (script == running) ? scripts : script->next;
+    }
+}
+
+#if AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+
+#include <AP_CheckFirmware/monocypher.h>
+
+// the cache directory's name is a valid 8.3 name, so FAT filesystems
+// don't give it a short alias that would get past lua_path_is_private()
+#define SCRIPTING_CACHE_NAME "luacache"
+#define SCRIPTING_CACHE_DIRECTORY SCRIPTING_DIRECTORY "/" SCRIPTING_CACHE_NAME
+#define SCRIPTING_CACHE_KEY_FILE SCRIPTING_CACHE_DIRECTORY "/key"
+#define SCRIPTING_CACHE_MAGIC 0x3243424CU // "LBC2"
+
+/*
+  scripts may not open, list or remove anything in the cache, so they
+  can neither read the key nor write chunks of their own. Any path
+  with a component matching the cache directory's name is refused,
+  ignoring case and the leading spaces and trailing dots and spaces
+  FAT filesystems drop from names
+ */
+int lua_path_is_private(const char *path)
+{
+    const size_t cache_name_len = strlen(SCRIPTING_CACHE_NAME);
+    while (*path != '\0') {
+        const char *end = path + strcspn(path, "/\\");
+        const char *p = path;
+        while (p < end && *p == ' ') {
+            p++;
+        }
+        const char *e = end;
+        while (e > p && (e[-1] == '.' || e[-1] == ' ')) {
+            e--;
+        }
+        if (size_t(e - p) == cache_name_len && strncasecmp(p, SCRIPTING_CACHE_NAME, cache_name_len) == 0) {
+            return 1;
+        }
+        path = (*end != '\0') ? end + 1 : end;
+    }
+    return 0;
+}
+
+/*
+  compiled scripts are kept in the cache directory in a file named
+  from the crc32 of the script's path, so scripts of the same name in
+  different directories don't share a file
+ */
+void lua_scripts::cache_filename(char *buf, uint8_t buflen, const char *filename, const char *ext)
+{
+    const uint32_t path_crc = crc_crc32(0, (const uint8_t *)filename, strlen(filename));
+    hal.util->snprintf(buf, buflen, SCRIPTING_CACHE_DIRECTORY "/%08lx.%s", (unsigned long)path_crc, ext);
+}
+
+/*
+  cached chunks are signed with a random key kept in the cache
+  directory, created the first time the cache is used. Chunks are
+  only loaded if they were signed with it, so a chunk can't be forged
+  or copied from another board
+ */
+bool lua_scripts::load_cache_key()
+{
+    auto &fs = AP::FS();
+    int fd = fs.open(SCRIPTING_CACHE_KEY_FILE, O_RDONLY);
+    if (fd != -1) {
+        const bool ok = fs.read(fd, cache_key, sizeof(cache_key)) == sizeof(cache_key);
+        fs.close(fd);
+        if (ok) {
+            return true;
+        }
+    }
+
+    // a new key invalidates everything signed with the old one
+    if ((fs.mkdir(SCRIPTING_CACHE_DIRECTORY) != 0 && errno != EEXIST) ||
+        !hal.util->get_random_vals(cache_key, sizeof(cache_key))) {
+        return false;
+    }
+    const char *tmp_name = SCRIPTING_CACHE_KEY_FILE ".tmp";
+    fd = fs.open(tmp_name, O_WRONLY|O_CREAT|O_TRUNC);
+    if (fd == -1) {
+        return false;
+    }
+    bool ok = fs.write(fd, cache_key, sizeof(cache_key)) == sizeof(cache_key);
+    ok = (fs.close(fd) == 0) && ok;
+    if (ok) {
+        fs.unlink(SCRIPTING_CACHE_KEY_FILE);
+        ok = fs.rename(tmp_name, SCRIPTING_CACHE_KEY_FILE) == 0;
+    }
+    if (!ok) {
+        fs.unlink(tmp_name);
+    }
+    return ok;
+}
+
+namespace {
+struct cache_reader {
+    int fd;
+    char buf[512];
+};
+
+struct cache_writer {
+    int fd;
+    crypto_blake2b_ctx mac;
+    uint32_t length;
+};
+}
+
+// start the mac of a cache entry, which covers the script's path, the
+// magic and source crc from its header and then its chunk
+static void cache_mac_init(crypto_blake2b_ctx &ctx, const uint8_t *key, uint8_t key_len, uint8_t mac_len,
+                           const char *filename, const void *header, size_t header_len)
+{
+    crypto_blake2b_general_init(&ctx, mac_len, key, key_len);
+    crypto_blake2b_update(&ctx, (const uint8_t *)filename, strlen(filename) + 1);
+    crypto_blake2b_update(&ctx, (const uint8_t *)header, header_len);
+}
+
+static const char *read_cache_chunk(lua_State *L, void *ud, size_t *size)
+{
+    cache_reader &r = *(cache_reader *)ud;
+    const int32_t n = AP::FS().read(r.fd, r.buf, sizeof(r.buf));
+    *size = MAX(n, 0);
+    return n > 0 ? r.buf : nullptr;
+}
+
+static int write_cache_chunk(lua_State *L, const void *p, size_t sz, void *ud)
+{
+    cache_writer &w = *(cache_writer *)ud;
+    if (AP::FS().write(w.fd, p, sz) != int32_t(sz)) {
+        return 1;
+    }
+    crypto_blake2b_update(&w.mac, (const uint8_t *)p, sz);
+    w.length += sz;
+    return 0;
+}
+
+bool lua_scripts::load_cached_script(lua_State *L, const char *filename, uint32_t source_crc)
+{
+    auto &fs = AP::FS();
+    char cache_name[64];
+    cache_filename(cache_name, sizeof(cache_name), filename, "luac");
+
+    cache_reader r;
+    r.fd = fs.open(cache_name, O_RDONLY);
+    if (r.fd == -1) {
+        return false;
+    }
+    cache_header h;
+    bool ok = fs.read(r.fd, &h, sizeof(h)) == sizeof(h) &&
+        h.magic == SCRIPTING_CACHE_MAGIC &&
+        h.source_crc == source_crc;
+    if (ok) {
+        // the chunk is not checked as it is loaded, so make sure we
+        // signed it before loading it
+        crypto_blake2b_ctx ctx;
+        cache_mac_init(ctx, cache_key, sizeof(cache_key), sizeof(h.mac), filename, &h, offsetof(cache_header, chunk_length));
+        uint32_t length = 0;
+        int32_t n;
+        while ((n = fs.read(r.fd, r.buf, sizeof(r.buf))) > 0) {
+            crypto_blake2b_update(&ctx, (const uint8_t *)r.buf, n);
+            length += n;
+        }
+        uint8_t mac[sizeof(h.mac)];
+        crypto_blake2b_final(&ctx, mac);
+        ok = n == 0 && length == h.chunk_length &&
+            crypto_verify16(mac, h.mac) == 0 &&
+            fs.lseek(r.fd, sizeof(h), SEEK_SET) == int32_t(sizeof(h));
+    }
+    if (ok) {
+        lua_pushfstring(L, "@%s", filename);
+        if (lua_load(L, read_cache_chunk, &r, lua_tostring(L, -1), lua_trusted_binary_mode) == LUA_OK) {
+            lua_remove(L, -2);
+        } else {
+            // fall back to compiling the script
+            lua_pop(L, 2);
+            ok = false;
+        }
+    }
+    fs.close(r.fd);
+    if (!ok) {
+        // out of date or not ours, it will be replaced once the script is compiled
+        fs.unlink(cache_name);
+    }
+    return ok;
+}
+
+void lua_scripts::save_cached_script(lua_State *L, const char *filename, uint32_t source_crc)
+{
+    auto &fs = AP::FS();
+    char cache_name[64];
+    char tmp_name[64];
+    cache_filename(cache_name, sizeof(cache_name), filename, "luac");
+    cache_filename(tmp_name, sizeof(tmp_name), filename, "tmp");
+
+    // write to a temporary file so a partly written chunk is never used
+    cache_writer w {};
+    w.fd = fs.open(tmp_name, O_WRONLY|O_CREAT|O_TRUNC);
+    if (w.fd == -1) {
+        return;
+    }
+    cache_header h {};
+    h.magic = SCRIPTING_CACHE_MAGIC;
+    h.source_crc = source_crc;
+    cache_mac_init(w.mac, cache_key, sizeof(cache_key), sizeof(h.mac), filename, &h, offsetof(cache_header, chunk_length));
+    bool ok = fs.write(w.fd, &h, sizeof(h)) == sizeof(h) &&
+        lua_dump(L, write_cache_chunk, &w, 0) == 0;
+    if (ok) {
+        h.chunk_length = w.length;
+        crypto_blake2b_final(&w.mac, h.mac);
+        ok = fs.lseek(w.fd, 0, SEEK_SET) == 0 &&
+            fs.write(w.fd, &h, sizeof(h)) == sizeof(h);
+    }
+    ok = (fs.close(w.fd) == 0) && ok;
+    if (ok) {
+        fs.unlink(cache_name);
+        ok = fs.rename(tmp_name, cache_name) == 0;
+    }
+    if (!ok) {
+        fs.unlink(tmp_name);
+    }
+}
+
+/*
+  remove the cached chunks and temporary files of scripts which were
+  not loaded, so removed and renamed scripts don't leave their chunks
+  behind
+ */
+void lua_scripts::remove_stale_cache_entries()
+{
+    auto &fs = AP::FS();
+    auto *d = fs.opendir(SCRIPTING_CACHE_DIRECTORY);
+    if (d == nullptr) {
+        return;
+    }
+    char cache_name[64];
+    char stale_name[64];
+    const size_t dir_len = strlen(SCRIPTING_CACHE_DIRECTORY "/");
+    for (struct dirent *de = fs.readdir(d); de != nullptr; de = fs.readdir(d)) {
+        const char *ext = strrchr(de->d_name, '.');
+        if (ext == nullptr || (strcmp(ext, ".luac") != 0 && strcmp(ext, ".tmp") != 0) ||
+            strncmp(de->d_name, "key.", 4) == 0) {
+            continue;
+        }
+        bool used = false;
+        for (const script_info *script = scripts; script != nullptr && !used; script = script->next) {
+            cache_filename(cache_name, sizeof(cache_name), script->name, "luac");
+            used = strcmp(&cache_name[dir_len], de->d_name) == 0;
+        }
+        if (!used) {
+            hal.util->snprintf(stale_name, sizeof(stale_name), SCRIPTING_CACHE_DIRECTORY "/%s", de->d_name);
+            fs.unlink(stale_name);
+        }
+    }
+    fs.closedir(d);
+}
+
+#else
+
+int lua_path_is_private(const char *path)
+{
+    return 0;
+}
+
+#endif // AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+
 lua_scripts::script_info *lua_scripts::load_script(lua_State *L, char *filename) {
-    if (int error = luaL_loadfile(L, filename)) {
+    const int loadMem = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+    const uint32_t loadStart = AP_HAL::micros();
+
+    // Get checksum of file
+    uint32_t crc = 0;
+    const bool have_crc = AP::FS().crc32(filename, crc);
+
+    bool cached = false;
+#if AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+    // a script loaded from the cache is not the one the checksums
+    // were taken from, so don't use it when they are checked
+    const bool use_cache = cache_enabled && have_crc && !AP::scripting()->checksums_required();
+    cached = use_cache && load_cached_script(L, filename, crc);
+#endif
+
+    if (cached) {
+        load_stats.cached++;
+    } else if (int error = luaL_loadfile(L, filename)) {
         switch (error) {
             case LUA_ERRSYNTAX:
                 set_and_print_new_error_message(MAV_SEVERITY_CRITICAL, "Error: %s", lua_tostring(L, -1));
@@ -178,9 +574,11 @@ lua_scripts::script_info *lua_scripts::load_script(lua_State *L, char *filename)
                 return nullptr;
         }
     }
-
-    const int loadMem = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
-    const uint32_t loadStart = AP_HAL::micros();
+#if AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+    else if (use_cache) {
+        save_cached_script(L, filename, crc);
+    }
+#endif
 
     script_info *new_script = (script_info *)_heap.allocate(sizeof(script_info));
     if (new_script == nullptr) {
@@ -198,16 +596,17 @@ lua_scripts::script_info *lua_scripts::load_script(lua_State *L, char *filename)
     const uint32_t loadEnd = AP_HAL::micros();
     const int endMem = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
 
-    update_stats(filename, loadEnd-loadStart, endMem, loadMem);
+    update_stats(filename, loadEnd-loadStart, endMem, endMem-loadMem);
+    load_stats.scripts++;
 
     new_script->name = filename;
     new_script->env_ref = luaL_ref(L, LUA_REGISTRYINDEX); // store reference to script's environment
     new_script->run_ref = luaL_ref(L, LUA_REGISTRYINDEX); // store reference to function to run
     new_script->next_run_ms = AP_HAL::millis64() - 1; // force the script to be stale
+    new_script->stats = {};
+    new_script->stats.load_us = AP_HAL::micros64();
 
-    // Get checksum of file
-    uint32_t crc = 0;
-    if (AP::FS().crc32(filename, crc)) {
+    if (have_crc) {
         // Record crc of this script
         new_script->crc = crc;
         {
@@ -322,7 +721,11 @@ void lua_scripts::run_next_script(lua_State *L) {
     uint64_t start_time_ms = AP_HAL::millis64();
     // strip the selected script out of the list
     script_info *script = scripts;
-    scripts = script->next;
+    {
+        WITH_SEMAPHORE(list_sem);
+        scripts = script->next;
+        running = script;
+    }
 
     // reset the hook to clear the counter
     reset_loop_overtime(L);
@@ -335,7 +738,17 @@ void lua_scripts::run_next_script(lua_State *L) {
     // set current environment for other users
     AP::scripting()->set_current_env_ref(script->env_ref);
 
-    if(lua_pcall(L, 0, LUA_MULTRET, 0)) {
+    const int start_mem = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+    const uint32_t start_us = AP_HAL::micros();
+
+    const int pcall_result = lua_pcall(L, 0, LUA_MULTRET, 0);
+
+    const uint32_t run_us = AP_HAL::micros() - start_us;
+    const int end_mem = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+    update_stats(script->name, run_us, end_mem, end_mem - start_mem);
+    record_run(script, run_us, end_mem - start_mem);
+
+    if (pcall_result) {
         if (overtime) {
             // script has consumed an excessive amount of CPU time
             set_and_print_new_error_message(MAV_SEVERITY_CRITICAL, "%s exceeded time limit", script->name);
@@ -371,6 +784,16 @@ void lua_scripts::run_next_script(lua_State *L) {
                     // types match the expectations, go ahead and reschedule
                     script->next_run_ms = start_time_ms + (uint64_t)luaL_checknumber(L, -1);
                     lua_pop(L, 1);
+                    const uint8_t budget = _cpu_budget.get();
+                    if (budget > 0 && budget < 100) {
+                        // hold the script's share of the thread within
+                        // its budget by running it less often
+                        const uint64_t budget_run_ms = start_time_ms + (uint64_t(script->stats.avg_run_us) * 100U / budget) / 1000U;
+                        if (script->next_run_ms < budget_run_ms) {
+                            script->next_run_ms = budget_run_ms;
+                            script->stats.throttled++;
+                        }
+                    }
                     int old_ref = script->run_ref;
                     script->run_ref = luaL_ref(L, LUA_REGISTRYINDEX);
                     luaL_unref(L, LUA_REGISTRYINDEX, old_ref);
@@ -394,6 +817,12 @@ void lua_scripts::remove_script(lua_State *L, script_info *script) {
         return;
     }
 
+    WITH_SEMAPHORE(list_sem);
+
+    if (running == script) {
+        running = nullptr;
+    }
+
     // ensure that the script isn't in the loaded list for any reason
     if (scripts == nullptr) {
         // nothing to do, already not in the list
@@ -431,6 +860,12 @@ void lua_scripts::reschedule_script(script_info *script) {
        return;
     }
 
+    WITH_SEMAPHORE(list_sem);
+
+    if (running == script) {
+        running = nullptr;
+    }
+
     script->next = nullptr;
     if (scripts == nullptr) {
         scripts = script;
@@ -462,7 +897,13 @@ MultiHeap lua_scripts::_heap;
 
 void *lua_scripts::alloc(void *ud, void *ptr, size_t osize, size_t nsize) {
     (void)ud; /* not used */
-    return _heap.change_size(ptr, osize, nsize);
+    void *ret = _heap.change_size(ptr, osize, nsize);
+    if (ret != nullptr || nsize == 0) {
+        // osize is the type of a new object rather than a size
+        heap_used += nsize - (ptr != nullptr ? osize : 0);
+        heap_peak = MAX(heap_peak, heap_used);
+    }
+    return ret;
 }
 
 void lua_scripts::run(void) {
@@ -481,10 +922,11 @@ void lua_scripts::run(void) {
         if (lua_state != nullptr) {
             lua_close(lua_state); // shutdown the old state
         }
-        // remove all the old scheduled scripts
+        // remove all the old scheduled scripts, and the one that was running
         for (script_info *script = scripts; script != nullptr; script = scripts) {
             remove_script(nullptr, script);
         }
+        remove_script(nullptr, running);
         scripts = nullptr;
         overtime = false;
     }
@@ -520,6 +962,12 @@ void lua_scripts::run(void) {
 
     // Scan the filesystem in an appropriate manner and autostart scripts
     // Skip those directores disabled with SCR_DIR_DISABLE param
+    load_stats = {};
+    heap_peak = heap_used;
+    const uint32_t load_start_us = AP_HAL::micros();
+#if AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+    cache_enabled = option_is_set(AP_Scripting::DebugOption::CACHE_COMPILED) && load_cache_key();
+#endif
     uint16_t dir_disable = AP_Scripting::get_singleton()->get_disabled_dir();
     bool loaded = false;
     if ((dir_disable & uint16_t(AP_Scripting::SCR_DIR::SCRIPTS)) == 0) {
@@ -535,6 +983,17 @@ void lua_scripts::run(void) {
     if (!loaded) {
         GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Lua: All directory's disabled see SCR_DIR_DISABLE");
     }
+#if AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+    if (cache_enabled) {
+        remove_stale_cache_entries();
+    }
+    crypto_wipe(cache_key, sizeof(cache_key));
+#endif
+    load_stats.time_us = AP_HAL::micros() - load_start_us;
+    load_stats.heap_peak = heap_peak;
+    DEV_PRINTF("Lua: Loaded %u scripts (%u cached) in %ums, heap peak %u\n",
+               unsigned(load_stats.scripts), unsigned(load_stats.cached),
+               unsigned(load_stats.time_us / 1000U), unsigned(load_stats.heap_peak));
 
 #ifndef __clang_analyzer__
     succeeded_initial_load = true;
@@ -570,34 +1029,22 @@ void lua_scripts::run(void) {
             if (option_is_set(AP_Scripting::DebugOption::RUNTIME_MSG)) {
                 GCS_SEND_TEXT(MAV_SEVERITY_DEBUG, "Lua: Running %s", scripts->name);
             }
-            // take a copy of the script name for the purposes of
-            // logging statistics.  "scripts" may become invalid
-            // during the "run_next_script" call, below.
-            char script_name[128+1] {};
-            strncpy_noterm(script_name, scripts->name, 128);
 
 #if DISABLE_INTERRUPTS_FOR_SCRIPT_RUN
             void *istate = hal.scheduler->disable_interrupts_save();
 #endif
 
-            const int startMem = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
-            const uint32_t loadEnd = AP_HAL::micros();
-
             // NOTE!  the base pointer of our scripts linked list,
             // *and all its contents* may become invalid as part of
             // "run_next_script"!  So do *NOT* attempt to access
-            // anything that was in *scripts after this call.
+            // anything that was in *scripts after this call. The
+            // statistics of the run are recorded inside it
             run_next_script(L);
 
-            const uint32_t runEnd = AP_HAL::micros();
-            const int endMem = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
-
 #if DISABLE_INTERRUPTS_FOR_SCRIPT_RUN
             hal.scheduler->restore_interrupts(istate);
 #endif
 
-            update_stats(script_name, runEnd - loadEnd, endMem, endMem - startMem);
-
 
             // garbage collect after each script, this shouldn't matter, but seems to resolve a memory leak
             lua_gc(L, LUA_GCCOLLECT, 0);
@@ -34,7 +34,7 @@
 class lua_scripts
 {
 public:
-    lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size, AP_Int8 &debug_options);
+    lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size, AP_Int8 &debug_options, const AP_Int8 &cpu_budget);
 
     ~lua_scripts();
 
@@ -48,21 +48,81 @@ public:
 
     static bool overtime; // script exceeded it's execution slot, and we are bailing out
 
+    // runtime statistics of each script, for @SYS/scripts.txt
+    void runtime_info(ExpandingString &str);
+
 private:
 
     void create_sandbox(lua_State *L);
 
+    // number of power of two bins in the run time and memory histograms
+    static constexpr uint8_t RUN_HIST_BINS = 20;
+
+    struct run_stats {
+       uint64_t load_us;          // time the script was loaded
+       uint64_t run_time_us;      // total time spent running the script
+       uint32_t runs;
+       uint32_t avg_run_us;       // recent average run time
+       uint32_t max_run_us;
+       int32_t max_run_mem;       // largest memory growth in one run
+       uint32_t throttled;        // runs delayed by SCR_CPU_BUDGET
+       uint32_t last_log_ms;
+       uint16_t run_hist[RUN_HIST_BINS]; // runs by log2 of run time in microseconds
+       uint16_t mem_hist[RUN_HIST_BINS]; // runs by log2 of memory growth in bytes
+    };
+
     typedef struct script_info {
        int env_ref;          // reference to the script's environment table
        int run_ref;          // reference to the function to run
        uint64_t next_run_ms; // time (in milliseconds) the script should next be run at
        uint32_t crc;         // crc32 checksum
        char *name;           // filename for the script // FIXME: This information should be available from Lua
+       run_stats stats;
        script_info *next;
     } script_info;
 
     script_info *load_script(lua_State *L, char *filename);
 
+#if AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+    static constexpr uint8_t CACHE_KEY_LEN = 32;
+    static constexpr uint8_t CACHE_MAC_LEN = 16;
+
+    // header of a compiled script in the cache
+    struct PACKED cache_header {
+        uint32_t magic;
+        uint32_t source_crc;    // crc32 of the script it was compiled from
+        uint32_t chunk_length;
+        uint8_t mac[CACHE_MAC_LEN]; // keyed blake2b of the script's path, magic, source_crc and the chunk that follows
+    };
+
+    // the name of a script's file in the cache
+    static void cache_filename(char *buf, uint8_t buflen, const char *filename, const char *ext);
+
+    // load the key cached chunks are signed with, creating it if needed
+    bool load_cache_key();
+
+    // load a script from the cache, returning false if there is no
+    // valid compiled chunk for this version of the script
+    bool load_cached_script(lua_State *L, const char *filename, uint32_t source_crc);
+
+    // save the script compiled at the top of the stack to the cache
+    void save_cached_script(lua_State *L, const char *filename, uint32_t source_crc);
+
+    // remove cached chunks of scripts which are no longer loaded
+    void remove_stale_cache_entries();
+
+    uint8_t cache_key[CACHE_KEY_LEN];
+    bool cache_enabled;         // SCR_DEBUG_OPTS enables the cache and we have its key
+#endif
+
+    // cost of loading the scripts, for runtime_info()
+    struct {
+        uint32_t time_us;
+        uint32_t heap_peak;     // most Lua heap in use while loading
+        uint16_t scripts;
+        uint16_t cached;        // number loaded from the cache
+    } load_stats;
+
     void reset_loop_overtime(lua_State *L);
 
     void load_all_scripts_in_dir(lua_State *L, const char *dirname);
@@ -75,6 +135,17 @@ private:
     void reschedule_script(script_info *script);
 
     script_info *scripts; // linked list of scripts to be run, sorted by next run time (soonest first)
+    script_info *running; // script being run, which is not in the list
+
+    // protects the list for runtime_info(), which is called from
+    // other threads
+    HAL_Semaphore list_sem;
+
+    // record a run of a script in its statistics
+    void record_run(script_info *script, uint32_t run_us, int32_t run_mem);
+
+    // return the value below which pct percent of a histogram lies
+    static uint32_t hist_percentile(const uint16_t *hist, uint8_t pct);
 
     // hook will be run when CPU time for a script is exceeded
     // it must be static to be passed to the C API
@@ -88,6 +159,7 @@ private:
 
     const AP_Int32 & _vm_steps;
     AP_Int8 & _debug_options;
+    const AP_Int8 & _cpu_budget;
 
     bool option_is_set(AP_Scripting::DebugOption option) const {
         return (uint8_t(_debug_options.get()) & uint8_t(option)) != 0;
@@ -97,6 +169,10 @@ private:
 
     static MultiHeap _heap;
 
+    // memory allocated through alloc()
+    static size_t heap_used;
+    static size_t heap_peak;
+
     // helper for print and log of runtime stats
     void update_stats(const char *name, uint32_t run_time, int total_mem, int run_mem);
 
@@ -58,7 +58,7 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
     // @Param: OPTIONS
     // @DisplayName: Terrain options
     // @Description: Options to change behaviour of terrain system
-    // @Bitmask: 0:Disable Download
+    // @Bitmask: 0:Disable Download, 1:Preload whole terrain files under home and the mission into memory (Linux and SITL only)
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",   2, AP_Terrain, options, 0),
 
@@ -80,11 +80,22 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
 
     // @Param: CACHE_SZ
     // @DisplayName: Terrain cache size
-    // @Description: The number of 32x28 cache blocks to keep in memory. Each block uses about 1800 bytes of memory
-    // @Range: 0 128
+    // @Description: The number of 32x28 cache blocks to keep in memory. Each block uses about 1800 bytes of memory. Values above 128 are only useful on boards with a lot of memory
+    // @Range: 0 1024
     // @User: Advanced
+    // @RebootRequired: True
     AP_GROUPINFO("CACHE_SZ",  5, AP_Terrain, config_cache_size, TERRAIN_GRID_BLOCK_CACHE_SIZE),
 
+#if AP_TERRAIN_PREFETCH_ENABLED
+    // @Param: PF_TIME
+    // @DisplayName: Terrain prefetch time
+    // @Description: How far ahead of the vehicle, in seconds of travel at the current ground speed, terrain blocks are loaded from storage into the cache. Prefetching never evicts blocks that have been used in the last 10 seconds, so a larger TERR_CACHE_SZ allows a longer prefetch. A value of zero disables prefetching
+    // @Units: s
+    // @Range: 0 120
+    // @User: Advanced
+    AP_GROUPINFO("PF_TIME",  6, AP_Terrain, prefetch_time, 30),
+#endif
+
     AP_GROUPEND
 };
 
@@ -135,8 +146,34 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height, bool corrected)
     calculate_grid_info(loc, info);
 
     // find the grid
-    const struct grid_block &grid = find_grid_cache(info).grid;
+    const struct grid_cache &gcache = find_grid_cache(info);
+    if (gcache.state == GRID_CACHE_DISKWAIT) {
+        cache_stats.diskwait++;
+    }
+    if (!grid_height(gcache.grid, info, height)) {
+        return false;
+    }
+
+    if (loc.lat == ahrs.get_home().lat &&
+        loc.lng == ahrs.get_home().lng) {
+        // remember home altitude as a special case
+        home_height = height;
+        home_loc = loc;
+        have_home_height = true;
+    }
+
+    if (corrected && have_reference_offset) {
+        height += reference_offset;
+    }
+    
+    return true;
+}
 
+/*
+  interpolate the height at a grid_info from its grid block
+ */
+bool AP_Terrain::grid_height(const struct grid_block &grid, const struct grid_info &info, float &height)
+{
     /*
       note that we rely on the one square overlap to ensure these
       calculations don't go past the end of the arrays
@@ -164,25 +201,139 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height, bool corrected)
     // grid_spacing is kept small enough
     const float avg1 = (1.0f-info.frac_x) * h00  + info.frac_x * h10;
     const float avg2 = (1.0f-info.frac_x) * h01  + info.frac_x * h11;
-    const float avg  = (1.0f-info.frac_y) * avg1 + info.frac_y * avg2;
+    height = (1.0f-info.frac_y) * avg1 + info.frac_y * avg2;
 
-    height = avg;
+    return true;
+}
 
-    if (loc.lat == ahrs.get_home().lat &&
-        loc.lng == ahrs.get_home().lng) {
-        // remember home altitude as a special case
-        home_height = height;
-        home_loc = loc;
-        have_home_height = true;
+/*
+  find the height of one location of a batch query. The grid block
+  of the previous location is reused if this location is in the same
+  block, saving the corner calculation and the cache search
+ */
+bool AP_Terrain::batch_height(const Location &loc, struct batch_state &state, float &height, BatchResult &result)
+{
+    struct grid_info info;
+    calculate_grid_index(loc, info);
+
+    if (state.gcache != nullptr &&
+        info.lat_degrees == state.info.lat_degrees &&
+        info.lon_degrees == state.info.lon_degrees &&
+        info.grid_idx_x == state.info.grid_idx_x &&
+        info.grid_idx_y == state.info.grid_idx_y) {
+        info.grid_lat = state.info.grid_lat;
+        info.grid_lon = state.info.grid_lon;
+    } else {
+        calculate_grid_corner(info);
+        state.gcache = &find_grid_cache(info);
+        state.block_missing = false;
+        if (state.gcache->state == GRID_CACHE_DISKWAIT) {
+            cache_stats.diskwait++;
+        }
     }
+    state.info = info;
 
-    if (corrected && have_reference_offset) {
+    if (!grid_height(state.gcache->grid, info, height)) {
+        if (!state.block_missing) {
+            state.block_missing = true;
+            add_missing_block(state, result);
+        }
+        return false;
+    }
+
+    if (state.corrected && have_reference_offset) {
         height += reference_offset;
     }
-    
+    result.num_valid++;
     return true;
 }
 
+/*
+  record the grid block of the last batch location as lacking data
+ */
+void AP_Terrain::add_missing_block(struct batch_state &state, BatchResult &result) const
+{
+    if (state.missing != nullptr) {
+        const uint16_t n = MIN(result.num_missing, state.max_missing);
+        for (uint16_t i=0; i<n; i++) {
+            if (state.missing[i].lat == state.info.grid_lat &&
+                state.missing[i].lng == state.info.grid_lon) {
+                // already listed
+                return;
+            }
+        }
+        if (n < state.max_missing) {
+            state.missing[n].zero();
+            state.missing[n].lat = state.info.grid_lat;
+            state.missing[n].lng = state.info.grid_lon;
+        }
+    }
+    result.num_missing++;
+}
+
+/*
+  find terrain heights for an array of locations
+ */
+AP_Terrain::BatchResult AP_Terrain::height_amsl_batch(const Location *locs, uint16_t count,
+                                                      float *heights, bool *valid,
+                                                      Location *missing, uint16_t max_missing,
+                                                      bool corrected)
+{
+    BatchResult result {};
+    if (!allocate()) {
+        return result;
+    }
+    struct batch_state state {};
+    state.missing = missing;
+    state.max_missing = max_missing;
+    state.corrected = corrected;
+
+    for (uint16_t i=0; i<count; i++) {
+        valid[i] = batch_height(locs[i], state, heights[i], result);
+    }
+    result.num_samples = count;
+    return result;
+}
+
+/*
+  find terrain heights at intervals along a path
+ */
+AP_Terrain::BatchResult AP_Terrain::height_amsl_path(const Location *path, uint16_t npoints, float interval,
+                                                     float *heights, bool *valid, uint16_t max_samples,
+                                                     Location *missing, uint16_t max_missing,
+                                                     bool corrected)
+{
+    BatchResult result {};
+    if (!allocate() || npoints == 0 || max_samples == 0 || !is_positive(interval)) {
+        return result;
+    }
+    struct batch_state state {};
+    state.missing = missing;
+    state.max_missing = max_missing;
+    state.corrected = corrected;
+
+    uint16_t n = 0;
+    valid[n] = batch_height(path[0], state, heights[n], result);
+    n++;
+    for (uint16_t i=1; i<npoints && n<max_samples; i++) {
+        // equal steps along the leg, ending on the next location
+        const Vector2f leg = path[i-1].get_distance_NE(path[i]);
+        const uint32_t steps = MAX(uint32_t(ceilf(leg.length() / interval)), 1U);
+        for (uint32_t s=1; s<=steps && n<max_samples; s++) {
+            Location loc = path[i-1];
+            if (s == steps) {
+                loc = path[i];
+            } else {
+                loc.offset(leg.x * s / steps, leg.y * s / steps);
+            }
+            valid[n] = batch_height(loc, state, heights[n], result);
+            n++;
+        }
+    }
+    result.num_samples = n;
+    return result;
+}
+
 
 /* 
    find difference between home terrain height and the terrain
@@ -369,6 +520,11 @@ void AP_Terrain::update(void)
     // try to ensure the home location is populated
     float height;
     height_amsl(ahrs.get_home(), height);
+#if AP_TERRAIN_MMAP_ENABLED
+    if (ahrs.home_is_set()) {
+        queue_preload(ahrs.get_home());
+    }
+#endif
 
     // update the cached current location height
     Location loc;
@@ -396,6 +552,11 @@ void AP_Terrain::update(void)
 
     // update capabilities and status
     if (allocate()) {
+#if AP_TERRAIN_PREFETCH_ENABLED
+        if (pos_valid) {
+            prefetch_grids(loc);
+        }
+#endif
         if (!pos_valid) {
             // we don't know where we are
             system_status = TerrainStatusUnhealthy;
@@ -428,6 +589,38 @@ bool AP_Terrain::update_surrounding_tiles(const Location &loc)
     return ret;
 }
 
+#if AP_TERRAIN_PREFETCH_ENABLED
+/*
+  load grids along the ground velocity vector, so that a fast moving
+  vehicle finds them in the cache rather than waiting for the disk
+ */
+void AP_Terrain::prefetch_grids(const Location &loc)
+{
+    const uint32_t now_ms = AP_HAL::millis();
+    if (!is_positive(prefetch_time) || grid_spacing <= 0 ||
+        now_ms - last_prefetch_ms < 1000) {
+        return;
+    }
+    last_prefetch_ms = now_ms;
+
+    const Vector2f vel = AP::ahrs().groundspeed_vector();
+    const float speed = vel.length();
+    if (speed < 1) {
+        return;
+    }
+    const Vector2f dir = vel / speed;
+
+    // step half a grid block at a time, using at most half the cache
+    const float step = 0.5 * MIN(TERRAIN_GRID_BLOCK_SPACING_X, TERRAIN_GRID_BLOCK_SPACING_Y) * grid_spacing;
+    const uint16_t steps = MIN(speed * prefetch_time / step, float(cache_size/2));
+    for (uint16_t i=1; i<=steps; i++) {
+        Location loc2 = loc;
+        loc2.offset(dir.x * step * i, dir.y * step * i);
+        prefetch_grid(loc2);
+    }
+}
+#endif
+
 bool AP_Terrain::pre_arm_checks(char *failure_msg, uint8_t failure_msg_len) const
 {
     // check no outstanding requests for data:
@@ -478,6 +671,20 @@ void AP_Terrain::log_terrain_data()
         reference_offset : have_reference_offset?reference_offset:0,
     };
     AP::logger().WriteBlock(&pkt, sizeof(pkt));
+
+    const struct log_TERRAIN_CACHE cpkt {
+        LOG_PACKET_HEADER_INIT(LOG_TERRAIN_CACHE_MSG),
+        time_us     : pkt.time_us,
+        cache_size  : cache_size,
+        hits        : cache_stats.hits,
+        misses      : cache_stats.misses,
+        diskwait    : cache_stats.diskwait,
+        prefetches  : cache_stats.prefetches,
+        disk_reads  : cache_stats.disk_reads,
+        disk_writes : cache_stats.disk_writes,
+        map_reads   : cache_stats.map_reads,
+    };
+    AP::logger().WriteBlock(&cpkt, sizeof(cpkt));
 }
 #endif
 
@@ -493,8 +700,16 @@ bool AP_Terrain::allocate(void)
     if (cache != nullptr) {
         return true;
     }
+    disk_blocks = (union grid_io_block *)calloc(AP_TERRAIN_IO_BATCH_SIZE, sizeof(disk_blocks[0]));
+    if (disk_blocks == nullptr) {
+        GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Terrain: Allocation failed");
+        memory_alloc_failed = true;
+        return false;
+    }
     cache = (struct grid_cache *)calloc(config_cache_size, sizeof(cache[0]));
     if (cache == nullptr) {
+        free(disk_blocks);
+        disk_blocks = nullptr;
         GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Terrain: Allocation failed");
         memory_alloc_failed = true;
         return false;
@@ -23,6 +23,7 @@
 #include <AP_Param/AP_Param.h>
 #include <GCS_MAVLink/GCS_MAVLink.h>
 #include <AP_Logger/AP_Logger_config.h>
+#include <AP_HAL/Semaphores.h>
 
 #define TERRAIN_DEBUG 0
 
@@ -47,8 +48,12 @@
 
 // number of grid_blocks in the LRU memory cache
 #ifndef TERRAIN_GRID_BLOCK_CACHE_SIZE
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#define TERRAIN_GRID_BLOCK_CACHE_SIZE 64
+#else
 #define TERRAIN_GRID_BLOCK_CACHE_SIZE 12
 #endif
+#endif
 
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
@@ -125,6 +130,46 @@ public:
      */
     bool height_amsl(const Location &loc, float &height, bool corrected = true);
 
+    /*
+      result of a batched terrain query
+     */
+    struct BatchResult {
+        // number of heights stored
+        uint16_t num_samples;
+        // number of those heights that are valid
+        uint16_t num_valid;
+        // number of grid blocks lacking data. These have been
+        // requested from storage and the GCS, so repeating the query
+        // later will find more heights
+        uint16_t num_missing;
+    };
+
+    /*
+      find the terrain heights in meters above sea level for count
+      locations in one pass. valid[i] is set true if heights[i] was
+      found. Neighbouring locations in the same grid block share the
+      block lookup, so locations should be ordered along the route.
+
+      If missing is not nullptr, the south-west corners of up to
+      max_missing distinct grid blocks lacking data are stored
+      there. Otherwise a block is counted once for each run of
+      consecutive locations in it
+     */
+    BatchResult height_amsl_batch(const Location *locs, uint16_t count,
+                                  float *heights, bool *valid,
+                                  Location *missing = nullptr, uint16_t max_missing = 0,
+                                  bool corrected = true);
+
+    /*
+      as height_amsl_batch(), for samples at most interval meters
+      apart along the path through npoints locations, including each
+      location. Up to max_samples heights are stored
+     */
+    BatchResult height_amsl_path(const Location *path, uint16_t npoints, float interval,
+                                 float *heights, bool *valid, uint16_t max_samples,
+                                 Location *missing = nullptr, uint16_t max_missing = 0,
+                                 bool corrected = true);
+
     /* 
        find difference between home terrain height and the terrain
        height at the current location in meters. A positive result
@@ -301,11 +346,55 @@ private:
     // given a location, fill a grid_info structure
     void calculate_grid_info(const Location &loc, struct grid_info &info) const;
 
+    // the two parts of calculate_grid_info(): the degree and grid
+    // indices, then the south-west corner of the grid block
+    void calculate_grid_index(const Location &loc, struct grid_info &info) const;
+    void calculate_grid_corner(struct grid_info &info) const;
+
+    // interpolate the height at info from its grid block, returning
+    // false if any of the four surrounding heights are missing
+    bool grid_height(const struct grid_block &grid, const struct grid_info &info, float &height);
+
+    /*
+      state carried between the locations of a batch query
+     */
+    struct batch_state {
+        struct grid_info info;
+        struct grid_cache *gcache;
+        bool block_missing;
+        Location *missing;
+        uint16_t max_missing;
+        bool corrected;
+    };
+    bool batch_height(const Location &loc, struct batch_state &state, float &height, BatchResult &result);
+    void add_missing_block(struct batch_state &state, BatchResult &result) const;
+
     /*
       find a grid structure given a grid_info
     */
     struct grid_cache &find_grid_cache(const struct grid_info &info);
 
+    /*
+      look for a grid in the cache, returning nullptr if not
+      present. oldest_i is set to the least recently used entry. If
+      touch is true a found grid is marked as used
+    */
+    struct grid_cache *lookup_grid_cache(const struct grid_info &info, uint16_t &oldest_i, bool touch);
+
+    /*
+      reuse cache entry idx for the grid in info, waiting for disk read
+    */
+    struct grid_cache &claim_grid_cache(uint16_t idx, const struct grid_info &info);
+
+#if AP_TERRAIN_PREFETCH_ENABLED
+    /*
+      start loading grids ahead of the vehicle along its velocity
+      vector, without evicting grids that are in use
+    */
+    void prefetch_grids(const Location &loc);
+    void prefetch_grid(const Location &loc);
+#endif
+
     /*
       calculate bit number in grid_block bitmap. This corresponds to a
       bit representing a 4x4 mavlink transmitted block
@@ -339,16 +428,42 @@ private:
     /*
       disk IO functions
      */
-    int16_t find_io_idx(enum GridCacheState state);
+    int16_t find_io_idx(const struct grid_block &block, enum GridCacheState state);
     uint16_t get_block_crc(struct grid_block &block);
     void check_disk_read(void);
     void check_disk_write(void);
     void io_timer(void);
-    void open_file(void);
-    void seek_offset(void);
-    uint32_t east_blocks(struct grid_block &block) const;
-    void write_block(void);
-    void read_block(void);
+    void open_file(const struct grid_block &block);
+    void seek_offset(const struct grid_block &block);
+    uint32_t block_offset(const struct grid_block &block) const;
+    bool check_block(struct grid_block &block, int32_t lat, int32_t lon);
+    uint32_t east_blocks(const struct grid_block &block) const;
+    void write_block(union grid_io_block &io_block);
+    void read_block(union grid_io_block &io_block);
+
+#if AP_TERRAIN_MMAP_ENABLED
+    /*
+      map the open degree file into memory, from the IO thread
+     */
+    void update_file_map(void);
+
+    /*
+      fill a newly claimed cache entry from the mapped file, from the
+      main thread. Returns false if the block needs a disk read
+     */
+    bool load_mapped_block(struct grid_cache &gcache);
+
+    /*
+      queue the degree file holding loc to be mapped in full, from the
+      main thread
+     */
+    void queue_preload(const Location &loc);
+
+    /*
+      map the next queued degree file, from the IO thread
+     */
+    void preload_next_file(void);
+#endif
 
     // check for missing data in squares surrounding loc:
     bool update_surrounding_tiles(const Location &loc);
@@ -376,13 +491,17 @@ private:
     AP_Int16 options; // option bits
     AP_Float offset_max;
     AP_Int16 config_cache_size;
+#if AP_TERRAIN_PREFETCH_ENABLED
+    AP_Float prefetch_time;
+#endif
 
     enum class Options {
         DisableDownload = (1U<<0),
+        PreloadFiles = (1U<<1),
     };
 
     // cache of grids in memory, LRU
-    uint8_t cache_size = 0;
+    uint16_t cache_size = 0;
     struct grid_cache *cache = nullptr;
 
     // a grid_cache block waiting for disk IO
@@ -394,7 +513,51 @@ private:
         DiskIoDoneWrite = 4
     };
     volatile enum DiskIoState disk_io_state;
-    union grid_io_block disk_block;
+
+    // blocks being read or written by the IO thread, allocated with
+    // the cache
+    union grid_io_block *disk_blocks;
+    uint8_t disk_io_count;
+    // next block of the batch for the IO thread
+    uint8_t disk_io_next;
+
+    // cache statistics, for logging
+    struct {
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t diskwait;
+        uint32_t prefetches;
+        uint32_t disk_reads;
+        uint32_t disk_writes;
+        uint32_t map_reads;
+    } cache_stats;
+
+#if AP_TERRAIN_MMAP_ENABLED
+    // degree files mapped into memory. The IO thread maps and unmaps
+    // files while holding map_sem, the main thread reads them
+    struct mapped_file {
+        const uint8_t *data;
+        uint32_t length;
+        uint32_t last_use_ms;
+        int16_t lon_degrees;
+        int8_t lat_degrees;
+    } mapped_files[AP_TERRAIN_MMAP_FILES];
+    HAL_Semaphore map_sem;
+
+    // degree files under home and the mission to map in full when
+    // TERR_OPTIONS asks for preloading. The main thread queues them
+    // and the IO thread maps them, both holding map_sem
+    struct {
+        int16_t lon_degrees;
+        int8_t lat_degrees;
+    } preload_files[AP_TERRAIN_MMAP_FILES];
+    uint8_t preload_count;      // files waiting to be mapped
+    uint8_t preload_total;      // files ever queued, at most one per mapping
+#endif
+
+#if AP_TERRAIN_PREFETCH_ENABLED
+    uint32_t last_prefetch_ms;
+#endif
 
 #if HAL_GCS_ENABLED
     // last time we asked for more grids
@@ -447,9 +610,6 @@ private:
     // next mission command to check
     uint16_t next_mission_index;
 
-    // next mission position to check
-    uint8_t next_mission_pos;
-
     // last time the mission changed
     uint32_t last_mission_change_ms;
 
@@ -6,3 +6,38 @@
 #ifndef AP_TERRAIN_AVAILABLE
 #define AP_TERRAIN_AVAILABLE AP_FILESYSTEM_FILE_READING_ENABLED
 #endif
+
+// number of grid blocks read or written by the IO thread in one pass
+#ifndef AP_TERRAIN_IO_BATCH_SIZE
+#if BOARD_FLASH_SIZE > 1024
+#define AP_TERRAIN_IO_BATCH_SIZE 4
+#else
+#define AP_TERRAIN_IO_BATCH_SIZE 1
+#endif
+#endif
+
+// load grid blocks ahead of the vehicle along its velocity vector
+#ifndef AP_TERRAIN_PREFETCH_ENABLED
+#define AP_TERRAIN_PREFETCH_ENABLED (BOARD_FLASH_SIZE > 1024)
+#endif
+
+// read grid blocks straight from memory mapped terrain files. This
+// relies on the local filesystem being posix
+#ifndef AP_TERRAIN_MMAP_ENABLED
+#define AP_TERRAIN_MMAP_ENABLED (AP_FILESYSTEM_POSIX_ENABLED && (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX))
+#endif
+
+// number of mission points checked for terrain data per update. With
+// mapped files most lookups need no disk IO
+#ifndef AP_TERRAIN_MISSION_CHECKS
+#if AP_TERRAIN_MMAP_ENABLED
+#define AP_TERRAIN_MISSION_CHECKS 200
+#else
+#define AP_TERRAIN_MISSION_CHECKS 20
+#endif
+#endif
+
+// number of degree files kept mapped at once
+#ifndef AP_TERRAIN_MMAP_FILES
+#define AP_TERRAIN_MMAP_FILES 4
+#endif
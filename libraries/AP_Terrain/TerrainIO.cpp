@@ -25,21 +25,28 @@
 #include <AP_Common/AP_Common.h>
 #include <AP_Math/AP_Math.h>
 #include <stdio.h>
+#if AP_TERRAIN_MMAP_ENABLED
+#include <sys/mman.h>
+#endif
 
 extern const AP_HAL::HAL& hal;
 
 /*
-  check for blocks that need to be read from disk
+  check for blocks that need to be read from disk. Up to
+  AP_TERRAIN_IO_BATCH_SIZE blocks are read in one pass of the IO thread
  */
 void AP_Terrain::check_disk_read(void)
 {
-    for (uint16_t i=0; i<cache_size; i++) {
+    disk_io_count = 0;
+    disk_io_next = 0;
+    for (uint16_t i=0; i<cache_size && disk_io_count<AP_TERRAIN_IO_BATCH_SIZE; i++) {
         if (cache[i].state == GRID_CACHE_DISKWAIT) {
-            disk_block.block = cache[i].grid;
-            disk_io_state = DiskIoWaitRead;
-            return;
+            disk_blocks[disk_io_count++].block = cache[i].grid;
         }
-    }    
+    }
+    if (disk_io_count > 0) {
+        disk_io_state = DiskIoWaitRead;
+    }
 }
 
 /*
@@ -47,13 +54,16 @@ void AP_Terrain::check_disk_read(void)
  */
 void AP_Terrain::check_disk_write(void)
 {
-    for (uint16_t i=0; i<cache_size; i++) {
+    disk_io_count = 0;
+    disk_io_next = 0;
+    for (uint16_t i=0; i<cache_size && disk_io_count<AP_TERRAIN_IO_BATCH_SIZE; i++) {
         if (cache[i].state == GRID_CACHE_DIRTY) {
-            disk_block.block = cache[i].grid;
-            disk_io_state = DiskIoWaitWrite;
-            return;
+            disk_blocks[disk_io_count++].block = cache[i].grid;
         }
-    }    
+    }
+    if (disk_io_count > 0) {
+        disk_io_state = DiskIoWaitWrite;
+    }
 }
 
 /*
@@ -80,33 +90,39 @@ void AP_Terrain::schedule_disk_io(void)
         }
         break;
         
-    case DiskIoDoneRead: {
-        // a read has completed
-        int16_t cache_idx = find_io_idx(GRID_CACHE_DISKWAIT);
-        if (cache_idx != -1) {
-            if (disk_block.block.bitmap != 0) {
-                // when bitmap is zero we read an empty block
-                cache[cache_idx].grid = disk_block.block;
+    case DiskIoDoneRead:
+        // a batch of reads has completed
+        for (uint8_t i=0; i<disk_io_count; i++) {
+            const struct grid_block &block = disk_blocks[i].block;
+            int16_t cache_idx = find_io_idx(block, GRID_CACHE_DISKWAIT);
+            if (cache_idx != -1) {
+                if (block.bitmap != 0) {
+                    // when bitmap is zero we read an empty block
+                    cache[cache_idx].grid = block;
+                }
+                cache[cache_idx].state = GRID_CACHE_VALID;
+                cache[cache_idx].last_access_ms = AP_HAL::millis();
             }
-            cache[cache_idx].state = GRID_CACHE_VALID;
-            cache[cache_idx].last_access_ms = AP_HAL::millis();
         }
+        cache_stats.disk_reads += disk_io_count;
         disk_io_state = DiskIoIdle;
         break;
-    }
 
-    case DiskIoDoneWrite: {
-        // a write has completed
-        int16_t cache_idx = find_io_idx(GRID_CACHE_DIRTY);
-        if (cache_idx != -1) {
-            if (cache[cache_idx].grid.bitmap == disk_block.block.bitmap) {
-                // only mark valid if more grids haven't been added
-                cache[cache_idx].state = GRID_CACHE_VALID;
+    case DiskIoDoneWrite:
+        // a batch of writes has completed
+        for (uint8_t i=0; i<disk_io_count; i++) {
+            const struct grid_block &block = disk_blocks[i].block;
+            int16_t cache_idx = find_io_idx(block, GRID_CACHE_DIRTY);
+            if (cache_idx != -1) {
+                if (cache[cache_idx].grid.bitmap == block.bitmap) {
+                    // only mark valid if more grids haven't been added
+                    cache[cache_idx].state = GRID_CACHE_VALID;
+                }
             }
         }
+        cache_stats.disk_writes += disk_io_count;
         disk_io_state = DiskIoIdle;
         break;
-    }
         
     case DiskIoWaitWrite:
     case DiskIoWaitRead:
@@ -131,11 +147,10 @@ All file operations are done by the IO thread.
 
 
 /*
-  open the current degree file
+  open the degree file for a block
  */
-void AP_Terrain::open_file(void)
+void AP_Terrain::open_file(const struct grid_block &block)
 {
-    struct grid_block &block = disk_block.block;
     if (fd != -1 && 
         block.lat_degrees == file_lat_degrees &&
         block.lon_degrees == file_lon_degrees) {
@@ -217,7 +232,7 @@ void AP_Terrain::open_file(void)
 /*
   work out how many blocks needed in a stride for a given location
  */
-uint32_t AP_Terrain::east_blocks(struct grid_block &block) const
+uint32_t AP_Terrain::east_blocks(const struct grid_block &block) const
 {
     Location loc1, loc2;
     loc1.lat = block.lat_degrees*10*1000*1000L;
@@ -232,14 +247,21 @@ uint32_t AP_Terrain::east_blocks(struct grid_block &block) const
 }
 
 /*
-  seek to the right offset for disk_block
+  file offset of a block in its degree file
  */
-void AP_Terrain::seek_offset(void)
+uint32_t AP_Terrain::block_offset(const struct grid_block &block) const
 {
-    struct grid_block &block = disk_block.block;
     // work out how many longitude blocks there are at this latitude
     uint32_t blocknum = east_blocks(block) * block.grid_idx_x + block.grid_idx_y;
-    uint32_t file_offset = blocknum * sizeof(union grid_io_block);
+    return blocknum * sizeof(union grid_io_block);
+}
+
+/*
+  seek to the right offset for a block
+ */
+void AP_Terrain::seek_offset(const struct grid_block &block)
+{
+    uint32_t file_offset = block_offset(block);
     if (AP::FS().lseek(fd, file_offset, SEEK_SET) != (off_t)file_offset) {
 #if TERRAIN_DEBUG
         hal.console->printf("Seek %lu failed - %s\n",
@@ -252,11 +274,11 @@ void AP_Terrain::seek_offset(void)
 }
 
 /*
-  write out disk_block
+  write out a block
  */
-void AP_Terrain::write_block(void)
+void AP_Terrain::write_block(union grid_io_block &disk_block)
 {
-    seek_offset();
+    seek_offset(disk_block.block);
     if (io_failure) {
         return;
     }
@@ -281,15 +303,27 @@ void AP_Terrain::write_block(void)
                (unsigned long long)disk_block.block.bitmap);
 #endif
     }
-    disk_io_state = DiskIoDoneWrite;
 }
 
 /*
-  read in disk_block
+  check a block from disk is the one we asked for and is intact
+ */
+bool AP_Terrain::check_block(struct grid_block &block, int32_t lat, int32_t lon)
+{
+    return TERRAIN_LATLON_EQUAL(block.lat,lat) &&
+        TERRAIN_LATLON_EQUAL(block.lon,lon) &&
+        block.bitmap != 0 &&
+        block.spacing == grid_spacing &&
+        block.version == TERRAIN_GRID_FORMAT_VERSION &&
+        block.crc == get_block_crc(block);
+}
+
+/*
+  read in a block
  */
-void AP_Terrain::read_block(void)
+void AP_Terrain::read_block(union grid_io_block &disk_block)
 {
-    seek_offset();
+    seek_offset(disk_block.block);
     if (io_failure) {
         return;
     }
@@ -298,12 +332,7 @@ void AP_Terrain::read_block(void)
 
     ssize_t ret = AP::FS().read(fd, &disk_block, sizeof(disk_block));
     if (ret != sizeof(disk_block) || 
-        !TERRAIN_LATLON_EQUAL(disk_block.block.lat,lat) ||
-        !TERRAIN_LATLON_EQUAL(disk_block.block.lon,lon) ||
-        disk_block.block.bitmap == 0 ||
-        disk_block.block.spacing != grid_spacing ||
-        disk_block.block.version != TERRAIN_GRID_FORMAT_VERSION ||
-        disk_block.block.crc != get_block_crc(disk_block.block)) {
+        !check_block(disk_block.block, lat, lon)) {
 #if TERRAIN_DEBUG
         printf("read empty block at %ld %ld ret=%d (%ld %ld %u 0x%08lx) 0x%04x:0x%04x\n",
                (long)lat,
@@ -331,7 +360,6 @@ void AP_Terrain::read_block(void)
                (unsigned long long)disk_block.block.bitmap);
 #endif
     }
-    disk_io_state = DiskIoDoneRead;
 }
 
 /*
@@ -355,27 +383,216 @@ void AP_Terrain::io_timer(void)
     case DiskIoIdle:
     case DiskIoDoneRead:
     case DiskIoDoneWrite:
-        // nothing to do
+#if AP_TERRAIN_MMAP_ENABLED
+        // use idle time to load files we expect to need
+        preload_next_file();
+#endif
         break;
         
     case DiskIoWaitWrite:
-        // need to write out the block
-        open_file();
-        if (fd == -1) {
-            return;
+        // need to write out the blocks. After a failure we carry on
+        // from the block that failed
+        while (disk_io_next < disk_io_count) {
+            union grid_io_block &disk_block = disk_blocks[disk_io_next];
+            open_file(disk_block.block);
+            if (fd == -1) {
+                return;
+            }
+            write_block(disk_block);
+            if (io_failure) {
+                return;
+            }
+#if AP_TERRAIN_MMAP_ENABLED
+            // the file may have grown
+            update_file_map();
+#endif
+            disk_io_next++;
         }
-        write_block();
+        disk_io_state = DiskIoDoneWrite;
         break;
 
     case DiskIoWaitRead:
-        // need to read in the block
-        open_file();
-        if (fd == -1) {
-            return;
+        // need to read in the blocks
+        while (disk_io_next < disk_io_count) {
+            union grid_io_block &disk_block = disk_blocks[disk_io_next];
+            open_file(disk_block.block);
+            if (fd == -1) {
+                return;
+            }
+#if AP_TERRAIN_MMAP_ENABLED
+            update_file_map();
+#endif
+            read_block(disk_block);
+            if (io_failure) {
+                return;
+            }
+            disk_io_next++;
         }
-        read_block();
+        disk_io_state = DiskIoDoneRead;
         break;
     }
 }
 
+#if AP_TERRAIN_MMAP_ENABLED
+/*
+  map the open degree file so that the main thread can take blocks
+  straight from memory. Files are mapped read only; blocks are still
+  written with write(), and as the mapping is shared those writes are
+  seen through it. A file that has grown is mapped again. This runs
+  in the IO thread.
+
+  The local filesystem on these boards is posix, so fd is a system
+  file descriptor.
+ */
+void AP_Terrain::update_file_map(void)
+{
+    if (fd == -1) {
+        return;
+    }
+    const off_t length = AP::FS().lseek(fd, 0, SEEK_END);
+    if (length < (off_t)sizeof(union grid_io_block) || length > INT32_MAX) {
+        return;
+    }
+
+    // find the existing mapping of this file, or else the least
+    // recently used slot
+    struct mapped_file *mf = nullptr;
+    for (auto &m : mapped_files) {
+        if (m.data != nullptr &&
+            m.lat_degrees == file_lat_degrees &&
+            m.lon_degrees == file_lon_degrees) {
+            if (m.length >= (uint32_t)length) {
+                // already mapped
+                return;
+            }
+            mf = &m;
+            break;
+        }
+        if (mf == nullptr || m.data == nullptr ||
+            (mf->data != nullptr && m.last_use_ms < mf->last_use_ms)) {
+            mf = &m;
+        }
+    }
+
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    if (options.get() & uint16_t(Options::PreloadFiles)) {
+        // read the whole file in now rather than on first access
+        flags |= MAP_POPULATE;
+    }
+#endif
+    void *data = mmap(nullptr, length, PROT_READ, flags, fd, 0);
+    if (data == MAP_FAILED) {
+        return;
+    }
+
+    WITH_SEMAPHORE(map_sem);
+    if (mf->data != nullptr) {
+        munmap(const_cast<uint8_t *>(mf->data), mf->length);
+    }
+    mf->data = (const uint8_t *)data;
+    mf->length = length;
+    mf->lat_degrees = file_lat_degrees;
+    mf->lon_degrees = file_lon_degrees;
+    mf->last_use_ms = AP_HAL::millis();
+}
+
+/*
+  fill a newly claimed cache entry from a mapped file. Blocks that
+  are not in the mapping, perhaps because they were written after the
+  file was mapped, are left to the IO thread. This runs in the main
+  thread.
+ */
+bool AP_Terrain::load_mapped_block(struct grid_cache &gcache)
+{
+    WITH_SEMAPHORE(map_sem);
+
+    for (auto &m : mapped_files) {
+        if (m.data == nullptr ||
+            m.lat_degrees != gcache.grid.lat_degrees ||
+            m.lon_degrees != gcache.grid.lon_degrees) {
+            continue;
+        }
+        const uint32_t file_offset = block_offset(gcache.grid);
+        if (file_offset + sizeof(union grid_io_block) > m.length) {
+            return false;
+        }
+        m.last_use_ms = AP_HAL::millis();
+
+        struct grid_block block;
+        memcpy(&block, &m.data[file_offset], sizeof(block));
+        if (check_block(block, gcache.grid.lat, gcache.grid.lon)) {
+            gcache.grid = block;
+        } else if (block.bitmap != 0) {
+            // possibly a block being written by the IO thread; read it
+            // the slow way
+            return false;
+        }
+        // a block with an empty bitmap has never been written, so
+        // is treated like a short read
+        gcache.state = GRID_CACHE_VALID;
+        cache_stats.map_reads++;
+        return true;
+    }
+    return false;
+}
+
+/*
+  queue the degree file holding loc to be mapped in full. Only the
+  first AP_TERRAIN_MMAP_FILES files are queued, so preloading never
+  unmaps a file it loaded itself. This runs in the main thread.
+ */
+void AP_Terrain::queue_preload(const Location &loc)
+{
+    if (!(options.get() & uint16_t(Options::PreloadFiles)) ||
+        preload_total >= ARRAY_SIZE(preload_files)) {
+        return;
+    }
+    struct grid_info info;
+    calculate_grid_info(loc, info);
+
+    WITH_SEMAPHORE(map_sem);
+    for (const auto &m : mapped_files) {
+        if (m.data != nullptr &&
+            m.lat_degrees == info.lat_degrees &&
+            m.lon_degrees == info.lon_degrees) {
+            // already mapped
+            return;
+        }
+    }
+    for (uint8_t i=0; i<preload_count; i++) {
+        if (preload_files[i].lat_degrees == info.lat_degrees &&
+            preload_files[i].lon_degrees == info.lon_degrees) {
+            // already queued
+            return;
+        }
+    }
+    preload_files[preload_count].lat_degrees = info.lat_degrees;
+    preload_files[preload_count].lon_degrees = info.lon_degrees;
+    preload_count++;
+    preload_total++;
+}
+
+/*
+  map the next queued degree file, reading all of it into memory. This
+  runs in the IO thread when it has no blocks to read or write.
+ */
+void AP_Terrain::preload_next_file(void)
+{
+    struct grid_block block {};
+    {
+        WITH_SEMAPHORE(map_sem);
+        if (preload_count == 0) {
+            return;
+        }
+        block.lat_degrees = preload_files[0].lat_degrees;
+        block.lon_degrees = preload_files[0].lon_degrees;
+        preload_count--;
+        memmove(&preload_files[0], &preload_files[1], preload_count * sizeof(preload_files[0]));
+    }
+    open_file(block);
+    update_file_map();
+}
+#endif // AP_TERRAIN_MMAP_ENABLED
+
 #endif // AP_TERRAIN_AVAILABLE
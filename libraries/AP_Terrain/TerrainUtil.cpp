@@ -56,6 +56,15 @@ bool AP_Terrain::check_bitmap(const struct grid_block &grid, uint8_t idx_x, uint
   grid indices
 */
 void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info) const
+{
+    calculate_grid_index(loc, info);
+    calculate_grid_corner(info);
+}
+
+/*
+  given a location, calculate the grid indices
+*/
+void AP_Terrain::calculate_grid_index(const Location &loc, struct grid_info &info) const
 {
     // grids start on integer degrees. This makes storing terrain data
     // on the SD card a bit easier
@@ -88,42 +97,58 @@ void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info
     info.frac_x = (offset.x - idx_x * grid_spacing) / grid_spacing;
     info.frac_y = (offset.y - idx_y * grid_spacing) / grid_spacing;
 
-    // calculate lat/lon of SW corner of 32*28 grid_block
-    ref.offset(info.grid_idx_x * TERRAIN_GRID_BLOCK_SPACING_X * (float)grid_spacing,
-               info.grid_idx_y * TERRAIN_GRID_BLOCK_SPACING_Y * (float)grid_spacing);
-    info.grid_lat = ref.lat;
-    info.grid_lon = ref.lng;
-
     ASSERT_RANGE(info.idx_x,0,TERRAIN_GRID_BLOCK_SPACING_X-1);
     ASSERT_RANGE(info.idx_y,0,TERRAIN_GRID_BLOCK_SPACING_Y-1);
     ASSERT_RANGE(info.frac_x,0,1);
     ASSERT_RANGE(info.frac_y,0,1);
 }
 
+/*
+  calculate lat/lon of SW corner of 32*28 grid_block, given the
+  indices from calculate_grid_index()
+*/
+void AP_Terrain::calculate_grid_corner(struct grid_info &info) const
+{
+    Location ref;
+    ref.lat = info.lat_degrees*10*1000*1000L;
+    ref.lng = info.lon_degrees*10*1000*1000L;
+    ref.offset(info.grid_idx_x * TERRAIN_GRID_BLOCK_SPACING_X * (float)grid_spacing,
+               info.grid_idx_y * TERRAIN_GRID_BLOCK_SPACING_Y * (float)grid_spacing);
+    info.grid_lat = ref.lat;
+    info.grid_lon = ref.lng;
+}
+
 
 /*
-  find a grid structure given a grid_info
+  look for a grid in the cache
  */
-AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
+AP_Terrain::grid_cache *AP_Terrain::lookup_grid_cache(const struct grid_info &info, uint16_t &oldest_i, bool touch)
 {
-    uint16_t oldest_i = 0;
+    oldest_i = 0;
 
     // see if we have that grid
     for (uint16_t i=0; i<cache_size; i++) {
         if (TERRAIN_LATLON_EQUAL(cache[i].grid.lat,info.grid_lat) &&
             TERRAIN_LATLON_EQUAL(cache[i].grid.lon,info.grid_lon) &&
             cache[i].grid.spacing == grid_spacing) {
-            cache[i].last_access_ms = AP_HAL::millis();
-            return cache[i];
+            if (touch) {
+                cache[i].last_access_ms = AP_HAL::millis();
+            }
+            return &cache[i];
         }
         if (cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
             oldest_i = i;
         }
     }
+    return nullptr;
+}
 
-    // Not found. Use the oldest grid and make it this grid,
-    // initially unpopulated
-    struct grid_cache &grid = cache[oldest_i];
+/*
+  reuse a cache entry for a grid, initially unpopulated
+ */
+AP_Terrain::grid_cache &AP_Terrain::claim_grid_cache(uint16_t idx, const struct grid_info &info)
+{
+    struct grid_cache &grid = cache[idx];
     memset(&grid, 0, sizeof(grid));
 
     grid.grid.lat = info.grid_lat;
@@ -139,26 +164,78 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     // mark as waiting for disk read
     grid.state = GRID_CACHE_DISKWAIT;
 
+#if AP_TERRAIN_MMAP_ENABLED
+    // no need to wait if the file is mapped
+    load_mapped_block(grid);
+#endif
+
     return grid;
 }
 
 /*
-  find cache index of disk_block
+  find a grid structure given a grid_info
+ */
+AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
+{
+    uint16_t oldest_i;
+    struct grid_cache *grid = lookup_grid_cache(info, oldest_i, true);
+    if (grid != nullptr) {
+        cache_stats.hits++;
+        return *grid;
+    }
+
+    // Not found. Use the oldest grid and make it this grid
+    cache_stats.misses++;
+    return claim_grid_cache(oldest_i, info);
+}
+
+#if AP_TERRAIN_PREFETCH_ENABLED
+/*
+  start loading the grid for a location if it is not in the cache,
+  as long as that doesn't evict a grid that is still in use
+ */
+void AP_Terrain::prefetch_grid(const Location &loc)
+{
+    if (cache_size == 0) {
+        return;
+    }
+    struct grid_info info;
+    calculate_grid_info(loc, info);
+
+    uint16_t oldest_i;
+    if (lookup_grid_cache(info, oldest_i, false) != nullptr) {
+        // already loaded or loading
+        return;
+    }
+    const struct grid_cache &oldest = cache[oldest_i];
+    if (oldest.state == GRID_CACHE_DIRTY ||
+        (oldest.state != GRID_CACHE_INVALID &&
+         AP_HAL::millis() - oldest.last_access_ms < 10000)) {
+        // cache is full of grids we are using
+        return;
+    }
+    claim_grid_cache(oldest_i, info);
+    cache_stats.prefetches++;
+}
+#endif
+
+/*
+  find cache index of a block being read or written
  */
-int16_t AP_Terrain::find_io_idx(enum GridCacheState state)
+int16_t AP_Terrain::find_io_idx(const struct grid_block &block, enum GridCacheState state)
 {
     // try first with given state
     for (uint16_t i=0; i<cache_size; i++) {
-        if (TERRAIN_LATLON_EQUAL(disk_block.block.lat,cache[i].grid.lat) &&
-            TERRAIN_LATLON_EQUAL(disk_block.block.lon,cache[i].grid.lon) &&
+        if (TERRAIN_LATLON_EQUAL(block.lat,cache[i].grid.lat) &&
+            TERRAIN_LATLON_EQUAL(block.lon,cache[i].grid.lon) &&
             cache[i].state == state) {
             return i;
         }
     }    
     // then any state
     for (uint16_t i=0; i<cache_size; i++) {
-        if (TERRAIN_LATLON_EQUAL(disk_block.block.lat,cache[i].grid.lat) &&
-            TERRAIN_LATLON_EQUAL(disk_block.block.lon,cache[i].grid.lon)) {
+        if (TERRAIN_LATLON_EQUAL(block.lat,cache[i].grid.lat) &&
+            TERRAIN_LATLON_EQUAL(block.lon,cache[i].grid.lon)) {
             return i;
         }
     }    
@@ -154,6 +154,7 @@ const AP_Param::GroupInfo HarmonicNotchFilterParams::var_info[] = {
 template <class T>
 HarmonicNotchFilter<T>::~HarmonicNotchFilter() {
     delete[] _filters;
+    delete[] _last_center_freq_hz;
     _num_filters = 0;
     _num_enabled_filters = 0;
 }
@@ -198,6 +199,9 @@ void HarmonicNotchFilter<T>::init(float sample_freq_hz, HarmonicNotchFilterParam
     // calculate attenuation and quality from the shaping constraints
     NotchFilter<T>::calculate_A_and_Q(center_freq_hz, bandwidth_hz / _composite_notches, attenuation_dB, _A, _Q);
 
+    // A and Q may have changed so all notches need recalculating
+    invalidate_center_cache();
+
     _initialised = true;
 
     // ensure static notches are allocated and working
@@ -254,6 +258,7 @@ void HarmonicNotchFilter<T>::expand_filter_count(uint16_t total_notches)
     _filters = filters;
     _num_filters = total_notches;
     delete[] _old_filters;
+    invalidate_center_cache();
 }
 
 /*
@@ -264,7 +269,7 @@ void HarmonicNotchFilter<T>::expand_filter_count(uint16_t total_notches)
   frequency for this harmonic
  */
 template <class T>
-void HarmonicNotchFilter<T>::set_center_frequency(uint16_t idx, float notch_center, float spread_mul, uint8_t harmonic_mul)
+bool HarmonicNotchFilter<T>::set_center_frequency(uint16_t idx, float notch_center, float spread_mul, uint8_t harmonic_mul)
 {
     const float nyquist_limit = _sample_freq_hz * HARMONIC_NYQUIST_CUTOFF;
     auto &notch = _filters[idx];
@@ -281,7 +286,7 @@ void HarmonicNotchFilter<T>::set_center_frequency(uint16_t idx, float notch_cent
     */
     if (notch_center >= nyquist_limit) {
         notch.disable();
-        return;
+        return true;
     }
 
     // the minimum frequency for a harmonic is the base minimum
@@ -308,7 +313,7 @@ void HarmonicNotchFilter<T>::set_center_frequency(uint16_t idx, float notch_cent
         const float disable_freq = harmonic_min_freq * NOTCHFILTER_ATTENUATION_CUTOFF;
         if (notch_center < disable_freq) {
             notch.disable();
-            return;
+            return true;
         }
 
         if (notch_center < harmonic_min_freq) {
@@ -333,6 +338,10 @@ void HarmonicNotchFilter<T>::set_center_frequency(uint16_t idx, float notch_cent
     notch_center *= spread_mul;
 
     notch.init_with_A_and_Q(_sample_freq_hz, notch_center, A, _Q);
+
+    // the center frequency is slew limited, so a notch may need
+    // several updates to reach its target
+    return !notch.initialised || is_equal(notch._center_freq_hz, notch_center);
 }
 
 /*
@@ -365,6 +374,30 @@ void HarmonicNotchFilter<T>::update(uint8_t num_centers, const float center_freq
         expand_filter_count(total_notches);
     }
 
+    /*
+      coefficient calculation is the expensive part of an update, so
+      sources whose frequency is unchanged since the last update and
+      whose notches have all reached their target are skipped. This
+      makes updating at loop rate cheap when the sources are steady
+     */
+    if (num_centers != _num_last_centers) {
+        delete[] _last_center_freq_hz;
+        _last_center_freq_hz = nullptr;
+        _num_last_centers = 0;
+        if (num_centers <= 32) {
+            _last_center_freq_hz = NEW_NOTHROW float[num_centers];
+        }
+    }
+    // options can be changed at runtime without a call to init()
+    const bool treat_low_as_min = params->hasOption(HarmonicNotchFilterParams::Options::TreatLowAsMin);
+    if (treat_low_as_min != _last_treat_low_as_min) {
+        _last_treat_low_as_min = treat_low_as_min;
+        invalidate_center_cache();
+    }
+    const bool have_cache = _last_center_freq_hz != nullptr;
+    const bool use_cache = have_cache && _num_last_centers == num_centers;
+    uint32_t settled_centers = have_cache ? uint32_t((1ULL<<num_centers)-1) : 0;
+
     _num_enabled_filters = 0;
 
     // update all of the filters using the new center frequencies and existing A & Q
@@ -378,13 +411,49 @@ void HarmonicNotchFilter<T>::update(uint8_t num_centers, const float center_freq
         }
 
         const float notch_center = constrain_float(center_freq_hz[center_n], 0.0f, nyquist_limit);
+        if (use_cache &&
+            (_settled_centers & (1U<<center_n)) &&
+            is_equal(notch_center, _last_center_freq_hz[center_n])) {
+            _num_enabled_filters += _composite_notches;
+            continue;
+        }
         const uint8_t harmonic_mul = (harmonic_n+1);
+        bool settled = true;
         if (_composite_notches != 2) {
-            set_center_frequency(_num_enabled_filters++, notch_center, 1.0, harmonic_mul);
+            settled &= set_center_frequency(_num_enabled_filters++, notch_center, 1.0, harmonic_mul);
         }
         if (_composite_notches > 1) {
-            set_center_frequency(_num_enabled_filters++, notch_center, 1.0 - _notch_spread, harmonic_mul);
-            set_center_frequency(_num_enabled_filters++, notch_center, 1.0 + _notch_spread, harmonic_mul);
+            settled &= set_center_frequency(_num_enabled_filters++, notch_center, 1.0 - _notch_spread, harmonic_mul);
+            settled &= set_center_frequency(_num_enabled_filters++, notch_center, 1.0 + _notch_spread, harmonic_mul);
+        }
+        if (!settled && have_cache) {
+            settled_centers &= ~(1U<<center_n);
+        }
+    }
+
+    if (have_cache) {
+        for (uint8_t i = 0; i < num_centers; i++) {
+            _last_center_freq_hz[i] = constrain_float(center_freq_hz[i], 0.0f, nyquist_limit);
+        }
+        _num_last_centers = num_centers;
+    }
+    _settled_centers = settled_centers;
+
+    check_all_filters_active();
+}
+
+/*
+  check if every enabled filter is running with no reset pending, in
+  which case apply() can skip the per-filter state checks
+ */
+template <class T>
+void HarmonicNotchFilter<T>::check_all_filters_active(void)
+{
+    _all_filters_active = true;
+    for (uint16_t i = 0; i < _num_enabled_filters; i++) {
+        if (!_filters[i].initialised || _filters[i].need_reset) {
+            _all_filters_active = false;
+            break;
         }
     }
 }
@@ -407,6 +476,22 @@ T HarmonicNotchFilter<T>::apply(const T &sample)
 #endif
 
     T output = sample;
+#if !NOTCH_DEBUG_LOGGING
+    if (_all_filters_active && !_reset_pending) {
+        /*
+          the steady state case: run the cascade of biquads directly
+          on each filter's coefficients and state with no per-filter
+          checks or calls, leaving the compiler free to vectorise
+          across the axes of T
+         */
+        for (uint16_t i = 0; i < _num_enabled_filters; i++) {
+            output = _filters[i].apply_biquad(output);
+        }
+        return output;
+    }
+    const bool reset_pending = _reset_pending;
+    _reset_pending = false;
+#endif
     for (uint16_t i = 0; i < _num_enabled_filters; i++) {
 #if NOTCH_DEBUG_LOGGING
         if (!_filters[i].initialised) {
@@ -421,6 +506,10 @@ T HarmonicNotchFilter<T>::apply(const T &sample)
     if (_num_enabled_filters > 0) {
         ::dprintf(dfd, "\n");
     }
+#else
+    if (reset_pending) {
+        check_all_filters_active();
+    }
 #endif
     return output;
 }
@@ -438,6 +527,7 @@ void HarmonicNotchFilter<T>::reset()
     for (uint16_t i = 0; i < _num_filters; i++) {
         _filters[i].reset();
     }
+    _reset_pending = true;
 }
 
 #if HAL_LOGGING_ENABLED
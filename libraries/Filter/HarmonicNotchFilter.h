@@ -46,8 +46,9 @@ public:
       set center frequency of one notch.
       spread_mul is a scale factor for spreading of double or triple notch
       harmonic_mul is the multiplier for harmonics, 1 is for the fundamental
+      returns true if the notch has reached its target frequency or is disabled
     */
-    void set_center_frequency(uint16_t idx, float center_freq_hz, float spread_mul, uint8_t harmonic_mul);
+    bool set_center_frequency(uint16_t idx, float center_freq_hz, float spread_mul, uint8_t harmonic_mul);
 
     // apply a sample to each of the underlying filters in turn
     T apply(const T &sample);
@@ -90,6 +91,27 @@ private:
 
     // pointer to params object for this filter
     HarmonicNotchFilterParams *params;
+
+    // source frequencies from the last update(), used to skip
+    // recalculating coefficients for sources that have not moved
+    float *_last_center_freq_hz;
+    uint8_t _num_last_centers;
+    // bitmask of sources whose notches have all reached their target
+    uint32_t _settled_centers;
+    // TreatLowAsMin option used by the last update(), the option is
+    // read on every update rather than only by init()
+    bool _last_treat_low_as_min;
+
+    // all enabled filters are initialised with no reset pending, so
+    // apply() can run the cascade without per-filter state checks
+    bool _all_filters_active;
+    // reset() has been called and not yet processed by apply()
+    bool _reset_pending;
+
+    // mark all sources unsettled so the next update() recalculates everything
+    void invalidate_center_cache(void) { _settled_centers = 0; }
+    // recalculate _all_filters_active
+    void check_all_filters_active(void);
 };
 
 // Harmonic notch update mode
@@ -118,14 +118,7 @@ T NotchFilter<T>::apply(const T &sample)
         return sample;
     }
 
-    T output = sample*b0 + ntchsig1*b1 + ntchsig2*b2 - signal1*a1 - signal2*a2;
-
-    ntchsig2 = ntchsig1;
-    ntchsig1 = sample;
-
-    signal2 = signal1;
-    signal1 = output;
-    return output;
+    return apply_biquad(sample);
 }
 
 template <class T>
@@ -363,4 +363,200 @@ TEST(NotchFilterTest, HarmonicNotchTest5)
     fclose(f);
 }
 
+/*
+  test that a vector harmonic notch matches one float harmonic notch
+  per axis with multiple sources updated every sample, including a
+  reset part way through
+ */
+TEST(NotchFilterTest, HarmonicNotchVectorTest)
+{
+    const uint16_t rate_hz = 2000;
+    const uint8_t num_sources = 4;
+    const uint16_t harmonics = 7;
+
+    HarmonicNotchFilterParams notch_params {};
+    notch_params.set_options(uint16_t(HarmonicNotchFilterParams::Options::TripleNotch));
+    notch_params.set_attenuation(40);
+    notch_params.set_bandwidth_hz(40);
+    notch_params.set_center_freq_hz(80);
+    notch_params.set_freq_min_ratio(0.5);
+
+    HarmonicNotchFilter<Vector3f> vfilter {};
+    HarmonicNotchFilter<float> ffilter[3] {};
+    vfilter.allocate_filters(num_sources, harmonics, notch_params.num_composite_notches());
+    vfilter.init(rate_hz, notch_params);
+    for (auto &f : ffilter) {
+        f.allocate_filters(num_sources, harmonics, notch_params.num_composite_notches());
+        f.init(rate_hz, notch_params);
+    }
+
+    for (uint32_t s=0; s<20000; s++) {
+        // hold the sources steady for periods so that unchanged updates are exercised
+        const float base = (s/2000) % 2 == 0 ? 100 : 60 + 40 * sinf(s * 0.003);
+        const float centers[num_sources] { base, base*1.1f, base*0.9f, base*1.05f };
+        vfilter.update(num_sources, centers);
+        for (auto &f : ffilter) {
+            f.update(num_sources, centers);
+        }
+        if (s == 5000) {
+            vfilter.reset();
+            for (auto &f : ffilter) {
+                f.reset();
+            }
+        }
+        const Vector3f sample { sinf(s * 0.3), cosf(s * 0.17), sinf(s * 0.05 + 1) };
+        const Vector3f v = vfilter.apply(sample);
+        EXPECT_FLOAT_EQ(v.x, ffilter[0].apply(sample.x));
+        EXPECT_FLOAT_EQ(v.y, ffilter[1].apply(sample.y));
+        EXPECT_FLOAT_EQ(v.z, ffilter[2].apply(sample.z));
+    }
+}
+
+/*
+  test that each axis of a vector harmonic notch matches a cascade of
+  plain float notches, one per harmonic, configured by hand from the
+  source frequency on every sample
+ */
+TEST(NotchFilterTest, HarmonicNotchVectorReferenceTest)
+{
+    const uint16_t rate_hz = 2000;
+    const uint8_t num_harmonics = 2;
+    const float min_freq = 40;
+
+    HarmonicNotchFilterParams notch_params {};
+    notch_params.set_options(uint16_t(HarmonicNotchFilterParams::Options::TreatLowAsMin));
+    notch_params.set_attenuation(40);
+    notch_params.set_bandwidth_hz(40);
+    notch_params.set_center_freq_hz(80);
+    notch_params.set_freq_min_ratio(min_freq / 80);
+
+    HarmonicNotchFilter<Vector3f> vfilter {};
+    vfilter.allocate_filters(1, (1U<<num_harmonics)-1, notch_params.num_composite_notches());
+    vfilter.init(rate_hz, notch_params);
+
+    // the harmonic notch takes A and Q from the configured center frequency
+    float A, Q;
+    NotchFilter<float>::calculate_A_and_Q(80, 40, 40, A, Q);
+    NotchFilter<float> ref[3][num_harmonics] {};
+
+    // start at the configured center frequency, as init() does for a fixed notch
+    vfilter.update(80);
+    for (auto &axis : ref) {
+        for (uint8_t h=0; h<num_harmonics; h++) {
+            axis[h].init_with_A_and_Q(rate_hz, 80 * (h+1), A, Q);
+        }
+    }
+
+    for (uint32_t s=0; s<20000; s++) {
+        // hold the source steady for periods, including below the minimum frequency
+        const float freq = (s/2000) % 2 == 0 ? 30 + 10 * ((s/2000) % 5) : 70 + 40 * sinf(s * 0.003);
+        vfilter.update(freq);
+        for (auto &axis : ref) {
+            for (uint8_t h=0; h<num_harmonics; h++) {
+                axis[h].init_with_A_and_Q(rate_hz, MAX(freq * (h+1), min_freq * (h+1)), A, Q);
+            }
+        }
+        if (s == 5000) {
+            vfilter.reset();
+            for (auto &axis : ref) {
+                for (auto &notch : axis) {
+                    notch.reset();
+                }
+            }
+        }
+        const Vector3f sample { sinf(s * 0.3), cosf(s * 0.17), sinf(s * 0.05 + 1) };
+        const Vector3f v = vfilter.apply(sample);
+        const float expected[3] {
+            ref[0][1].apply(ref[0][0].apply(sample.x)),
+            ref[1][1].apply(ref[1][0].apply(sample.y)),
+            ref[2][1].apply(ref[2][0].apply(sample.z)),
+        };
+        EXPECT_FLOAT_EQ(v.x, expected[0]);
+        EXPECT_FLOAT_EQ(v.y, expected[1]);
+        EXPECT_FLOAT_EQ(v.z, expected[2]);
+    }
+}
+
+/*
+  test that changing the options at runtime is picked up by update()
+  even when the source frequency is unchanged
+ */
+TEST(NotchFilterTest, HarmonicNotchOptionChangeTest)
+{
+    const uint16_t rate_hz = 2000;
+    const float source_freq = 30;
+
+    HarmonicNotchFilterParams notch_params[2] {};
+    for (auto &p : notch_params) {
+        p.set_attenuation(40);
+        p.set_bandwidth_hz(40);
+        p.set_center_freq_hz(80);
+        p.set_freq_min_ratio(0.5);
+    }
+    notch_params[1].set_options(uint16_t(HarmonicNotchFilterParams::Options::TreatLowAsMin));
+
+    HarmonicNotchFilter<float> filter[2] {};
+    for (uint8_t i=0; i<2; i++) {
+        filter[i].allocate_filters(1, 1, 1);
+        filter[i].init(rate_hz, notch_params[i]);
+    }
+
+    // below the minimum frequency the first filter fades out its notch
+    for (uint8_t i=0; i<5; i++) {
+        filter[0].update(source_freq);
+        filter[1].update(source_freq);
+    }
+
+    // it should then slew to the minimum frequency like the second
+    notch_params[0].set_options(uint16_t(HarmonicNotchFilterParams::Options::TreatLowAsMin));
+    for (uint8_t i=0; i<20; i++) {
+        filter[0].update(source_freq);
+        filter[1].update(source_freq);
+    }
+
+    filter[0].reset();
+    filter[1].reset();
+    for (uint32_t s=0; s<2000; s++) {
+        const float sample = sinf(40 * s * 2 * M_PI / rate_hz);
+        EXPECT_FLOAT_EQ(filter[0].apply(sample), filter[1].apply(sample));
+    }
+}
+
+/*
+  test that repeated updates with an unchanged source frequency keep
+  moving a slew limited notch until it reaches the new frequency
+ */
+TEST(NotchFilterTest, HarmonicNotchSlewTest)
+{
+    const uint16_t rate_hz = 2000;
+    const float target_freq = 150;
+
+    HarmonicNotchFilterParams notch_params {};
+    notch_params.set_attenuation(40);
+    notch_params.set_bandwidth_hz(40);
+    notch_params.set_center_freq_hz(80);
+    notch_params.set_freq_min_ratio(0.5);
+
+    HarmonicNotchFilter<float> filter {};
+    filter.allocate_filters(1, 1, 1);
+    filter.init(rate_hz, notch_params);
+    filter.update(80);
+
+    // 5% slew per update needs 13 updates to get from 80Hz to 150Hz
+    for (uint8_t i=0; i<20; i++) {
+        filter.update(target_freq);
+    }
+
+    // a sine at the target frequency should now be attenuated
+    float v_max = 0;
+    for (uint32_t s=0; s<4000; s++) {
+        const float sample = sinf(target_freq * s * 2 * M_PI / rate_hz);
+        const float v = filter.apply(sample);
+        if (s >= 2000) {
+            v_max = MAX(v_max, fabsF(v));
+        }
+    }
+    EXPECT_LE(v_max, 0.05);
+}
+
 AP_GTEST_MAIN()
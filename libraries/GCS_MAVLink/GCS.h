@@ -470,6 +470,9 @@ public:
       returns true if a match is found
      */
     static bool find_by_mavtype_and_compid(uint8_t mav_type, uint8_t compid, uint8_t &sysid, mavlink_channel_t &channel) { return routing.find_by_mavtype_and_compid(mav_type, compid, sysid, channel); }
+
+    // fill in the learned routes and their forwarding counters, for @SYS/routes.txt
+    static void routing_info(ExpandingString &str) { routing.routing_info(str); }
     // same as above, but returns a pointer to the GCS_MAVLINK object
     // corresponding to the channel
     static GCS_MAVLINK *find_by_mavtype_and_compid(uint8_t mav_type, uint8_t compid, uint8_t &sysid);
@@ -494,6 +497,12 @@ public:
     virtual uint64_t capabilities() const;
     uint16_t get_stream_slowdown_ms() const { return stream_slowdown_ms; }
 
+#if AP_MAVLINK_STREAM_BUDGET_ENABLED
+    // fill in requested and achieved rates of each streamed message,
+    // for @SYS/streams.txt
+    void stream_budget_info(ExpandingString &str) const;
+#endif
+
     MAV_RESULT set_message_interval(uint32_t msg_id, int32_t interval_us);
 
 protected:
@@ -858,6 +867,18 @@ private:
         Bitmask<MSG_LAST> ap_message_ids;
         uint16_t interval_ms;
         uint16_t last_sent_ms; // from AP_HAL::millis16()
+#if AP_MAVLINK_STREAM_BUDGET_ENABLED
+        // counted since the last budget update:
+        uint16_t sends;         // times every message in the bucket was sent
+        uint32_t bytes;         // bytes sent by messages in the bucket
+        // from the last budget update:
+        uint16_t cycle_bytes;   // smoothed bytes to send the whole bucket once
+        uint16_t achieved_interval_ms;
+        uint16_t demand;        // bytes/s needed at interval_ms
+        uint16_t allocation;    // bytes/s given to the bucket
+        uint8_t weight;         // share of the link relative to other buckets
+        float stretch = 1.0f;   // multiplier on interval_ms to fit the allocation
+#endif
     };
     deferred_message_bucket_t deferred_message_bucket[10];
     static const uint8_t no_bucket_to_send = -1;
@@ -914,6 +935,26 @@ private:
     // the interval specified in "deferred"
     uint16_t get_reschedule_interval_ms(const deferred_message_bucket_t &deferred) const;
 
+#if AP_MAVLINK_STREAM_BUDGET_ENABLED
+    // once a second, measure the link throughput and share it between
+    // the buckets, stretching the intervals of buckets which get less
+    // than they need
+    void update_stream_budget(uint32_t now_ms);
+    // relative importance of a streamed message
+    static uint8_t stream_budget_weight(ap_message id);
+    // forget the measurements of a bucket which has been freed
+    void reset_stream_budget(deferred_message_bucket_t &bucket);
+#if HAL_LOGGING_ENABLED
+    void log_stream_budget(uint8_t bucket) const;
+#endif
+    struct {
+        uint32_t last_update_ms;
+        uint32_t last_tx_bytes;
+        uint16_t last_out_of_space_count;
+        float capacity;         // estimated link capacity in bytes/s
+    } stream_budget;
+#endif
+
     bool do_try_send_message(const ap_message id);
 
     // time when we missed sending a parameter for GCS
@@ -1013,19 +1054,56 @@ private:
         Write,
     };
 
+    // an open file, identified by the requester and the session
+    // number it chose
+    struct ftp_session {
+        int fd = -1;
+        FTP_FILE_MODE mode; // work around AP_Filesystem not supporting file modes
+        mavlink_channel_t chan;
+        uint8_t sysid;
+        uint8_t compid;
+        uint8_t id;
+        uint32_t last_use_ms;
+        uint32_t file_pos; // offset fd is at, to avoid needless seeks
+#if AP_MAVLINK_FTP_READAHEAD_SIZE > 0
+        uint8_t *readahead;
+        uint32_t readahead_offset; // file offset of readahead[0]
+        uint32_t readahead_len;
+#endif
+        // burst read in progress, sent a packet at a time so bursts
+        // on several sessions share the worker
+        struct {
+            uint32_t offset; // of the next packet
+            uint16_t remaining; // packets left to send
+            uint16_t seq_number;
+            uint8_t max_read;
+            uint32_t delay_ms;
+            uint32_t last_send_ms;
+        } burst;
+    };
+
     struct ftp_state {
         ObjectBuffer<pending_ftp> *requests;
 
-        // session specific info, currently only support a single session over all links
-        int fd = -1;
-        FTP_FILE_MODE mode; // work around AP_Filesystem not supporting file modes
-        int16_t current_session;
+        ftp_session *sessions; // AP_MAVLINK_FTP_MAX_SESSIONS of them
         uint32_t last_send_ms;
         uint8_t need_banner_send_mask;
     };
     static struct ftp_state ftp;
 
     static void ftp_error(struct pending_ftp &response, FTP_ERROR error); // FTP helper method for packing a NAK
+    // find the open session matching a request, or nullptr
+    static ftp_session *ftp_find_session(const pending_ftp &request);
+    // allocate a session for a request, closing idle sessions if needed
+    static ftp_session *ftp_new_session(const pending_ftp &request);
+    static void ftp_close_session(ftp_session &session);
+    // read len bytes at offset from a session's file, through its
+    // read-ahead buffer. burst is true for reads by a burst in
+    // progress. Returns less than len only at end of file
+    static ssize_t ftp_read(ftp_session &session, uint32_t offset, uint8_t *buf, uint8_t len, bool burst);
+    // send the next packet of each burst read in progress. Returns
+    // true if anything was sent
+    bool ftp_send_bursts(void);
     static int gen_dir_entry(char *dest, size_t space, const char * path, const struct dirent * entry); // FTP helper for emitting a dir response
     static void ftp_list_dir(struct pending_ftp &request, struct pending_ftp &response);
 
@@ -1198,6 +1198,11 @@ uint16_t GCS_MAVLINK::get_reschedule_interval_ms(const deferred_message_bucket_t
 {
     uint32_t interval_ms = deferred.interval_ms;
 
+#if AP_MAVLINK_STREAM_BUDGET_ENABLED
+    // fit within this bucket's share of the link:
+    interval_ms = uint32_t(interval_ms * deferred.stretch);
+#endif
+
     interval_ms += stream_slowdown_ms;
 
     // slow most messages down if we're transfering parameters or
@@ -1224,6 +1229,263 @@ uint16_t GCS_MAVLINK::get_reschedule_interval_ms(const deferred_message_bucket_t
     return interval_ms;
 }
 
+#if AP_MAVLINK_STREAM_BUDGET_ENABLED
+// fraction of the estimated link capacity the buckets may plan to use,
+// leaving room for parameters, mission items, statustexts etc
+#define STREAM_BUDGET_HEADROOM 0.85f
+// no bucket is slowed down by more than this factor
+#define STREAM_BUDGET_MAX_STRETCH 20.0f
+
+uint8_t GCS_MAVLINK::stream_budget_weight(ap_message id)
+{
+    switch (id) {
+    // what a pilot needs to see on a ground station
+    case MSG_ATTITUDE:
+    case MSG_ATTITUDE_QUATERNION:
+    case MSG_LOCATION:
+    case MSG_VFR_HUD:
+    case MSG_SYS_STATUS:
+    case MSG_EXTENDED_SYS_STATE:
+    case MSG_GPS_RAW:
+    case MSG_BATTERY_STATUS:
+    case MSG_EKF_STATUS_REPORT:
+    case MSG_CURRENT_WAYPOINT:
+    case MSG_NAV_CONTROLLER_OUTPUT:
+    case MSG_HOME:
+        return 4;
+    // raw data and diagnostics
+    case MSG_RAW_IMU:
+    case MSG_SCALED_IMU:
+    case MSG_SCALED_IMU2:
+    case MSG_SCALED_IMU3:
+    case MSG_SCALED_PRESSURE:
+    case MSG_SCALED_PRESSURE2:
+    case MSG_SCALED_PRESSURE3:
+    case MSG_SERVO_OUTPUT_RAW:
+    case MSG_RC_CHANNELS:
+    case MSG_RC_CHANNELS_RAW:
+    case MSG_PID_TUNING:
+    case MSG_ESC_TELEMETRY:
+    case MSG_VIBRATION:
+    case MSG_MEMINFO:
+    case MSG_MCU_STATUS:
+    case MSG_HWSTATUS:
+    case MSG_POWER_STATUS:
+    case MSG_SYSTEM_TIME:
+    case MSG_AHRS:
+    case MSG_AHRS2:
+    case MSG_SIMSTATE:
+    case MSG_SIM_STATE:
+        return 1;
+    default:
+        return 2;
+    }
+}
+
+void GCS_MAVLINK::reset_stream_budget(deferred_message_bucket_t &bucket)
+{
+    bucket.sends = 0;
+    bucket.bytes = 0;
+    bucket.cycle_bytes = 0;
+    bucket.achieved_interval_ms = 0;
+    bucket.demand = 0;
+    bucket.allocation = 0;
+    bucket.weight = 0;
+    bucket.stretch = 1.0f;
+}
+
+/*
+  share the link between the buckets. Each bucket asks for the bytes
+  per second it takes to send all of its messages at its interval.
+  When that adds up to more than the link can carry, the capacity is
+  divided by weighted max-min fairness: buckets asking for less than
+  their weighted share get what they ask for and the remainder is
+  split between the rest by weight. A bucket given less than it asks
+  for has its interval stretched to match.
+ */
+void GCS_MAVLINK::update_stream_budget(uint32_t now_ms)
+{
+    if (stream_budget.last_update_ms == 0) {
+        // assume the port can carry what it says until we find out
+        // otherwise
+        stream_budget.last_update_ms = now_ms;
+        stream_budget.last_tx_bytes = mavlink_comm_tx_bytes[chan];
+        stream_budget.capacity = _port != nullptr ? _port->bw_in_bytes_per_second() : 0;
+        return;
+    }
+    const uint32_t dt_ms = now_ms - stream_budget.last_update_ms;
+    if (dt_ms < 1000) {
+        return;
+    }
+    stream_budget.last_update_ms = now_ms;
+
+    const uint32_t tx_bytes = mavlink_comm_tx_bytes[chan];
+    const float link_rate = (tx_bytes - stream_budget.last_tx_bytes) * 1000.0f / dt_ms;
+    stream_budget.last_tx_bytes = tx_bytes;
+
+    // the link is full if messages did not fit in the UART buffer or
+    // the radio has asked us to slow down
+    const bool congested = out_of_space_to_send_count != stream_budget.last_out_of_space_count ||
+                           stream_slowdown_ms != 0;
+    stream_budget.last_out_of_space_count = out_of_space_to_send_count;
+
+    if (congested) {
+        // everything the link would take went out, so what went out
+        // is the capacity
+        stream_budget.capacity = link_rate;
+    } else {
+        // probe for more bandwidth, up to what the port can carry
+        stream_budget.capacity = MAX(stream_budget.capacity, link_rate) * 1.1f;
+    }
+    if (_port != nullptr) {
+        stream_budget.capacity = MIN(stream_budget.capacity, _port->bw_in_bytes_per_second());
+    }
+
+    const uint8_t num_buckets = ARRAY_SIZE(deferred_message_bucket);
+    float demand[num_buckets] {};
+    float allocation[num_buckets] {};
+    bool satisfied[num_buckets] {};
+    float bucket_rate = 0;
+    for (uint8_t i=0; i<num_buckets; i++) {
+        deferred_message_bucket_t &bucket = deferred_message_bucket[i];
+        bucket_rate += bucket.bytes * 1000.0f / dt_ms;
+        if (bucket.sends > 0) {
+            const uint32_t cycle_bytes = bucket.bytes / bucket.sends;
+            if (bucket.cycle_bytes == 0) {
+                bucket.cycle_bytes = MIN(cycle_bytes, UINT16_MAX);
+            } else {
+                bucket.cycle_bytes = MIN((3U*bucket.cycle_bytes + cycle_bytes) / 4U, UINT16_MAX);
+            }
+        } else if (bucket.cycle_bytes == 0) {
+            // part way through the first send of the bucket
+            bucket.cycle_bytes = MIN(bucket.bytes, UINT16_MAX);
+        }
+        bucket.achieved_interval_ms = bucket.sends > 0 ? MIN(dt_ms / bucket.sends, UINT16_MAX) : 0;
+        bucket.sends = 0;
+        bucket.bytes = 0;
+
+        if (bucket.interval_ms == 0) {
+            satisfied[i] = true;
+            continue;
+        }
+        uint8_t weight = 0;
+        Bitmask<MSG_LAST> ids;
+        ids = bucket.ap_message_ids;
+        for (int16_t id = ids.first_set(); id != -1; id = ids.first_set()) {
+            weight = MAX(weight, stream_budget_weight((ap_message)id));
+            ids.clear(id);
+        }
+        bucket.weight = weight;
+        demand[i] = bucket.cycle_bytes * 1000.0f / bucket.interval_ms;
+    }
+
+    // whatever is not sent from buckets has to fit as well
+    const float other_rate = MAX(link_rate - bucket_rate, 0.0f);
+    float remaining = MAX(stream_budget.capacity * STREAM_BUDGET_HEADROOM - other_rate, 0.0f);
+
+    // weighted water filling; each pass satisfies at least one
+    // bucket or gives every remaining bucket its weighted share
+    for (uint8_t pass=0; pass<num_buckets; pass++) {
+        float weight_sum = 0;
+        for (uint8_t i=0; i<num_buckets; i++) {
+            if (!satisfied[i]) {
+                weight_sum += deferred_message_bucket[i].weight;
+            }
+        }
+        if (!is_positive(weight_sum)) {
+            break;
+        }
+        const float share = remaining / weight_sum;
+        bool changed = false;
+        for (uint8_t i=0; i<num_buckets; i++) {
+            if (satisfied[i] || demand[i] > share * deferred_message_bucket[i].weight) {
+                continue;
+            }
+            allocation[i] = demand[i];
+            remaining -= demand[i];
+            satisfied[i] = true;
+            changed = true;
+        }
+        if (!changed) {
+            for (uint8_t i=0; i<num_buckets; i++) {
+                if (!satisfied[i]) {
+                    allocation[i] = share * deferred_message_bucket[i].weight;
+                }
+            }
+            break;
+        }
+    }
+
+    for (uint8_t i=0; i<num_buckets; i++) {
+        deferred_message_bucket_t &bucket = deferred_message_bucket[i];
+        if (bucket.interval_ms == 0) {
+            continue;
+        }
+        float target = 1.0f;
+        if (demand[i] > allocation[i]) {
+            target = is_positive(allocation[i]) ? demand[i] / allocation[i] : STREAM_BUDGET_MAX_STRETCH;
+        }
+        target = constrain_float(target, 1.0f, STREAM_BUDGET_MAX_STRETCH);
+        // slow down quickly to relieve the link, recover gently so
+        // we don't oscillate
+        const float gain = target > bucket.stretch ? 0.5f : 0.2f;
+        bucket.stretch += (target - bucket.stretch) * gain;
+        if (bucket.stretch < 1.01f) {
+            bucket.stretch = 1.0f;
+        }
+        bucket.demand = uint16_t(MIN(demand[i], UINT16_MAX));
+        bucket.allocation = uint16_t(MIN(allocation[i], UINT16_MAX));
+#if HAL_LOGGING_ENABLED
+        if (is_active() || is_streaming()) {
+            log_stream_budget(i);
+        }
+#endif
+    }
+}
+
+#if HAL_LOGGING_ENABLED
+void GCS_MAVLINK::log_stream_budget(uint8_t bucket_id) const
+{
+    const deferred_message_bucket_t &bucket = deferred_message_bucket[bucket_id];
+    const struct log_MAV_Stream pkt{
+        LOG_PACKET_HEADER_INIT(LOG_MAV_STREAM_MSG),
+        time_us         : AP_HAL::micros64(),
+        chan            : (uint8_t)chan,
+        bucket          : bucket_id,
+        num_messages    : (uint8_t)bucket.ap_message_ids.count(),
+        weight          : bucket.weight,
+        interval_ms     : bucket.interval_ms,
+        achieved_ms     : bucket.achieved_interval_ms,
+        stretch         : bucket.stretch,
+        demand          : bucket.demand,
+        allocation      : bucket.allocation,
+        capacity        : (uint32_t)stream_budget.capacity,
+    };
+    AP::logger().WriteBlock(&pkt, sizeof(pkt));
+}
+#endif
+
+void GCS_MAVLINK::stream_budget_info(ExpandingString &str) const
+{
+    str.printf("chan %u capacity %u B/s\n", unsigned(chan), unsigned(stream_budget.capacity));
+    for (uint8_t i=0; i<ARRAY_SIZE(deferred_message_bucket); i++) {
+        const deferred_message_bucket_t &bucket = deferred_message_bucket[i];
+        if (bucket.interval_ms == 0) {
+            continue;
+        }
+        Bitmask<MSG_LAST> ids;
+        ids = bucket.ap_message_ids;
+        for (int16_t id = ids.first_set(); id != -1; id = ids.first_set()) {
+            ids.clear(id);
+            str.printf("  msg %3d bucket %u weight %u requested %5ums achieved %5ums stretch %.2f\n",
+                       id, unsigned(i), unsigned(stream_budget_weight((ap_message)id)),
+                       unsigned(bucket.interval_ms), unsigned(bucket.achieved_interval_ms),
+                       bucket.stretch);
+        }
+    }
+}
+#endif  // AP_MAVLINK_STREAM_BUDGET_ENABLED
+
 // typical runtime on fmuv3: 5 microseconds for 3 buckets
 void GCS_MAVLINK::find_next_bucket_to_send(uint16_t now16_ms)
 {
@@ -1591,11 +1853,20 @@ void GCS_MAVLINK::update_send()
 
         ap_message next = next_deferred_bucket_message_to_send(start16);
         if (next != no_message_to_send) {
+#if AP_MAVLINK_STREAM_BUDGET_ENABLED
+            const uint32_t tx_bytes_before = mavlink_comm_tx_bytes[chan];
+#endif
             if (!do_try_send_message(next)) {
                 break;
             }
+#if AP_MAVLINK_STREAM_BUDGET_ENABLED
+            deferred_message_bucket[sending_bucket_id].bytes += mavlink_comm_tx_bytes[chan] - tx_bytes_before;
+#endif
             bucket_message_ids_to_send.clear(next);
             if (bucket_message_ids_to_send.count() == 0) {
+#if AP_MAVLINK_STREAM_BUDGET_ENABLED
+                deferred_message_bucket[sending_bucket_id].sends++;
+#endif
                 // we sent everything in the bucket.  Reschedule it.
                 // we try to keep output on a regular clock to avoid
                 // user support questions:
@@ -1633,6 +1904,10 @@ void GCS_MAVLINK::update_send()
     // between the last pass through here
     send_packet_count += uint8_t(_channel_status.current_tx_seq - last_tx_seq);
     last_tx_seq = _channel_status.current_tx_seq;
+
+#if AP_MAVLINK_STREAM_BUDGET_ENABLED
+    update_stream_budget(start);
+#endif
 }
 
 void GCS_MAVLINK::remove_message_from_bucket(int8_t bucket, ap_message id)
@@ -1642,6 +1917,9 @@ void GCS_MAVLINK::remove_message_from_bucket(int8_t bucket, ap_message id)
         // bucket empty.  Free it:
         deferred_message_bucket[bucket].interval_ms = 0;
         deferred_message_bucket[bucket].last_sent_ms = 0;
+#if AP_MAVLINK_STREAM_BUDGET_ENABLED
+        reset_stream_budget(deferred_message_bucket[bucket]);
+#endif
     }
 
     if (bucket == sending_bucket_id) {
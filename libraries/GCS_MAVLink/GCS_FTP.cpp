@@ -53,6 +53,11 @@ bool GCS_MAVLINK::ftp_init(void) {
         goto failed;
     }
 
+    ftp.sessions = NEW_NOTHROW ftp_session[AP_MAVLINK_FTP_MAX_SESSIONS];
+    if (ftp.sessions == nullptr) {
+        goto failed;
+    }
+
     if (!hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&GCS_MAVLINK::ftp_worker, void),
                                       "FTP", 2560, AP_HAL::Scheduler::PRIORITY_IO, 0)) {
         goto failed;
@@ -63,6 +68,8 @@ bool GCS_MAVLINK::ftp_init(void) {
 failed:
     delete ftp.requests;
     ftp.requests = nullptr;
+    delete[] ftp.sessions;
+    ftp.sessions = nullptr;
     GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "failed to initialize MAVFTP");
 
     return false;
@@ -148,7 +155,13 @@ void GCS_MAVLINK::ftp_push_replies(pending_ftp &reply)
 {
     ftp.last_send_ms = AP_HAL::millis(); // Used to detect active FTP session
 
-    while (!send_ftp_reply(reply)) {
+    // the reply goes out on the link the request came in on, which is
+    // not necessarily the one running the worker
+    GCS_MAVLINK *link = gcs().chan(reply.chan);
+    if (link == nullptr) {
+        return;
+    }
+    while (!link->send_ftp_reply(reply)) {
         hal.scheduler->delay(2);
     }
 
@@ -167,6 +180,181 @@ void GCS_MAVLINK::ftp_push_replies(pending_ftp &reply)
     }
 }
 
+GCS_MAVLINK::ftp_session *GCS_MAVLINK::ftp_find_session(const pending_ftp &request)
+{
+    for (uint8_t i=0; i<AP_MAVLINK_FTP_MAX_SESSIONS; i++) {
+        ftp_session &session = ftp.sessions[i];
+        if (session.fd != -1 && session.id == request.session && session.chan == request.chan &&
+            session.sysid == request.sysid && session.compid == request.compid) {
+            return &session;
+        }
+    }
+    return nullptr;
+}
+
+GCS_MAVLINK::ftp_session *GCS_MAVLINK::ftp_new_session(const pending_ftp &request)
+{
+    // take a free session, or failing that the one idle for longest
+    // if it has timed out
+    const uint32_t now = AP_HAL::millis();
+    ftp_session *ret = nullptr;
+    for (uint8_t i=0; i<AP_MAVLINK_FTP_MAX_SESSIONS; i++) {
+        ftp_session &session = ftp.sessions[i];
+        if (session.fd == -1) {
+            ret = &session;
+            break;
+        }
+        const uint32_t idle_ms = now - session.last_use_ms;
+        if (idle_ms >= FTP_SESSION_TIMEOUT &&
+            (ret == nullptr || idle_ms > now - ret->last_use_ms)) {
+            ret = &session;
+        }
+    }
+    if (ret == nullptr) {
+        return nullptr;
+    }
+    if (ret->fd != -1) {
+        ftp_close_session(*ret);
+    }
+    ret->chan = request.chan;
+    ret->sysid = request.sysid;
+    ret->compid = request.compid;
+    ret->id = request.session;
+    ret->last_use_ms = now;
+    ret->file_pos = 0;
+    return ret;
+}
+
+void GCS_MAVLINK::ftp_close_session(ftp_session &session)
+{
+    if (session.fd != -1) {
+        AP::FS().close(session.fd);
+        session.fd = -1;
+    }
+    session.burst.remaining = 0;
+#if AP_MAVLINK_FTP_READAHEAD_SIZE > 0
+    delete[] session.readahead;
+    session.readahead = nullptr;
+    session.readahead_len = 0;
+#endif
+}
+
+ssize_t GCS_MAVLINK::ftp_read(ftp_session &session, uint32_t offset, uint8_t *buf, uint8_t len, bool burst)
+{
+#if AP_MAVLINK_FTP_READAHEAD_SIZE > 0
+    /*
+      a ReadFile filling a gap while a burst is in progress is usually
+      behind the buffer the burst is reading from. Refilling the buffer
+      for it would make the burst's next packet refill it again, so
+      unless the gap is already buffered it is read directly
+     */
+    const bool gap_fill = !burst && session.burst.remaining != 0 &&
+        (offset < session.readahead_offset || offset + len > session.readahead_offset + session.readahead_len);
+    if (session.readahead != nullptr && !gap_fill) {
+        uint8_t total = 0;
+        while (total < len) {
+            const uint32_t ofs = offset + total;
+            if (ofs < session.readahead_offset || ofs >= session.readahead_offset + session.readahead_len) {
+                // refill the buffer from here with one large read
+                session.readahead_len = 0;
+                if (session.file_pos != ofs && AP::FS().lseek(session.fd, ofs, SEEK_SET) == -1) {
+                    session.file_pos = UINT32_MAX;
+                    return -1;
+                }
+                const ssize_t read_bytes = AP::FS().read(session.fd, session.readahead, AP_MAVLINK_FTP_READAHEAD_SIZE);
+                if (read_bytes == -1) {
+                    session.file_pos = UINT32_MAX;
+                    return -1;
+                }
+                session.readahead_offset = ofs;
+                session.readahead_len = read_bytes;
+                session.file_pos = ofs + read_bytes;
+                if (read_bytes == 0) {
+                    // end of file
+                    break;
+                }
+            }
+            const uint8_t n = MIN(session.readahead_offset + session.readahead_len - ofs, uint32_t(len - total));
+            memcpy(&buf[total], &session.readahead[ofs - session.readahead_offset], n);
+            total += n;
+        }
+        return total;
+    }
+#endif
+
+    // seek to requested offset, unless sequential
+    if (session.file_pos != offset && AP::FS().lseek(session.fd, offset, SEEK_SET) == -1) {
+        session.file_pos = UINT32_MAX;
+        return -1;
+    }
+    const ssize_t read_bytes = AP::FS().read(session.fd, buf, len);
+    session.file_pos = read_bytes == -1 ? UINT32_MAX : offset + read_bytes;
+    return read_bytes;
+}
+
+bool GCS_MAVLINK::ftp_send_bursts(void)
+{
+    if (ftp.sessions == nullptr) {
+        return false;
+    }
+    bool sent = false;
+    const uint32_t now = AP_HAL::millis();
+    for (uint8_t i=0; i<AP_MAVLINK_FTP_MAX_SESSIONS; i++) {
+        ftp_session &session = ftp.sessions[i];
+        if (session.fd == -1 || session.burst.remaining == 0 ||
+            now - session.burst.last_send_ms < session.burst.delay_ms) {
+            continue;
+        }
+        GCS_MAVLINK *link = gcs().chan(session.chan);
+        if (link == nullptr) {
+            session.burst.remaining = 0;
+            continue;
+        }
+        if (comm_get_txspace(session.chan) < PAYLOAD_SIZE(session.chan, FILE_TRANSFER_PROTOCOL)) {
+            // the link is busy, don't read until it can take the packet
+            continue;
+        }
+
+        pending_ftp reply {};
+        reply.chan = session.chan;
+        reply.sysid = session.sysid;
+        reply.compid = session.compid;
+        reply.session = session.id;
+        reply.req_opcode = FTP_OP::BurstReadFile;
+        reply.seq_number = session.burst.seq_number;
+        reply.offset = session.burst.offset;
+
+        const ssize_t read_bytes = ftp_read(session, session.burst.offset, reply.data, session.burst.max_read, true);
+        if (read_bytes == -1) {
+            ftp_error(reply, FTP_ERROR::FailErrno);
+        } else if (read_bytes == 0) {
+            ftp_error(reply, FTP_ERROR::EndOfFile);
+        } else {
+            reply.opcode = FTP_OP::Ack;
+            reply.size = (uint8_t)read_bytes;
+            reply.burst_complete = (session.burst.remaining == 1);
+        }
+
+        if (!link->send_ftp_reply(reply)) {
+            // the data stays in the read-ahead buffer for next time
+            continue;
+        }
+        sent = true;
+        ftp.last_send_ms = now;
+        session.last_use_ms = now;
+        session.burst.last_send_ms = now;
+
+        if (reply.opcode == FTP_OP::Nack) {
+            session.burst.remaining = 0;
+            continue;
+        }
+        session.burst.offset += read_bytes;
+        session.burst.seq_number++;
+        session.burst.remaining--;
+    }
+    return sent;
+}
+
 void GCS_MAVLINK::ftp_worker(void) {
     pending_ftp request;
     pending_ftp reply = {};
@@ -176,8 +364,11 @@ void GCS_MAVLINK::ftp_worker(void) {
         bool skip_push_reply = false;
 
         while (ftp.requests == nullptr || !ftp.requests->pop(request)) {
-            // nothing to handle, delay ourselves a bit then check again. Ideally we'd use conditional waits here
-            hal.scheduler->delay(2);
+            // nothing to handle, keep any bursts going or delay
+            // ourselves a bit then check again. Ideally we'd use conditional waits here
+            if (!ftp_send_bursts()) {
+                hal.scheduler->delay(2);
+            }
         }
 
         // if it's a rerequest and we still have the last response then send it
@@ -205,377 +396,349 @@ void GCS_MAVLINK::ftp_worker(void) {
 
         uint32_t now = AP_HAL::millis();
 
-        // check for session termination
-        if (request.session != ftp.current_session &&
-            (request.opcode == FTP_OP::TerminateSession || request.opcode == FTP_OP::ResetSessions)) {
-            // terminating a different session, just ack
-            reply.opcode = FTP_OP::Ack;
-        } else if (ftp.fd != -1 && request.session != ftp.current_session &&
-                   now - ftp.last_send_ms < FTP_SESSION_TIMEOUT) {
-            // if we have an open file and the session isn't right
-            // then reject. This prevents IO on the wrong file
-            ftp_error(reply, FTP_ERROR::InvalidSession);
-        } else {
-            if (ftp.fd != -1 &&
-                request.session != ftp.current_session &&
-                now - ftp.last_send_ms >= FTP_SESSION_TIMEOUT) {
-                // if a new session appears and the old session has
-                // been idle for more than the timeout then force
-                // close the old session
-                AP::FS().close(ftp.fd);
-                ftp.fd = -1;
-                ftp.current_session = -1;
-            }
-            // dispatch the command as needed
-            switch (request.opcode) {
-                case FTP_OP::None:
-                    reply.opcode = FTP_OP::Ack;
-                    break;
-                case FTP_OP::TerminateSession:
-                case FTP_OP::ResetSessions:
-                    // we already handled this, just listed for completeness
-                    if (ftp.fd != -1) {
-                        AP::FS().close(ftp.fd);
-                        ftp.fd = -1;
-                    }
-                    ftp.current_session = -1;
-                    reply.opcode = FTP_OP::Ack;
-                    break;
-                case FTP_OP::ListDirectory:
-                    ftp_list_dir(request, reply);
-                    break;
-                case FTP_OP::OpenFileRO:
-                    {
-                        // only allow one file to be open per session
-                        if (ftp.fd != -1 && now - ftp.last_send_ms > FTP_SESSION_TIMEOUT) {
-                            // no activity for 3s, assume client has
-                            // timed out receiving open reply, close
-                            // the file
-                            AP::FS().close(ftp.fd);
-                            ftp.fd = -1;
-                            ftp.current_session = -1;
-                        }
-                        if (ftp.fd != -1) {
-                            ftp_error(reply, FTP_ERROR::Fail);
-                            break;
-                        }
-
-                        // sanity check that our the request looks well formed
-                        const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
-                        if ((file_name_len != request.size) || (request.size == 0)) {
-                            ftp_error(reply, FTP_ERROR::InvalidDataSize);
-                            break;
-                        }
-
-                        request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
+        // the file this request is for, if it has one open. Each
+        // requester has its own session numbers, so sessions from
+        // several GCSs on several links can be open at once
+        ftp_session *session = ftp_find_session(request);
 
-                        // get the file size
-                        struct stat st;
-                        if (AP::FS().stat((char *)request.data, &st)) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
-                        const size_t file_size = st.st_size;
-
-                        // actually open the file
-                        ftp.fd = AP::FS().open((char *)request.data, O_RDONLY);
-                        if (ftp.fd == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
-                        ftp.mode = FTP_FILE_MODE::Read;
-                        ftp.current_session = request.session;
-
-                        reply.opcode = FTP_OP::Ack;
-                        reply.size = sizeof(uint32_t);
-                        put_le32_ptr(reply.data, (uint32_t)file_size);
-
-                        // provide compatibility with old protocol banner download
-                        if (strncmp((const char *)request.data, "@PARAM/param.pck", 16) == 0) {
-                            ftp.need_banner_send_mask |= 1U<<reply.chan;
-                        }
+        // dispatch the command as needed
+        switch (request.opcode) {
+            case FTP_OP::None:
+                reply.opcode = FTP_OP::Ack;
+                break;
+            case FTP_OP::TerminateSession:
+                if (session != nullptr) {
+                    ftp_close_session(*session);
+                }
+                reply.opcode = FTP_OP::Ack;
+                break;
+            case FTP_OP::ResetSessions:
+                // close all sessions of this requester
+                for (uint8_t i=0; i<AP_MAVLINK_FTP_MAX_SESSIONS; i++) {
+                    ftp_session &s = ftp.sessions[i];
+                    if (s.fd != -1 && s.chan == request.chan &&
+                        s.sysid == request.sysid && s.compid == request.compid) {
+                        ftp_close_session(s);
+                    }
+                }
+                reply.opcode = FTP_OP::Ack;
+                break;
+            case FTP_OP::ListDirectory:
+                ftp_list_dir(request, reply);
+                break;
+            case FTP_OP::OpenFileRO:
+                {
+                    // only allow one file to be open per session
+                    if (session != nullptr && now - session->last_use_ms > FTP_SESSION_TIMEOUT) {
+                        // no activity for 3s, assume client has
+                        // timed out receiving open reply, close
+                        // the file
+                        ftp_close_session(*session);
+                        session = nullptr;
+                    }
+                    if (session != nullptr) {
+                        ftp_error(reply, FTP_ERROR::Fail);
                         break;
                     }
-                case FTP_OP::ReadFile:
-                    {
-                        // must actually be working on a file
-                        if (ftp.fd == -1) {
-                            ftp_error(reply, FTP_ERROR::FileNotFound);
-                            break;
-                        }
-
-                        // must have the file in read mode
-                        if ((ftp.mode != FTP_FILE_MODE::Read)) {
-                            ftp_error(reply, FTP_ERROR::Fail);
-                            break;
-                        }
 
-                        // seek to requested offset
-                        if (AP::FS().lseek(ftp.fd, request.offset, SEEK_SET) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    // sanity check that our the request looks well formed
+                    const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
+                    if ((file_name_len != request.size) || (request.size == 0)) {
+                        ftp_error(reply, FTP_ERROR::InvalidDataSize);
+                        break;
+                    }
 
-                        // fill the buffer
-                        const ssize_t read_bytes = AP::FS().read(ftp.fd, reply.data, MIN(sizeof(reply.data),request.size));
-                        if (read_bytes == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
-                        if (read_bytes == 0) {
-                            ftp_error(reply, FTP_ERROR::EndOfFile);
-                            break;
-                        }
+                    request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
 
-                        reply.opcode = FTP_OP::Ack;
-                        reply.offset = request.offset;
-                        reply.size = (uint8_t)read_bytes;
+                    // get the file size
+                    struct stat st;
+                    if (AP::FS().stat((char *)request.data, &st)) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
                         break;
                     }
-                case FTP_OP::Ack:
-                case FTP_OP::Nack:
-                    // eat these, we just didn't expect them
-                    continue;
-                    break;
-                case FTP_OP::OpenFileWO:
-                case FTP_OP::CreateFile:
-                    {
-                        // only allow one file to be open per session
-                        if (ftp.fd != -1) {
-                            ftp_error(reply, FTP_ERROR::Fail);
-                            break;
-                        }
+                    const size_t file_size = st.st_size;
 
-                        // sanity check that our the request looks well formed
-                        const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
-                        if ((file_name_len != request.size) || (request.size == 0)) {
-                            ftp_error(reply, FTP_ERROR::InvalidDataSize);
-                            break;
-                        }
+                    session = ftp_new_session(request);
+                    if (session == nullptr) {
+                        ftp_error(reply, FTP_ERROR::NoSessionsAvailable);
+                        break;
+                    }
 
-                        request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
+                    // actually open the file
+                    session->fd = AP::FS().open((char *)request.data, O_RDONLY);
+                    if (session->fd == -1) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
+                        break;
+                    }
+                    session->mode = FTP_FILE_MODE::Read;
+#if AP_MAVLINK_FTP_READAHEAD_SIZE > 0
+                    // without a buffer we read directly from the file
+                    session->readahead = NEW_NOTHROW uint8_t[AP_MAVLINK_FTP_READAHEAD_SIZE];
+#endif
 
-                        // actually open the file
-                        ftp.fd = AP::FS().open((char *)request.data,
-                                               (request.opcode == FTP_OP::CreateFile) ? O_WRONLY|O_CREAT|O_TRUNC : O_WRONLY);
-                        if (ftp.fd == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
-                        ftp.mode = FTP_FILE_MODE::Write;
-                        ftp.current_session = request.session;
+                    reply.opcode = FTP_OP::Ack;
+                    reply.size = sizeof(uint32_t);
+                    put_le32_ptr(reply.data, (uint32_t)file_size);
 
-                        reply.opcode = FTP_OP::Ack;
+                    // provide compatibility with old protocol banner download
+                    if (strncmp((const char *)request.data, "@PARAM/param.pck", 16) == 0) {
+                        ftp.need_banner_send_mask |= 1U<<reply.chan;
+                    }
+                    break;
+                }
+            case FTP_OP::ReadFile:
+                {
+                    // must actually be working on a file
+                    if (session == nullptr) {
+                        ftp_error(reply, FTP_ERROR::FileNotFound);
                         break;
                     }
-                case FTP_OP::WriteFile:
-                    {
-                        // must actually be working on a file
-                        if (ftp.fd == -1) {
-                            ftp_error(reply, FTP_ERROR::FileNotFound);
-                            break;
-                        }
-
-                        // must have the file in write mode
-                        if ((ftp.mode != FTP_FILE_MODE::Write)) {
-                            ftp_error(reply, FTP_ERROR::Fail);
-                            break;
-                        }
 
-                        // seek to requested offset
-                        if (AP::FS().lseek(ftp.fd, request.offset, SEEK_SET) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    // must have the file in read mode
+                    if ((session->mode != FTP_FILE_MODE::Read)) {
+                        ftp_error(reply, FTP_ERROR::Fail);
+                        break;
+                    }
 
-                        // fill the buffer
-                        const ssize_t write_bytes = AP::FS().write(ftp.fd, request.data, request.size);
-                        if (write_bytes == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    // fill the buffer
+                    const ssize_t read_bytes = ftp_read(*session, request.offset, reply.data, MIN(sizeof(reply.data),request.size), false);
+                    if (read_bytes == -1) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
+                        break;
+                    }
+                    if (read_bytes == 0) {
+                        ftp_error(reply, FTP_ERROR::EndOfFile);
+                        break;
+                    }
 
-                        reply.opcode = FTP_OP::Ack;
-                        reply.offset = request.offset;
+                    reply.opcode = FTP_OP::Ack;
+                    reply.offset = request.offset;
+                    reply.size = (uint8_t)read_bytes;
+                    break;
+                }
+            case FTP_OP::Ack:
+            case FTP_OP::Nack:
+                // eat these, we just didn't expect them
+                continue;
+                break;
+            case FTP_OP::OpenFileWO:
+            case FTP_OP::CreateFile:
+                {
+                    // only allow one file to be open per session
+                    if (session != nullptr) {
+                        ftp_error(reply, FTP_ERROR::Fail);
                         break;
                     }
-                case FTP_OP::CreateDirectory:
-                    {
-                        // sanity check that our the request looks well formed
-                        const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
-                        if ((file_name_len != request.size) || (request.size == 0)) {
-                            ftp_error(reply, FTP_ERROR::InvalidDataSize);
-                            break;
-                        }
 
-                        request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
+                    // sanity check that our the request looks well formed
+                    const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
+                    if ((file_name_len != request.size) || (request.size == 0)) {
+                        ftp_error(reply, FTP_ERROR::InvalidDataSize);
+                        break;
+                    }
 
-                        // actually make the directory
-                        if (AP::FS().mkdir((char *)request.data) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
 
-                        reply.opcode = FTP_OP::Ack;
+                    session = ftp_new_session(request);
+                    if (session == nullptr) {
+                        ftp_error(reply, FTP_ERROR::NoSessionsAvailable);
                         break;
                     }
-                case FTP_OP::RemoveDirectory:
-                case FTP_OP::RemoveFile:
-                    {
-                        // sanity check that our the request looks well formed
-                        const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
-                        if ((file_name_len != request.size) || (request.size == 0)) {
-                            ftp_error(reply, FTP_ERROR::InvalidDataSize);
-                            break;
-                        }
 
-                        request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
+                    // actually open the file
+                    session->fd = AP::FS().open((char *)request.data,
+                                                (request.opcode == FTP_OP::CreateFile) ? O_WRONLY|O_CREAT|O_TRUNC : O_WRONLY);
+                    if (session->fd == -1) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
+                        break;
+                    }
+                    session->mode = FTP_FILE_MODE::Write;
 
-                        // remove the file/dir
-                        if (AP::FS().unlink((char *)request.data) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    reply.opcode = FTP_OP::Ack;
+                    break;
+                }
+            case FTP_OP::WriteFile:
+                {
+                    // must actually be working on a file
+                    if (session == nullptr) {
+                        ftp_error(reply, FTP_ERROR::FileNotFound);
+                        break;
+                    }
 
-                        reply.opcode = FTP_OP::Ack;
+                    // must have the file in write mode
+                    if ((session->mode != FTP_FILE_MODE::Write)) {
+                        ftp_error(reply, FTP_ERROR::Fail);
                         break;
                     }
-                case FTP_OP::CalcFileCRC32:
-                    {
-                        // sanity check that our the request looks well formed
-                        const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
-                        if ((file_name_len != request.size) || (request.size == 0)) {
-                            ftp_error(reply, FTP_ERROR::InvalidDataSize);
-                            break;
-                        }
 
-                        request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
+                    // seek to requested offset, unless sequential
+                    if (session->file_pos != request.offset &&
+                        AP::FS().lseek(session->fd, request.offset, SEEK_SET) == -1) {
+                        session->file_pos = UINT32_MAX;
+                        ftp_error(reply, FTP_ERROR::FailErrno);
+                        break;
+                    }
 
-                        uint32_t checksum = 0;
-                        if (!AP::FS().crc32((char *)request.data, checksum)) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    // fill the buffer
+                    const ssize_t write_bytes = AP::FS().write(session->fd, request.data, request.size);
+                    if (write_bytes == -1) {
+                        session->file_pos = UINT32_MAX;
+                        ftp_error(reply, FTP_ERROR::FailErrno);
+                        break;
+                    }
+                    session->file_pos = request.offset + write_bytes;
 
-                        // reset our scratch area so we don't leak data, and can leverage trimming
-                        memset(reply.data, 0, sizeof(reply.data));
-                        reply.size = sizeof(uint32_t);
-                        put_le32_ptr(reply.data, checksum);
-                        reply.opcode = FTP_OP::Ack;
+                    reply.opcode = FTP_OP::Ack;
+                    reply.offset = request.offset;
+                    break;
+                }
+            case FTP_OP::CreateDirectory:
+                {
+                    // sanity check that our the request looks well formed
+                    const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
+                    if ((file_name_len != request.size) || (request.size == 0)) {
+                        ftp_error(reply, FTP_ERROR::InvalidDataSize);
                         break;
                     }
-                case FTP_OP::BurstReadFile:
-                    {
-                        const uint16_t max_read = (request.size == 0?sizeof(reply.data):request.size);
-                        // must actually be working on a file
-                        if (ftp.fd == -1) {
-                            ftp_error(reply, FTP_ERROR::FileNotFound);
-                            break;
-                        }
 
-                        // must have the file in read mode
-                        if ((ftp.mode != FTP_FILE_MODE::Read)) {
-                            ftp_error(reply, FTP_ERROR::Fail);
-                            break;
-                        }
+                    request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
 
-                        // seek to requested offset
-                        if (AP::FS().lseek(ftp.fd, request.offset, SEEK_SET) == -1) {
-                            ftp_error(reply, FTP_ERROR::FailErrno);
-                            break;
-                        }
+                    // actually make the directory
+                    if (AP::FS().mkdir((char *)request.data) == -1) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
+                        break;
+                    }
 
-                        /*
-                          calculate a burst delay so that FTP burst
-                          transfer doesn't use more than 1/3 of
-                          available bandwidth on links that don't have
-                          flow control. This reduces the chance of
-                          lost packets a lot, which results in overall
-                          faster transfers
-                         */
-                        uint32_t burst_delay_ms = 0;
-                        if (valid_channel(request.chan)) {
-                            auto *port = mavlink_comm_port[request.chan];
-                            if (port != nullptr && port->get_flow_control() != AP_HAL::UARTDriver::FLOW_CONTROL_ENABLE) {
-                                const uint32_t bw = port->bw_in_bytes_per_second();
-                                const uint16_t pkt_size = PAYLOAD_SIZE(request.chan, FILE_TRANSFER_PROTOCOL) - (sizeof(reply.data) - max_read);
-                                burst_delay_ms = 3000 * pkt_size / bw;
-                            }
-                        }
+                    reply.opcode = FTP_OP::Ack;
+                    break;
+                }
+            case FTP_OP::RemoveDirectory:
+            case FTP_OP::RemoveFile:
+                {
+                    // sanity check that our the request looks well formed
+                    const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
+                    if ((file_name_len != request.size) || (request.size == 0)) {
+                        ftp_error(reply, FTP_ERROR::InvalidDataSize);
+                        break;
+                    }
 
-                        // this transfer size is enough for a full parameter file with max parameters
-                        const uint32_t transfer_size = 500;
-                        for (uint32_t i = 0; (i < transfer_size); i++) {
-                            // fill the buffer
-                            const ssize_t read_bytes = AP::FS().read(ftp.fd, reply.data, MIN(sizeof(reply.data), max_read));
-                            if (read_bytes == -1) {
-                                ftp_error(reply, FTP_ERROR::FailErrno);
-                                break;
-                            }
-
-                            if (read_bytes != sizeof(reply.data)) {
-                                // don't send any old data
-                                memset(reply.data + read_bytes, 0, sizeof(reply.data) - read_bytes);
-                            }
-
-                            if (read_bytes == 0) {
-                                ftp_error(reply, FTP_ERROR::EndOfFile);
-                                break;
-                            }
-
-                            reply.opcode = FTP_OP::Ack;
-                            reply.offset = request.offset + i * max_read;
-                            reply.burst_complete = (i == (transfer_size - 1));
-                            reply.size = (uint8_t)read_bytes;
-
-                            ftp_push_replies(reply);
-
-                            if (read_bytes < max_read) {
-                                // ensure the NACK which we send next is at the right offset
-                                reply.offset += read_bytes;
-                            }
-
-                            // prep the reply to be used again
-                            reply.seq_number++;
-
-                            hal.scheduler->delay(burst_delay_ms);
-                        }
+                    request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
 
-                        if (reply.opcode != FTP_OP::Nack) {
-                            // prevent a duplicate packet send for
-                            // normal replies of burst reads
-                            skip_push_reply = true;
-                        }
+                    // remove the file/dir
+                    if (AP::FS().unlink((char *)request.data) == -1) {
+                        ftp_error(reply, FTP_ERROR::FailErrno);
                         break;
                     }
 
-                case FTP_OP::Rename: {
-                    // sanity check that the request looks well formed
-                    const char *filename1 = (char*)request.data;
-                    const size_t len1 = strnlen(filename1, sizeof(request.data)-2);
-                    const char *filename2 = (char*)&request.data[len1+1];
-                    const size_t len2 = strnlen(filename2, sizeof(request.data)-(len1+1));
-                    if (filename1[len1] != 0 || (len1+len2+1 != request.size) || (request.size == 0)) {
+                    reply.opcode = FTP_OP::Ack;
+                    break;
+                }
+            case FTP_OP::CalcFileCRC32:
+                {
+                    // sanity check that our the request looks well formed
+                    const size_t file_name_len = strnlen((char *)request.data, sizeof(request.data));
+                    if ((file_name_len != request.size) || (request.size == 0)) {
                         ftp_error(reply, FTP_ERROR::InvalidDataSize);
                         break;
                     }
-                    request.data[sizeof(request.data) - 1] = 0; // ensure the 2nd path is null terminated
-                    // remove the file/dir
-                    if (AP::FS().rename(filename1, filename2) != 0) {
+
+                    request.data[sizeof(request.data) - 1] = 0; // ensure the path is null terminated
+
+                    uint32_t checksum = 0;
+                    if (!AP::FS().crc32((char *)request.data, checksum)) {
                         ftp_error(reply, FTP_ERROR::FailErrno);
                         break;
                     }
+
+                    // reset our scratch area so we don't leak data, and can leverage trimming
+                    memset(reply.data, 0, sizeof(reply.data));
+                    reply.size = sizeof(uint32_t);
+                    put_le32_ptr(reply.data, checksum);
                     reply.opcode = FTP_OP::Ack;
                     break;
                 }
+            case FTP_OP::BurstReadFile:
+                {
+                    const uint8_t max_read = (request.size == 0?sizeof(reply.data):request.size);
+                    // must actually be working on a file
+                    if (session == nullptr) {
+                        ftp_error(reply, FTP_ERROR::FileNotFound);
+                        break;
+                    }
+
+                    // must have the file in read mode
+                    if ((session->mode != FTP_FILE_MODE::Read)) {
+                        ftp_error(reply, FTP_ERROR::Fail);
+                        break;
+                    }
+
+                    /*
+                      calculate a burst delay so that FTP burst
+                      transfer doesn't use more than 1/3 of
+                      available bandwidth on links that don't have
+                      flow control. This reduces the chance of
+                      lost packets a lot, which results in overall
+                      faster transfers
+                     */
+                    uint32_t burst_delay_ms = 0;
+                    if (valid_channel(request.chan)) {
+                        auto *port = mavlink_comm_port[request.chan];
+                        if (port != nullptr && port->get_flow_control() != AP_HAL::UARTDriver::FLOW_CONTROL_ENABLE) {
+                            const uint32_t bw = port->bw_in_bytes_per_second();
+                            const uint16_t pkt_size = PAYLOAD_SIZE(request.chan, FILE_TRANSFER_PROTOCOL) - (sizeof(reply.data) - max_read);
+                            burst_delay_ms = 3000 * pkt_size / bw;
+                        }
+                    }
 
-                case FTP_OP::TruncateFile:
-                default:
-                    // this was bad data, just nack it
-                    GCS_SEND_TEXT(MAV_SEVERITY_DEBUG, "Unsupported FTP: %d", static_cast<int>(request.opcode));
-                    ftp_error(reply, FTP_ERROR::Fail);
+                    // the packets are sent by ftp_send_bursts(), a
+                    // new burst replacing any still in progress.
+                    // This transfer size is enough for a full
+                    // parameter file with max parameters
+                    session->burst.offset = request.offset;
+                    session->burst.remaining = 500;
+                    session->burst.seq_number = reply.seq_number;
+                    session->burst.max_read = max_read;
+                    session->burst.delay_ms = burst_delay_ms;
+                    session->burst.last_send_ms = now - burst_delay_ms;
+
+                    // prevent a duplicate packet send for
+                    // normal replies of burst reads, and have a
+                    // repeat of this request restart the burst
+                    skip_push_reply = true;
+                    reply.session = -1;
                     break;
+                }
+
+            case FTP_OP::Rename: {
+                // sanity check that the request looks well formed
+                const char *filename1 = (char*)request.data;
+                const size_t len1 = strnlen(filename1, sizeof(request.data)-2);
+                const char *filename2 = (char*)&request.data[len1+1];
+                const size_t len2 = strnlen(filename2, sizeof(request.data)-(len1+1));
+                if (filename1[len1] != 0 || (len1+len2+1 != request.size) || (request.size == 0)) {
+                    ftp_error(reply, FTP_ERROR::InvalidDataSize);
+                    break;
+                }
+                request.data[sizeof(request.data) - 1] = 0; // ensure the 2nd path is null terminated
+                // remove the file/dir
+                if (AP::FS().rename(filename1, filename2) != 0) {
+                    ftp_error(reply, FTP_ERROR::FailErrno);
+                    break;
+                }
+                reply.opcode = FTP_OP::Ack;
+                break;
             }
+
+            case FTP_OP::TruncateFile:
+            default:
+                // this was bad data, just nack it
+                GCS_SEND_TEXT(MAV_SEVERITY_DEBUG, "Unsupported FTP: %d", static_cast<int>(request.opcode));
+                ftp_error(reply, FTP_ERROR::Fail);
+                break;
+        }
+
+        if (session != nullptr) {
+            session->last_use_ms = AP_HAL::millis();
         }
 
         if (!skip_push_reply) {
@@ -71,6 +71,9 @@ mavlink_status_t* mavlink_get_channel_status(uint8_t chan) {
 
 AP_HAL::UARTDriver	*mavlink_comm_port[MAVLINK_COMM_NUM_BUFFERS];
 bool gcs_alternative_active[MAVLINK_COMM_NUM_BUFFERS];
+#if AP_MAVLINK_STREAM_BUDGET_ENABLED
+uint32_t mavlink_comm_tx_bytes[MAVLINK_COMM_NUM_BUFFERS];
+#endif
 
 // per-channel lock
 static HAL_Semaphore chan_locks[MAVLINK_COMM_NUM_BUFFERS];
@@ -128,32 +131,35 @@ uint16_t comm_get_txspace(mavlink_channel_t chan)
 }
 
 /*
-  send a buffer out a MAVLink channel
+  send a buffer out a MAVLink channel, returning the number of bytes
+  written
  */
-void comm_send_buffer(mavlink_channel_t chan, const uint8_t *buf, uint8_t len)
+uint16_t comm_send_buffer(mavlink_channel_t chan, const uint8_t *buf, uint16_t len)
 {
     if (!valid_channel(chan) || mavlink_comm_port[chan] == nullptr || chan_discard[chan]) {
-        return;
+        return 0;
     }
 #if HAL_HIGH_LATENCY2_ENABLED
     // if it's a disabled high latency channel, don't send
     GCS_MAVLINK *link = gcs().chan(chan);
     if (link->is_high_latency_link && !gcs().get_high_latency_status()) {
-        return;
+        return 0;
     }
 #endif
     if (gcs_alternative_active[chan]) {
         // an alternative protocol is active
-        return;
+        return 0;
     }
     const size_t written = mavlink_comm_port[chan]->write(buf, len);
+#if AP_MAVLINK_STREAM_BUDGET_ENABLED
+    mavlink_comm_tx_bytes[chan] += written;
+#endif
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
     if (written < len && !mavlink_comm_port[chan]->is_write_locked()) {
         AP_HAL::panic("Short write on UART: %lu < %u", (unsigned long)written, len);
     }
-#else
-    (void)written;
 #endif
+    return written;
 }
 
 /*
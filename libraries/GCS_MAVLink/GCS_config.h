@@ -46,6 +46,12 @@
 #define HAL_MAVLINK_INTERVALS_FROM_FILES_ENABLED ((AP_FILESYSTEM_FATFS_ENABLED || AP_FILESYSTEM_LITTLEFS_ENABLED || AP_FILESYSTEM_POSIX_ENABLED) && BOARD_FLASH_SIZE > 1024)
 #endif
 
+// share the measured link bandwidth between the stream buckets by
+// message priority, slowing the least important streams first
+#ifndef AP_MAVLINK_STREAM_BUDGET_ENABLED
+#define AP_MAVLINK_STREAM_BUDGET_ENABLED HAL_GCS_ENABLED && BOARD_FLASH_SIZE > 1024
+#endif
+
 #ifndef AP_MAVLINK_MSG_RELAY_STATUS_ENABLED
 #define AP_MAVLINK_MSG_RELAY_STATUS_ENABLED HAL_GCS_ENABLED && AP_RELAY_ENABLED
 #endif
@@ -84,6 +90,31 @@
 #define AP_MAVLINK_FTP_ENABLED HAL_GCS_ENABLED
 #endif
 
+// number of files which can be open over MAVLink FTP at once, across
+// all links
+#ifndef AP_MAVLINK_FTP_MAX_SESSIONS
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#define AP_MAVLINK_FTP_MAX_SESSIONS 4
+#elif BOARD_FLASH_SIZE > 1024
+#define AP_MAVLINK_FTP_MAX_SESSIONS 2
+#else
+#define AP_MAVLINK_FTP_MAX_SESSIONS 1
+#endif
+#endif
+
+// size of the buffer each open FTP session reads files through, so the
+// filesystem sees large sequential reads rather than one read per
+// packet. Zero disables read-ahead
+#ifndef AP_MAVLINK_FTP_READAHEAD_SIZE
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#define AP_MAVLINK_FTP_READAHEAD_SIZE 65536
+#elif BOARD_FLASH_SIZE > 1024
+#define AP_MAVLINK_FTP_READAHEAD_SIZE 4096
+#else
+#define AP_MAVLINK_FTP_READAHEAD_SIZE 0
+#endif
+#endif
+
 // GCS should be using MISSION_REQUEST_INT instead; this is a waste of
 // flash.  MISSION_REQUEST was deprecated in June 2020.  We started
 // sending warnings to the GCS in Sep 2022 if this command was used.
@@ -171,10 +171,13 @@ bool MAVLink_routing::check_and_forward(GCS_MAVLINK &in_link, const mavlink_mess
         return true;
     }
 
-    // forward on any channels matching the targets
+    // forward on any channels matching the targets. The message is
+    // framed once, on the first channel it goes to
     bool forwarded = false;
     bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS];
     memset(sent_to_chan, 0, sizeof(sent_to_chan));
+    uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+    uint16_t frame_len = 0;
     for (uint8_t i=0; i<num_routes; i++) {
 
         // Skip if channel is private and the target system or component IDs do not match
@@ -204,7 +207,17 @@ bool MAVLink_routing::check_and_forward(GCS_MAVLINK &in_link, const mavlink_mess
                              (int)target_system,
                              (int)target_component);
 #endif
-                    _mavlink_resend_uart(routes[i].channel, &msg);
+                    if (frame_len == 0) {
+                        frame_len = frame_message(msg, frame);
+                    }
+                    // the frame is dropped if the channel has no space for it
+                    if (forward_frame(routes[i].channel, frame, frame_len)) {
+                        routes[i].fwd_bytes += frame_len;
+                    } else {
+                        routes[i].fwd_drops++;
+                    }
+                } else {
+                    routes[i].fwd_drops++;
                 }
                 sent_to_chan[routes[i].channel] = true;
                 forwarded = true;
@@ -317,7 +330,6 @@ bool MAVLink_routing::find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid
 */
 void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t &msg)
 {
-    uint8_t i;
     if (msg.sysid == 0) {
         // don't learn routes to the broadcast system
         return;
@@ -335,23 +347,26 @@ void MAVLink_routing::learn_route(GCS_MAVLINK &in_link, const mavlink_message_t
         return;
     }
     const mavlink_channel_t in_channel = in_link.get_chan();
-    for (i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg.sysid &&
-            routes[i].compid == msg.compid &&
-            routes[i].channel == in_channel) {
-            if (routes[i].mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
-            }
-            break;
+    const int8_t r = find_route(msg.sysid, msg.compid, in_channel);
+    if (r >= 0) {
+        if (routes[r].mavtype == 0 && msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+            routes[r].mavtype = mavlink_msg_heartbeat_get_type(&msg);
         }
+        return;
     }
-    if (i == num_routes && i<MAVLINK_MAX_ROUTES) {
+    if (num_routes < MAVLINK_MAX_ROUTES) {
+        const uint8_t i = num_routes;
         routes[i].sysid = msg.sysid;
         routes[i].compid = msg.compid;
         routes[i].channel = in_channel;
         if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
             routes[i].mavtype = mavlink_msg_heartbeat_get_type(&msg);
         }
+        uint8_t slot = route_hash_slot(msg.sysid, msg.compid, in_channel);
+        while (route_hash[slot] != 0) {
+            slot = (slot + 1) & (ROUTE_HASH_SIZE-1);
+        }
+        route_hash[slot] = i + 1;
         num_routes++;
 #if ROUTING_DEBUG
         ::printf("learned route %u %u via %u\n",
@@ -394,6 +409,8 @@ void MAVLink_routing::handle_heartbeat(GCS_MAVLINK &link, const mavlink_message_
     }
 
     // send on the remaining channels
+    uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+    uint16_t frame_len = 0;
     for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
         if (mask & (1U<<i)) {
             mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
@@ -406,13 +423,108 @@ void MAVLink_routing::handle_heartbeat(GCS_MAVLINK &link, const mavlink_message_
                          (unsigned)msg.sysid,
                          (unsigned)msg.compid);
 #endif
-                _mavlink_resend_uart(channel, &msg);
+                if (frame_len == 0) {
+                    frame_len = frame_message(msg, frame);
+                }
+                forward_frame(channel, frame, frame_len);
             }
         }
     }
 }
 
 
+/*
+  return the first slot to probe in route_hash for a route
+*/
+uint8_t MAVLink_routing::route_hash_slot(uint8_t sysid, uint8_t compid, mavlink_channel_t channel)
+{
+    return ((sysid * 131U) ^ (compid * 37U) ^ (uint8_t(channel) * 7U)) & (ROUTE_HASH_SIZE-1);
+}
+
+/*
+  return the index in routes[] of a route, or -1 if not known
+*/
+int8_t MAVLink_routing::find_route(uint8_t sysid, uint8_t compid, mavlink_channel_t channel) const
+{
+    uint8_t slot = route_hash_slot(sysid, compid, channel);
+    for (uint8_t n=0; n<ROUTE_HASH_SIZE; n++) {
+        const uint8_t idx = route_hash[slot];
+        if (idx == 0) {
+            return -1;
+        }
+        const route &r = routes[idx-1];
+        if (r.sysid == sysid && r.compid == compid && r.channel == channel) {
+            return idx-1;
+        }
+        slot = (slot + 1) & (ROUTE_HASH_SIZE-1);
+    }
+    return -1;
+}
+
+/*
+  serialise a received message into buf, which must hold
+  MAVLINK_MAX_PACKET_LEN bytes. This gives the same bytes as
+  _mavlink_resend_uart(), keeping the original sequence number,
+  checksum and signature. Returns the frame length
+*/
+uint16_t MAVLink_routing::frame_message(const mavlink_message_t &msg, uint8_t *buf)
+{
+    uint16_t n = 0;
+    buf[n++] = msg.magic;
+    buf[n++] = msg.len;
+    if (msg.magic == MAVLINK_STX_MAVLINK1) {
+        buf[n++] = msg.seq;
+        buf[n++] = msg.sysid;
+        buf[n++] = msg.compid;
+        buf[n++] = msg.msgid & 0xFF;
+    } else {
+        buf[n++] = msg.incompat_flags;
+        buf[n++] = msg.compat_flags;
+        buf[n++] = msg.seq;
+        buf[n++] = msg.sysid;
+        buf[n++] = msg.compid;
+        buf[n++] = msg.msgid & 0xFF;
+        buf[n++] = (msg.msgid >> 8) & 0xFF;
+        buf[n++] = (msg.msgid >> 16) & 0xFF;
+    }
+    memcpy(&buf[n], _MAV_PAYLOAD(&msg), msg.len);
+    n += msg.len;
+    buf[n++] = msg.checksum & 0xFF;
+    buf[n++] = msg.checksum >> 8;
+    if (msg.magic != MAVLINK_STX_MAVLINK1 &&
+        (msg.incompat_flags & MAVLINK_IFLAG_SIGNED)) {
+        memcpy(&buf[n], msg.signature, MAVLINK_SIGNATURE_BLOCK_LEN);
+        n += MAVLINK_SIGNATURE_BLOCK_LEN;
+    }
+    return n;
+}
+
+/*
+  write a frame to a channel with a single write to the port, returning
+  false if it was not all written
+*/
+bool MAVLink_routing::forward_frame(mavlink_channel_t channel, const uint8_t *frame, uint16_t len)
+{
+    comm_send_lock(channel, len);
+    const bool sent = comm_send_buffer(channel, frame, len) == len;
+    comm_send_unlock(channel);
+    return sent;
+}
+
+/*
+  report the learned routes for @SYS/routes.txt
+*/
+void MAVLink_routing::routing_info(ExpandingString &str) const
+{
+    str.printf("RoutesV1\n");
+    for (uint8_t i=0; i<num_routes; i++) {
+        const route &r = routes[i];
+        str.printf("sysid=%-3u compid=%-3u chan=%u type=%-3u fwd_bytes=%lu drops=%lu\n",
+                   unsigned(r.sysid), unsigned(r.compid), unsigned(r.channel), unsigned(r.mavtype),
+                   (unsigned long)r.fwd_bytes, (unsigned long)r.fwd_drops);
+    }
+}
+
 /*
   extract target sysid and compid from a message. int16_t is used so
   that the caller can set them to -1 and know when a sysid or compid
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <AP_Common/AP_Common.h>
+#include <AP_Common/ExpandingString.h>
 #include "GCS_MAVLink.h"
 
 // 20 routes should be enough for now. This may need to increase as
@@ -49,16 +50,43 @@ public:
      */
     bool find_by_mavtype_and_compid(uint8_t mavtype, uint8_t compid, uint8_t &sysid, mavlink_channel_t &channel) const;
 
+    // report the learned routes and their forwarding counters
+    void routing_info(ExpandingString &str) const;
+
 private:
-    // a simple linear routing table. We don't expect to have a lot of
-    // routes, so a scalable structure isn't worthwhile yet.
+    // the routing table. Routes are never removed, so a route's
+    // index is stable
     uint8_t num_routes;
     struct route {
         uint8_t sysid;
         uint8_t compid;
         mavlink_channel_t channel;
         uint8_t mavtype;
+        // traffic forwarded to this route, and messages not forwarded
+        // for lack of space on the channel
+        uint32_t fwd_bytes;
+        uint32_t fwd_drops;
     } routes[MAVLINK_MAX_ROUTES];
+
+    /*
+      open addressed hash of routes[] by sysid, compid and channel,
+      used to find the route of every incoming message. Each slot
+      holds a route index plus one, or zero when empty. It is never
+      full as it has more slots than routes
+     */
+    static constexpr uint8_t ROUTE_HASH_SIZE = 32;
+    static_assert(ROUTE_HASH_SIZE > MAVLINK_MAX_ROUTES, "route hash must have more slots than routes");
+    static_assert((ROUTE_HASH_SIZE & (ROUTE_HASH_SIZE-1)) == 0, "route hash size must be a power of 2");
+    uint8_t route_hash[ROUTE_HASH_SIZE] {};
+    static uint8_t route_hash_slot(uint8_t sysid, uint8_t compid, mavlink_channel_t channel);
+    int8_t find_route(uint8_t sysid, uint8_t compid, mavlink_channel_t channel) const;
+
+    // serialise a received message back into the bytes it arrived
+    // as, so it can be forwarded on any number of channels unchanged
+    static uint16_t frame_message(const mavlink_message_t &msg, uint8_t *buf);
+
+    // write a whole frame to a channel in one go, false if it was dropped
+    static bool forward_frame(mavlink_channel_t channel, const uint8_t *frame, uint16_t len);
     
     // a channel mask to block routing as required
     uint8_t no_route_mask;